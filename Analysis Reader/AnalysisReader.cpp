@@ -0,0 +1,111 @@
+/*
+**                 Analysis Reader v1.0
+**
+**   This tool converts the binary analysis file written by TFM or TDeint
+**   (analysis parameter) into comma separated text, one line per frame.
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/*
+** USAGE INFORMATION -
+**
+** SYNTAX:  analysisreader analysis.bin [sorted] >outfile.csv
+**
+** PARAMETERS:  analysis.bin = File written with TFM(analysis="...") or TDeint(analysis="...").
+**              sorted       = Optional. Records are stored in request order, so seeking
+**                             or a second pass over a frame gives several records for it.
+**                             With "sorted" the output is ordered by frame and only the
+**                             last record of each frame is kept.
+**
+** The record layout is in src/common/analysisout.h, -1 means not computed.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "../src/common/analysisout.h"
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2 || argc > 3 || (argc == 3 && strcmp(argv[2], "sorted") != 0))
+  {
+    printf("Error:  incorrect arguments!\n");
+    printf("Syntax:  analysisreader analysis.bin [sorted] >outputfile.csv\n");
+    printf("Info:  see the source file for further information.\n");
+    printf("Quitting....\n");
+    return 1;
+  }
+  FILE *inFile = fopen(argv[1], "rb");
+  if (inFile == NULL)
+  {
+    printf("Error:  unable to open analysis file (%s)!\n", argv[1]);
+    printf("Quitting...\n");
+    return 2;
+  }
+  AnalysisFileHeader header;
+  if (fread(&header, sizeof(header), 1, inFile) != 1 ||
+    memcmp(header.magic, ANALYSIS_MAGIC, sizeof(header.magic)) != 0 ||
+    header.version != ANALYSIS_VERSION || header.record_size != sizeof(AnalysisRecord))
+  {
+    fclose(inFile);
+    printf("Error:  analysis file is of unsupported format!\n");
+    printf("Quitting...\n");
+    return 3;
+  }
+  // read bytes rather than records, so a record cut off at the end of the file is noticed
+  std::vector<AnalysisRecord> records;
+  AnalysisRecord block[4096];
+  size_t have = 0, count;
+  while ((count = fread((unsigned char *)block + have, 1, sizeof(block) - have, inFile)) > 0)
+  {
+    have += count;
+    const size_t whole = have / sizeof(AnalysisRecord);
+    records.insert(records.end(), block, block + whole);
+    have -= whole * sizeof(AnalysisRecord);
+    memmove(block, block + whole, have);
+  }
+  fclose(inFile);
+  if (have > 0)
+    fprintf(stderr, "Warning:  analysis file ends within a record (%d trailing bytes ignored), "
+      "it was not completely written!\n", (int)have);
+
+  if (argc == 3)
+  {
+    // stable: among records of the same frame the last written stays last
+    std::stable_sort(records.begin(), records.end(), [](const AnalysisRecord &a, const AnalysisRecord &b) {
+      return a.filter != b.filter ? a.filter < b.filter : a.frame < b.frame;
+    });
+    std::vector<AnalysisRecord> last;
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+      if (i + 1 < records.size() && records[i + 1].filter == records[i].filter &&
+        records[i + 1].frame == records[i].frame) continue;
+      last.push_back(records[i]);
+    }
+    records.swap(last);
+  }
+
+  printf("filter,frame,field,match,combed,mic0,mic1,mic2,mic3,mic4,count0,count1,count2,count3\n");
+  for (const AnalysisRecord &r : records)
+  {
+    printf("%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+      r.filter == ANALYSIS_TFM ? "tfm" : "tdeint", r.frame, r.field, r.match, r.combed,
+      r.mics[0], r.mics[1], r.mics[2], r.mics[3], r.mics[4],
+      r.counts[0], r.counts[1], r.counts[2], r.counts[3]);
+  }
+  return 0;
+}
@@ -27,6 +27,7 @@
 #include "TCommonASM.h"
 #include "TDeintASM.h"
 #include "emmintrin.h"
+#include <cstring>
 
 // HBD ready inside
 void TDeinterlace::absDiff(PVideoFrame &src1, PVideoFrame &src2, PVideoFrame &dst, int pos, IScriptEnvironment *env)
@@ -120,7 +121,289 @@ void TDeinterlace::buildDiffMapPlaneYUY2(const uint8_t *prvp, const uint8_t *nxt
   const bool mChroma = !YUY2_LumaOnly; // in TFM it's a real parameter
 
   do_buildABSDiffMask<uint8_t>(prvp, nxtp, tbuffer, prv_pitch, nxt_pitch, tpitch, Width, Height >> 1, YUY2_LumaOnly, cpuFlags);
-  AnalyzeDiffMask_YUY2(dstp, dst_pitch, tbuffer, tpitch, Width, Height, mChroma);
+  AnalyzeDiffMask_YUY2(dstp, dst_pitch, tbuffer, tpitch, Width, Height, mChroma, cpuFlags);
 
 }
 
+
+// Builds the tile occupancy map of the final (planar) motion mask.
+// A tile is weave-only when each of its rows holds one of the plain copy values
+// 10 (src), 20 (prv) or 30 (nxt) across the whole tile width.
+void TDeinterlace::buildMaskTiles(PVideoFrame &mask)
+{
+  const bool use_sse2 = cpuFlags & CPUF_SSE2;
+
+  const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
+  const int np = vi.IsY() ? 1 : 3;
+  for (int b = 0; b < np; ++b)
+  {
+    const int plane = planes[b];
+    const uint8_t *maskp = mask->GetReadPtr(plane);
+    const int mask_pitch = mask->GetPitch(plane);
+    const int Width = mask->GetRowSize(plane);
+    const int Height = mask->GetHeight(plane);
+    const int tilesX = (Width + MTILE_W - 1) / MTILE_W;
+    const int tilesY = (Height + MTILE_H - 1) / MTILE_H;
+    maskTilesX[b] = tilesX;
+    maskTiles[b].assign(tilesX * tilesY, 1);
+    for (int y = 0; y < Height; ++y)
+    {
+      uint8_t *trow = maskTiles[b].data() + (y / MTILE_H) * tilesX;
+      for (int tx = 0; tx < tilesX; ++tx)
+      {
+        if (!trow[tx])
+          continue;
+        const int x0 = tx * MTILE_W;
+        const uint8_t v = maskp[x0];
+        if (v != 10 && v != 20 && v != 30)
+        {
+          trow[tx] = 0;
+          continue;
+        }
+        const int w = std::min(MTILE_W, Width - x0);
+        if (use_sse2 && w == 16)
+        {
+          const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskp + x0)); // emask frames may be unaligned
+          if (_mm_movemask_epi8(_mm_cmpeq_epi8(m, _mm_set1_epi8(v))) != 0xFFFF)
+            trow[tx] = 0;
+        }
+        else
+        {
+          for (int x = 1; x < w; ++x)
+          {
+            if (maskp[x0 + x] != v)
+            {
+              trow[tx] = 0;
+              break;
+            }
+          }
+        }
+      }
+      maskp += mask_pitch;
+    }
+  }
+  maskTilesValid = true;
+}
+
+// Motion mask morphology on the 10/60 (0x3C) codes, one field row per call.
+// Each kernel does whole 16 byte (16 chroma sample) chunks and returns where
+// the caller's C loop has to continue.
+
+static AVS_FORCEINLINE __m128i mask_blend_3C(__m128i cond, __m128i v)
+{
+  return _mm_or_si128(_mm_and_si128(cond, _mm_set1_epi8(0x3C)), _mm_andnot_si128(cond, v));
+}
+
+// Horizontal dilation of the 60 pixels by dis, same result as the expandMap_Planar C loop.
+// tmp: width + 4 * dis + 48 bytes
+void expandMapRow_SSE2(uint8_t *maskp, int width, int dis, uint8_t *tmp)
+{
+  const __m128i Const3C = _mm_set1_epi8(0x3C);
+  const int len = width + 2 * dis; // moving flags, zero padded by dis on both sides
+  memset(tmp, 0, dis);
+  for (int x = 0; x < width; x += 16)
+  {
+    const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskp + x));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(tmp + dis + x), _mm_cmpeq_epi8(m, Const3C));
+  }
+  memset(tmp + dis + width, 0, 3 * dis + 48);
+  // window of 2*dis+1 flags: OR over power of 2 windows, then two overlapping ones
+  const int win = 2 * dis + 1;
+  int p = 1;
+  for (; p * 2 <= win; p *= 2)
+  {
+    for (int i = 0; i < len; i += 16)
+    {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tmp + i));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tmp + i + p));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(tmp + i), _mm_or_si128(a, b));
+    }
+  }
+  const int off = win - p;
+  for (int x = 0; x < width; x += 16)
+  {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tmp + x));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tmp + x + off));
+    const __m128i cond = _mm_or_si128(a, b);
+    if (x + 16 <= width)
+    {
+      const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskp + x));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(maskp + x), mask_blend_3C(cond, m));
+    }
+    else
+    {
+      alignas(16) uint8_t c[16];
+      _mm_store_si128(reinterpret_cast<__m128i *>(c), cond);
+      for (int i = 0; x + i < width; ++i)
+        if (c[i]) maskp[x + i] = 0x3C;
+    }
+  }
+}
+
+// Isolated 60 pixels (no 60 in the 8 field neighbours) take a neighbour's code.
+// Starts at x = 1. A replaced pixel never has a 60 next to it, so updating the
+// row in place gives the same result as the denoisePlanar C loop.
+int denoiseMapRow_SSE2(uint8_t *maskp, const uint8_t *maskpp, const uint8_t *maskpn, int width)
+{
+  const __m128i Const3C = _mm_set1_epi8(0x3C);
+  int x = 1;
+  for (; x + 16 <= width - 1; x += 16)
+  {
+    const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskp + x));
+    const __m128i moving = _mm_cmpeq_epi8(p, Const3C);
+    if (_mm_movemask_epi8(moving) == 0)
+      continue;
+    const __m128i pl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskp + x - 1));
+    const __m128i pr = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskp + x + 1));
+    const __m128i pp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpp + x));
+    const __m128i pn = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpn + x));
+    __m128i nb = _mm_or_si128(_mm_cmpeq_epi8(pl, Const3C), _mm_cmpeq_epi8(pr, Const3C));
+    nb = _mm_or_si128(nb, _mm_cmpeq_epi8(pp, Const3C));
+    nb = _mm_or_si128(nb, _mm_cmpeq_epi8(pn, Const3C));
+    nb = _mm_or_si128(nb, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpp + x - 1)), Const3C));
+    nb = _mm_or_si128(nb, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpp + x + 1)), Const3C));
+    nb = _mm_or_si128(nb, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpn + x - 1)), Const3C));
+    nb = _mm_or_si128(nb, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpn + x + 1)), Const3C));
+    const __m128i isolated = _mm_andnot_si128(nb, moving);
+    if (_mm_movemask_epi8(isolated) == 0)
+      continue;
+    // (left == right) ? left : (up == down) ? up : left
+    const __m128i use_up = _mm_andnot_si128(_mm_cmpeq_epi8(pl, pr), _mm_cmpeq_epi8(pp, pn));
+    const __m128i repl = _mm_or_si128(_mm_and_si128(use_up, pp), _mm_andnot_si128(use_up, pl));
+    const __m128i res = _mm_or_si128(_mm_and_si128(isolated, repl), _mm_andnot_si128(isolated, p));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maskp + x), res);
+  }
+  return x;
+}
+
+// 16 chroma samples: luma samples of each one all 60
+template<int planarType>
+static AVS_FORCEINLINE __m128i link_luma_moving(const uint8_t *maskpY, const uint8_t *maskpnY, int x)
+{
+  if constexpr (planarType == 444) {
+    return _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpY + x)), _mm_set1_epi8(0x3C));
+  }
+  else if constexpr (planarType == 411) {
+    const __m128i Const3C = _mm_set1_epi8(0x3C);
+    const uint8_t *p = maskpY + x * 4;
+    const __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), Const3C);
+    const __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16)), Const3C);
+    const __m128i c = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32)), Const3C);
+    const __m128i d = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 48)), Const3C);
+    return _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+  }
+  else { // 420, 422
+    const __m128i Const3C = _mm_set1_epi8(0x3C);
+    const uint8_t *p = maskpY + x * 2;
+    __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), Const3C);
+    __m128i b = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16)), Const3C);
+    if constexpr (planarType == 420) {
+      const uint8_t *pn = maskpnY + x * 2;
+      a = _mm_and_si128(a, _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pn)), Const3C));
+      b = _mm_and_si128(b, _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pn + 16)), Const3C));
+    }
+    return _mm_packs_epi16(a, b);
+  }
+}
+
+// set the luma samples of 16 chroma samples to 60 where cond
+template<int planarType>
+static AVS_FORCEINLINE void link_luma_fill(uint8_t *maskpY, uint8_t *maskpnY, int x, __m128i cond)
+{
+  if constexpr (planarType == 444) {
+    __m128i *p = reinterpret_cast<__m128i *>(maskpY + x);
+    _mm_storeu_si128(p, mask_blend_3C(cond, _mm_loadu_si128(p)));
+  }
+  else if constexpr (planarType == 411) {
+    const __m128i lo = _mm_unpacklo_epi8(cond, cond);
+    const __m128i hi = _mm_unpackhi_epi8(cond, cond);
+    const __m128i c[4] = { _mm_unpacklo_epi16(lo, lo), _mm_unpackhi_epi16(lo, lo), _mm_unpacklo_epi16(hi, hi), _mm_unpackhi_epi16(hi, hi) };
+    for (int i = 0; i < 4; ++i) {
+      __m128i *p = reinterpret_cast<__m128i *>(maskpY + x * 4 + i * 16);
+      _mm_storeu_si128(p, mask_blend_3C(c[i], _mm_loadu_si128(p)));
+    }
+  }
+  else { // 420, 422
+    const __m128i c[2] = { _mm_unpacklo_epi8(cond, cond), _mm_unpackhi_epi8(cond, cond) };
+    for (int i = 0; i < 2; ++i) {
+      __m128i *p = reinterpret_cast<__m128i *>(maskpY + x * 2 + i * 16);
+      _mm_storeu_si128(p, mask_blend_3C(c[i], _mm_loadu_si128(p)));
+      if constexpr (planarType == 420) {
+        __m128i *pn = reinterpret_cast<__m128i *>(maskpnY + x * 2 + i * 16);
+        _mm_storeu_si128(pn, mask_blend_3C(c[i], _mm_loadu_si128(pn)));
+      }
+    }
+  }
+}
+
+// link = 1: all luma of a chroma sample moving, or U or V moving -> all moving.
+// maskpnY: second luma row of 420, unused otherwise
+template<int planarType>
+int linkFULLRow_SSE2(uint8_t *maskpY, uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV)
+{
+  const __m128i Const3C = _mm_set1_epi8(0x3C);
+  int x = 0;
+  for (; x + 16 <= widthUV; x += 16)
+  {
+    const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpU + x));
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpV + x));
+    __m128i cond = _mm_or_si128(_mm_cmpeq_epi8(u, Const3C), _mm_cmpeq_epi8(v, Const3C));
+    cond = _mm_or_si128(cond, link_luma_moving<planarType>(maskpY, maskpnY, x));
+    if (_mm_movemask_epi8(cond) == 0)
+      continue;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maskpU + x), mask_blend_3C(cond, u));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maskpV + x), mask_blend_3C(cond, v));
+    link_luma_fill<planarType>(maskpY, maskpnY, x, cond);
+  }
+  return x;
+}
+
+// link = 2: all luma of a chroma sample moving -> U and V moving
+template<int planarType>
+int linkYtoUVRow_SSE2(const uint8_t *maskpY, const uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV)
+{
+  int x = 0;
+  for (; x + 16 <= widthUV; x += 16)
+  {
+    const __m128i cond = link_luma_moving<planarType>(maskpY, maskpnY, x);
+    if (_mm_movemask_epi8(cond) == 0)
+      continue;
+    __m128i *u = reinterpret_cast<__m128i *>(maskpU + x);
+    __m128i *v = reinterpret_cast<__m128i *>(maskpV + x);
+    _mm_storeu_si128(u, mask_blend_3C(cond, _mm_loadu_si128(u)));
+    _mm_storeu_si128(v, mask_blend_3C(cond, _mm_loadu_si128(v)));
+  }
+  return x;
+}
+
+// link = 3: U or V moving -> its luma samples moving
+template<int planarType>
+int linkUVtoYRow_SSE2(uint8_t *maskpY, uint8_t *maskpnY, const uint8_t *maskpU, const uint8_t *maskpV, int widthUV)
+{
+  const __m128i Const3C = _mm_set1_epi8(0x3C);
+  int x = 0;
+  for (; x + 16 <= widthUV; x += 16)
+  {
+    const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpU + x));
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(maskpV + x));
+    const __m128i cond = _mm_or_si128(_mm_cmpeq_epi8(u, Const3C), _mm_cmpeq_epi8(v, Const3C));
+    if (_mm_movemask_epi8(cond) == 0)
+      continue;
+    link_luma_fill<planarType>(maskpY, maskpnY, x, cond);
+  }
+  return x;
+}
+
+// instantiate
+template int linkFULLRow_SSE2<420>(uint8_t *maskpY, uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkFULLRow_SSE2<422>(uint8_t *maskpY, uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkFULLRow_SSE2<444>(uint8_t *maskpY, uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkFULLRow_SSE2<411>(uint8_t *maskpY, uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkYtoUVRow_SSE2<420>(const uint8_t *maskpY, const uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkYtoUVRow_SSE2<422>(const uint8_t *maskpY, const uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkYtoUVRow_SSE2<444>(const uint8_t *maskpY, const uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkYtoUVRow_SSE2<411>(const uint8_t *maskpY, const uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template int linkUVtoYRow_SSE2<420>(uint8_t *maskpY, uint8_t *maskpnY, const uint8_t *maskpU, const uint8_t *maskpV, int widthUV);
+template int linkUVtoYRow_SSE2<422>(uint8_t *maskpY, uint8_t *maskpnY, const uint8_t *maskpU, const uint8_t *maskpV, int widthUV);
+template int linkUVtoYRow_SSE2<444>(uint8_t *maskpY, uint8_t *maskpnY, const uint8_t *maskpU, const uint8_t *maskpV, int widthUV);
+template int linkUVtoYRow_SSE2<411>(uint8_t *maskpY, uint8_t *maskpnY, const uint8_t *maskpU, const uint8_t *maskpV, int widthUV);
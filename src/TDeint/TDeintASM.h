@@ -30,5 +30,14 @@
 #include <emmintrin.h>
 #include "internal.h"
 
+// motion mask morphology, one field row, see TDeintASM.cpp
+void expandMapRow_SSE2(uint8_t *maskp, int width, int dis, uint8_t *tmp);
+int denoiseMapRow_SSE2(uint8_t *maskp, const uint8_t *maskpp, const uint8_t *maskpn, int width);
+template<int planarType>
+int linkFULLRow_SSE2(uint8_t *maskpY, uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template<int planarType>
+int linkYtoUVRow_SSE2(const uint8_t *maskpY, const uint8_t *maskpnY, uint8_t *maskpU, uint8_t *maskpV, int widthUV);
+template<int planarType>
+int linkUVtoYRow_SSE2(uint8_t *maskpY, uint8_t *maskpnY, const uint8_t *maskpU, const uint8_t *maskpV, int widthUV);
 
 #endif // __TDEINTASM_H__
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include "TDeinterlace.h"
 #include "avs/alignment.h"
+#include "hintprop.h"
 
 PVideoFrame __stdcall TDeinterlace::GetFrame(int n, IScriptEnvironment* env)
 {
@@ -34,34 +35,28 @@ PVideoFrame __stdcall TDeinterlace::GetFrame(int n, IScriptEnvironment* env)
   else if (mode == 1 && n > nfrms2) n = nfrms2;
   PVideoFrame dst;
   bool wdtd = false;
+  arec = emptyAnalysisRecord(ANALYSIS_TDEINT, n);
   
   if (vi.IsPlanar()) 
     dst = GetFramePlanar(n, env, wdtd);
   else 
     dst = GetFrameYUY2(n, env, wdtd);
 
+  if (analysisOut.enabled())
+  {
+    arec.combed = wdtd ? 1 : 0;
+    analysisOut.write(arec);
+  }
+
   if (tshints && map != 1 && map != 2)
   {
     env->MakeWritable(&dst);
+    if (has_at_least_v8) clearPropHint(dst, env);
     putHint2(vi, dst, wdtd);
   }
   return dst;
 }
 
-void TDeinterlace::insertCompStats(int n, int norm1, int norm2, int mtn1, int mtn2)
-{
-  if (sa.size() > 0)
-  {
-    int pos = sa_pos * 5;
-    sa[pos + 0] = n;
-    sa[pos + 1] = norm1;
-    sa[pos + 2] = norm2;
-    sa[pos + 3] = mtn1;
-    sa[pos + 4] = mtn2;
-    sa_pos = (sa_pos + 1) % 500;
-  }
-}
-
 int TDeinterlace::getMatch(int norm1, int norm2, int mtn1, int mtn2)
 {
   float c1 = float(std::max(norm1, norm2)) / float(std::max(std::min(norm1, norm2), 1));
@@ -115,31 +110,21 @@ int TDeinterlace::getMatch(int norm1, int norm2, int mtn1, int mtn2)
   }
 }
 
-int TDeinterlace::getHint(const VideoInfo& vi, PVideoFrame& src, unsigned int& storeHint, int& hintField)
-{
-  if (vi.ComponentSize() == 1)
-    return getHint_core<uint8_t>(src, storeHint, hintField);
-  else
-    return getHint_core<uint16_t>(src, storeHint, hintField);
-}
-
-template<typename pixel_t>
-int TDeinterlace::getHint_core(PVideoFrame &src, unsigned int &storeHint, int &hintField)
+// env is only given on v8 interfaces: a TIVTC frame property hint (frames TFM
+// passed through by reference) is checked before the pixels then
+int TDeinterlace::getHint(const VideoInfo& vi, PVideoFrame& src, unsigned int& storeHint, int& hintField, IScriptEnvironment* env)
 {
   hintField = -1;
-  const pixel_t *p = reinterpret_cast<const pixel_t *>(src->GetReadPtr(PLANAR_Y));
-  unsigned int i, magic_number = 0, hint = 0;
   storeHint = 0xFFFFFFFF;
-  for (i = 0; i < 32; ++i)
-  {
-    magic_number |= ((*p++ & 1) << i);
-  }
+  unsigned int magic_number = 0, hint = 0;
+  if (env && getPropHint(src, hint, env))
+    magic_number = 0xdeadfeed;
+  else if (vi.ComponentSize() == 1)
+    getHint_core<uint8_t>(src, magic_number, hint);
+  else
+    getHint_core<uint16_t>(src, magic_number, hint);
   if (magic_number != 0xdeadbeef &&
     magic_number != 0xdeadfeed) return -1;
-  for (i = 0; i < 32; ++i)
-  {
-    hint |= ((*p++ & 1) << i);
-  }
   if (hint & 0xFFFF0000) return -1;
   storeHint = hint;
   if (magic_number == 0xdeadbeef)
@@ -154,6 +139,23 @@ int TDeinterlace::getHint_core(PVideoFrame &src, unsigned int &storeHint, int &h
   return 0;
 }
 
+template<typename pixel_t>
+void TDeinterlace::getHint_core(PVideoFrame &src, unsigned int &magic_number, unsigned int &hint)
+{
+  const pixel_t *p = reinterpret_cast<const pixel_t *>(src->GetReadPtr(PLANAR_Y));
+  unsigned int i;
+  for (i = 0; i < 32; ++i)
+  {
+    magic_number |= ((*p++ & 1) << i);
+  }
+  if (magic_number != 0xdeadbeef &&
+    magic_number != 0xdeadfeed) return;
+  for (i = 0; i < 32; ++i)
+  {
+    hint |= ((*p++ & 1) << i);
+  }
+}
+
 void TDeinterlace::putHint(const VideoInfo& vi, PVideoFrame& dst, unsigned int hint, int fieldt)
 {
   if (vi.NumComponents() == 1)
@@ -252,6 +254,95 @@ void TDeinterlace::InsertDiff(PVideoFrame &p1, PVideoFrame &p2, int n, int pos,
   db->fnum[pos] = n;
 }
 
+void TDeinterlace::InsertDiff(LazyFrame &p1, PVideoFrame &p2, int n, int pos, IScriptEnvironment *env)
+{
+  if (db->fnum[pos] == n) return;
+  InsertDiff(p1.get(env), p2, n, pos, env);
+}
+
+void TDeinterlace::InsertDiff(PVideoFrame &p1, LazyFrame &p2, int n, int pos, IScriptEnvironment *env)
+{
+  if (db->fnum[pos] == n) return;
+  InsertDiff(p1, p2.get(env), n, pos, env);
+}
+
+void ClipPrefetch::init(const PClip &c, int window, bool has_at_least_v8, IScriptEnvironment *env)
+{
+  clip = c;
+  last = c->GetVideoInfo().num_frames - 1;
+  // ParallelJob is on IScriptEnvironment2, which v8 (Avisynth+) environments implement
+  depth = has_at_least_v8 && env->GetEnvProperty(AEP_THREADPOOL_THREADS) > 0 ? window : 0;
+  if (depth == 0)
+    return;
+  // the window ahead of the latest request, plus its two predecessors still in use
+  slots = std::vector<Slot>(depth + 3);
+  for (auto &s : slots)
+    s.clip = c;
+}
+
+ClipPrefetch::~ClipPrefetch()
+{
+  for (auto &s : slots)
+  {
+    finish(s);
+    if (s.done) s.done->Destroy();
+  }
+}
+
+AVSValue ClipPrefetch::fetch(IScriptEnvironment2 *env, void *data)
+{
+  Slot *s = reinterpret_cast<Slot *>(data);
+  try { s->frame = s->clip->GetFrame(s->n, env); }
+  catch (...) { s->frame = nullptr; } // requested again, and thrown, by the caller
+  return AVSValue();
+}
+
+void ClipPrefetch::finish(Slot &s)
+{
+  if (!s.pending)
+    return;
+  s.done->Wait();
+  s.pending = false;
+}
+
+PVideoFrame ClipPrefetch::GetFrame(int n, IScriptEnvironment *env)
+{
+  if (depth == 0)
+    return clip->GetFrame(n, env);
+  const int size = (int)slots.size();
+  PVideoFrame frame;
+  Slot &s = slots[n % size];
+  if (s.n == n)
+  {
+    finish(s);
+    frame = s.frame;
+  }
+  if (!frame)
+    frame = clip->GetFrame(n, env);
+
+  // The ring holds ahead - size + 1 .. ahead. A request inside it (prv/src/nxt
+  // of the next output frame ask for frames behind ahead) keeps the window, only
+  // a seek out of it restarts the window at n.
+  if (n > ahead || n < ahead - size + 1)
+    ahead = n;
+  IScriptEnvironment2 *env2 = static_cast<IScriptEnvironment2 *>(env);
+  const int stop = std::min(n + depth, last);
+  while (ahead < stop)
+  {
+    Slot &t = slots[++ahead % size];
+    if (t.n == ahead)
+      continue; // still issued from before a restart
+    finish(t);
+    t.n = ahead;
+    t.frame = nullptr;
+    if (!t.done) t.done = env2->NewCompletion(1);
+    else t.done->Reset();
+    t.pending = true;
+    env2->ParallelJob(fetch, &t, t.done);
+  }
+  return frame;
+}
+
 void TDeinterlace::stackVertical(PVideoFrame &dst2, PVideoFrame &p1, PVideoFrame &p2, IScriptEnvironment *env)
 {
   // bit depth independent
@@ -274,7 +365,8 @@ TDeinterlace::TDeinterlace(PClip _child, int _mode, int _order, int _field, int
   int _mtnmode, bool _sharp, bool _hints, PClip _clip2, bool _full, int _cthresh,
   bool _chroma, int _MI, bool _tryWeave, int _link, bool _denoise, int _AP,
   int _blockx, int _blocky, int _APType, PClip _edeint, PClip _emask, int _metric,
-  int _expand, int _slow, PClip _emtn, bool _tshints, int _opt, IScriptEnvironment* env) :
+  int _expand, int _slow, PClip _emtn, bool _tshints, int _opt, int _prefetch,
+  const char* _analysis, IScriptEnvironment* env) :
   GenericVideoFilter(_child),
   mode(_mode), order(_order), field(_field), mthreshL(_mthreshL),
   mthreshC(_mthreshC), map(_map), ovr(_ovr), ovrDefault(_ovrDefault), type(_type),
@@ -282,7 +374,7 @@ TDeinterlace::TDeinterlace(PClip _child, int _mode, int _order, int _field, int
   cthresh(_cthresh), chroma(_chroma), MI(_MI), tryWeave(_tryWeave), link(_link),
   denoise(_denoise), AP(_AP), blockx(_blockx), blocky(_blocky), APType(_APType),
   edeint(_edeint), emask(_emask), metric(_metric), expand(_expand), slow(_slow),
-  emtn(_emtn), tshints(_tshints), opt(_opt)
+  emtn(_emtn), tshints(_tshints), opt(_opt), prefetch(_prefetch)
 {
 
   has_at_least_v8 = true;
@@ -298,14 +390,14 @@ TDeinterlace::TDeinterlace(PClip _child, int _mode, int _order, int _field, int
   cArray = NULL;
   tbuffer = NULL;
   db = NULL;
+  maskTilesValid = false;
   const int orig_mode = mode;
   if (mode == 2)
   {
     mode = 1;
     if (type == 2 || mtnmode > 1 || tryWeave)
     {
-      sa.resize(5 * 500);
-      for (int i = 0; i < 500; ++i) sa[i] = -1;
+      sa.enable();
     }
   }
   if (vi.IsRGB())
@@ -340,6 +432,8 @@ TDeinterlace::TDeinterlace(PClip _child, int _mode, int _order, int _field, int
     env->ThrowError("TDeint:  APType must be set to 0, 1, or 2!");
   if (opt < 0 || opt > 4)
     env->ThrowError("TDeint:  opt must be set to 0, 1, 2, 3, or 4!");
+  if (prefetch < 0 || prefetch > 16)
+    env->ThrowError("TDeint:  prefetch must be between 0 and 16!");
   if (metric != 0 && metric != 1)
     env->ThrowError("TDeint:  metric must be set to 0 or 1!");
   if (expand < 0)
@@ -409,9 +503,13 @@ TDeinterlace::TDeinterlace(PClip _child, int _mode, int _order, int _field, int
       env->ThrowError("TDeint:  number of frames in emtn clip doesn't match that of the input clip!");
     emtn->SetCacheHints(CACHE_GENERIC, 5);
   }
+  if (useClip2) clip2Pf.init(clip2, prefetch, has_at_least_v8, env);
+  if (edeint) edeintPf.init(edeint, prefetch, has_at_least_v8, env);
+  if (emtn) emtnPf.init(emtn, prefetch, has_at_least_v8, env);
+  if (*_analysis && !analysisOut.open(_analysis))
+    env->ThrowError("TDeint:  analysis file error (cannot create file)!");
 
   // like in FrameDiff
-  sa_pos = 0;
   blockx_half = blockx >> 1;
   blocky_half = blocky >> 1;
   blockx_shift = blockx == 4 ? 2 : blockx == 8 ? 3 : blockx == 16 ? 4 : blockx == 32 ? 5 :
@@ -760,6 +858,10 @@ TDeinterlace::TDeinterlace(PClip _child, int _mode, int _order, int _field, int
 
 TDeinterlace::~TDeinterlace()
 {
+  if (!analysisOut.close())
+  {
+    OutputDebugString("TDeint:  analysis file error (cannot write file)!\n");
+  }
   if (db) delete db;
   if (cArray != NULL) _aligned_free(cArray);
   if (tbuffer) _aligned_free(tbuffer);
@@ -804,7 +906,9 @@ AVSValue __cdecl Create_TDeinterlace(AVSValue args, void* user_data, IScriptEnvi
     {
       const VideoInfo& vi = args[0].AsClip()->GetVideoInfo();
       PVideoFrame frame = args[0].AsClip()->GetFrame(0, env);
-      if (TDeinterlace::getHint(vi, frame, temp, tfieldHint) != -1)
+      bool v8 = true;
+      try { env->CheckVersion(8); } catch (const AvisynthError&) { v8 = false; }
+      if (TDeinterlace::getHint(vi, frame, temp, tfieldHint, v8 ? env : nullptr) != -1)
         hints = true;
     }
   }
@@ -828,7 +932,7 @@ AVSValue __cdecl Create_TDeinterlace(AVSValue args, void* user_data, IScriptEnvi
     args[23].AsInt(blockx), args[24].AsInt(blocky), args[25].AsInt(APType),
     args[26].IsClip() ? args[26].AsClip() : NULL, args[27].IsClip() ? args[27].AsClip() : NULL,
     args[29].AsInt(0), args[30].AsInt(0), args[31].AsInt(1), args[32].IsClip() ? args[32].AsClip() : NULL,
-    args[33].AsBool(false), args[34].AsInt(4), env);
+    args[33].AsBool(false), args[34].AsInt(4), args[35].AsInt(0), args[36].AsString(""), env);
   AVSValue ret = tdptr;
   if (mode == 2)
   {
@@ -862,7 +966,7 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
   env->AddFunction("TDeint", "c[mode]i[order]i[field]i[mthreshL]i[mthreshC]i[map]i[ovr]s" \
     "[ovrDefault]i[type]i[debug]b[mtnmode]i[sharp]b[hints]b[clip2]c[full]b[cthresh]i" \
     "[chroma]b[MI]i[tryWeave]b[link]i[denoise]b[AP]i[blockx]i[blocky]i[APType]i[edeint]c" \
-    "[emask]c[blim]f[metric]i[expand]i[slow]i[emtn]c[tshints]b[opt]i", Create_TDeinterlace, 0);
+    "[emask]c[blim]f[metric]i[expand]i[slow]i[emtn]c[tshints]b[opt]i[prefetch]i[analysis]s", Create_TDeinterlace, 0);
   env->AddFunction("TSwitch", "c[c1]c[c2]c[debug]b", Create_TSwitch, 0);
   return 0;
 }
\ No newline at end of file
@@ -28,12 +28,15 @@
 #include <math.h>
 #include <malloc.h>
 #include "internal.h"
+#include "scratchframe.h"
+#include "analysisout.h"
 #define TDeint_included
 #ifndef TDHelper_included
 #include "THelper.h"
 #endif
 #include "TDBuf.h"
 #include "vector"
+#include <mutex>
 
 /*
 #define TDEINT_VERSION "v1.1"
@@ -48,11 +51,107 @@
 #define TDEINT_VERSION "v1.5"
 #define TDEINT_DATE "05/13/2020"
 
+// motion mask tile size, see TDeinterlace::buildMaskTiles
+#define MTILE_W 16
+#define MTILE_H 8
+
 void dispatch_smartELADeintPlanar(PVideoFrame& dst, PVideoFrame& mask, PVideoFrame& prv, PVideoFrame& src, PVideoFrame& nxt, const VideoInfo& vi);
 template<typename pixel_t, int bits_per_pixel>
 void smartELADeintPlanar(PVideoFrame& dst, PVideoFrame& mask, PVideoFrame& prv, PVideoFrame& src, PVideoFrame& nxt);
 void smartELADeintYUY2(PVideoFrame& dst, PVideoFrame& mask, PVideoFrame& prv, PVideoFrame& src, PVideoFrame& nxt);
 
+// Input frame that is requested from its clip on first use. prv2/nxt2 are only
+// read by the motion maps, and only when their diff is not in the TDBuf cache.
+class LazyFrame
+{
+  PClip clip;
+  int n = -1;
+  PVideoFrame frame;
+
+public:
+  void set(const PClip &c, int num)
+  {
+    clip = c;
+    n = num;
+    frame = nullptr;
+  }
+  PVideoFrame &get(IScriptEnvironment *env)
+  {
+    if (!frame) frame = clip->GetFrame(n, env);
+    return frame;
+  }
+};
+
+// Extra input clip (clip2, edeint, emtn) whose frames are requested ahead of
+// use on the Avisynth+ thread pool (prefetch=k). Access is assumed to move
+// forward: after frame n is asked for, n+1..n+k are issued unless they already
+// are. A frame that was not prefetched, or whose request failed, is fetched in
+// the calling thread as before. Off (plain GetFrame) when k is 0 or the host
+// has no thread pool.
+class ClipPrefetch
+{
+  struct Slot
+  {
+    PClip clip;
+    int n = -1;
+    PVideoFrame frame;
+    IJobCompletion *done = nullptr;
+    bool pending = false;
+  };
+
+  PClip clip;
+  int depth = 0;
+  int last = 0; // last frame of the clip
+  int ahead = -1; // requests are issued up to this frame
+  std::vector<Slot> slots;
+
+  static AVSValue fetch(IScriptEnvironment2 *env, void *data);
+  static void finish(Slot &s);
+
+public:
+  void init(const PClip &c, int window, bool has_at_least_v8, IScriptEnvironment *env);
+  PVideoFrame GetFrame(int n, IScriptEnvironment *env);
+  ~ClipPrefetch();
+};
+
+// Field difference stats of the frames TDeinterlace (mode=2) has worked on,
+// looked up by TDHelper. Direct mapped on the frame number, a slot keeps the
+// most recent frame that maps to it. The two filters can run in different
+// threads, access is serialized.
+class CompStats
+{
+public:
+  struct Entry
+  {
+    int n; // -1: unused
+    int norm1, norm2, mtn1, mtn2;
+  };
+
+  void enable() { entries.assign(SIZE, Entry{ -1, -1, -1, -1, -1 }); }
+  bool enabled() const { return !entries.empty(); }
+
+  void insert(const Entry &e)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    entries[e.n & (SIZE - 1)] = e;
+  }
+
+  bool lookup(int n, Entry &e)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    const Entry &s = entries[n & (SIZE - 1)];
+    if (s.n != n)
+      return false;
+    e = s;
+    return true;
+  }
+
+private:
+  static constexpr int SIZE = 512; // power of 2
+  std::vector<Entry> entries;
+  std::mutex mtx;
+};
+
 class TDeinterlace : public GenericVideoFilter
 {
   bool has_at_least_v8;
@@ -94,13 +193,19 @@ class TDeinterlace : public GenericVideoFilter
   PClip emtn;
   bool tshints;
   int opt;
+  int prefetch;
+  ClipPrefetch clip2Pf, edeintPf, emtnPf;
+  AnalysisWriter analysisOut; // analysis="file": binary per-frame records
+  AnalysisRecord arec; // record of the frame in GetFrame
 
   int countOvr, nfrms, nfrms2, order_origSaved, field_origSaved;
   int mthreshL_origSaved, mthreshC_origSaved, type_origSaved, cthresh6;
   int blockx_half, blocky_half, blockx_shift, blocky_shift;
   std::vector<int> input;
   int* cArray;
-  int sa_pos, rmatch;
+  // internal work frames, reused from frame to frame
+  ScratchFrame maskScratch, dmapScratch, masktScratch, cmaskScratch, mapScratch, tfScratch;
+  int rmatch;
   unsigned int passHint;
   int accumNn, accumPn, accumNm, accumPm;
   bool autoFO, useClip2;
@@ -108,11 +213,18 @@ class TDeinterlace : public GenericVideoFilter
   uint8_t *tbuffer;
   char buf[120];
 
-  void createMotionMap4_PlanarOrYUY2(PVideoFrame &prv2, PVideoFrame &prv,
-    PVideoFrame &src, PVideoFrame &nxt, PVideoFrame &nxt2, PVideoFrame &mask,
+  // Coarse occupancy of the final motion mask, one byte per MTILE_W x MTILE_H tile.
+  // Nonzero means every tile row is a single weave value (10/20/30), so the
+  // interpolators can copy the tile instead of walking it pixel by pixel.
+  std::vector<uint8_t> maskTiles[3];
+  int maskTilesX[3];
+  bool maskTilesValid;
+
+  void createMotionMap4_PlanarOrYUY2(LazyFrame &prv2, PVideoFrame &prv,
+    PVideoFrame &src, PVideoFrame &nxt, LazyFrame &nxt2, PVideoFrame &mask,
     int n, bool isYUY2, IScriptEnvironment *env);
-  void createMotionMap5_PlanarOrYUY2(PVideoFrame &prv2, PVideoFrame &prv,
-    PVideoFrame &src, PVideoFrame &nxt, PVideoFrame &nxt2, PVideoFrame &mask,
+  void createMotionMap5_PlanarOrYUY2(LazyFrame &prv2, PVideoFrame &prv,
+    PVideoFrame &src, PVideoFrame &nxt, LazyFrame &nxt2, PVideoFrame &mask,
     int n, bool IsYUY2, IScriptEnvironment *env);
   
   template<int planarType>
@@ -129,6 +241,8 @@ class TDeinterlace : public GenericVideoFilter
   void denoisePlanar(PVideoFrame &mask);
   void denoiseYUY2(PVideoFrame &mask);
 
+  void buildMaskTiles(PVideoFrame &mask);
+
   template<typename pixel_t>
   void subtractFields(PVideoFrame &prv, PVideoFrame &src, PVideoFrame &nxt,
     VideoInfo &vit, 
@@ -200,6 +314,8 @@ class TDeinterlace : public GenericVideoFilter
   
   template<typename pixel_t>
   void apPostCheck(PVideoFrame &dst, PVideoFrame &mask, PVideoFrame &efrm, IScriptEnvironment *env);
+  int apVoteNeighbors(uint8_t *maskw, const uint8_t *maskp, int maskp_pitch,
+    int Width, int Height, int y, bool planar);
   
   void copyForUpsize(PVideoFrame &dst, PVideoFrame &src, const VideoInfo& vi, IScriptEnvironment *env);
   void setMaskForUpsize(PVideoFrame &msk, const VideoInfo& vi_mask);
@@ -220,13 +336,9 @@ class TDeinterlace : public GenericVideoFilter
     uint8_t *dstp, int prv_pitch, int nxt_pitch, int dst_pitch, int Height,
     int Width, int tpitch, IScriptEnvironment *env);
 
-  template<typename pixel_t>
-  void buildDiffMapPlane2(const uint8_t* prvp, const uint8_t* nxtp,
-    uint8_t* dstp, int prv_pitch, int nxt_pitch, int dst_pitch, int Height,
-    int Width, int bits_per_pixel, IScriptEnvironment* env);
-
   void InsertDiff(PVideoFrame &p1, PVideoFrame &p2, int n, int pos, IScriptEnvironment *env);
-  void insertCompStats(int n, int norm1, int norm2, int mtn1, int mtn2);
+  void InsertDiff(LazyFrame &p1, PVideoFrame &p2, int n, int pos, IScriptEnvironment *env);
+  void InsertDiff(PVideoFrame &p1, LazyFrame &p2, int n, int pos, IScriptEnvironment *env);
   int getMatch(int norm1, int norm2, int mtn1, int mtn2);
 
   template<int planarType>
@@ -244,19 +356,20 @@ class TDeinterlace : public GenericVideoFilter
   void putHint2_core(PVideoFrame& dst, bool wdtd);
 
 public:
-  std::vector<int> sa;
+  CompStats sa;
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
   TDeinterlace(PClip _child, int _mode, int _order, int _field, int _mthreshL,
     int _mthreshC, int _map, const char* _ovr, int _ovrDefault, int _type, bool _debug,
     int _mtnmode, bool _sharp, bool _hints, PClip _clip2, bool _full, int _cthresh,
     bool _chroma, int _MI, bool _tryWeave, int _link, bool _denoise, int _AP,
     int _blockx, int _blocky, int _APType, PClip _edeint, PClip _emask, int _metric,
-    int _expand, int _slow, PClip _emtn, bool _tshints, int _opt, IScriptEnvironment* env);
+    int _expand, int _slow, PClip _emtn, bool _tshints, int _opt, int _prefetch,
+    const char* _analysis, IScriptEnvironment* env);
   ~TDeinterlace();
 
-  static int getHint(const VideoInfo &vi, PVideoFrame& src, unsigned int& storeHint, int& hintField);
+  static int getHint(const VideoInfo &vi, PVideoFrame& src, unsigned int& storeHint, int& hintField, IScriptEnvironment* env);
   template<typename pixel_t>
-  static int getHint_core(PVideoFrame& src, unsigned int& storeHint, int& hintField);
+  static void getHint_core(PVideoFrame& src, unsigned int& magic_number, unsigned int& hint);
   static void putHint(const VideoInfo& vi, PVideoFrame& dst, unsigned int hint, int fieldt);
   template<typename pixel_t>
   static void putHint_core(PVideoFrame &dst, unsigned int hint, int fieldt);
@@ -25,6 +25,8 @@
 
 #include "TDeinterlace.h"
 #include "TCommonASM.h"
+#include "TDeintASM.h"
+#include "hintprop.h"
 #include <cassert>
 
 PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &wdtd)
@@ -32,13 +34,14 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   const int bits_per_pixel = vi.BitsPerComponent();
 
   int n_saved = n;
+  maskTilesValid = false;
   if (mode < 0)
   {
     PVideoFrame src2up = child->GetFrame(n, env);
     PVideoFrame dst2up = // frame property support
       has_at_least_v8 ? env->NewVideoFrameP(vi_saved, &src2up) : env->NewVideoFrame(vi_saved);
 
-    PVideoFrame msk2up = env->NewVideoFrame(vi_mask);
+    PVideoFrame& msk2up = maskScratch.get(vi_mask, env);
     copyForUpsize(dst2up, src2up, vi_saved, env);
     setMaskForUpsize(msk2up, vi_mask);
     if (mode == -2) 
@@ -60,7 +63,7 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
     if (field_origSaved == -1) field = order;
   }
   
-  PVideoFrame prv2, prv, nxt, nxt2, dst, mask;
+  PVideoFrame prv, nxt, dst, mask;
   
   PVideoFrame src = child->GetFrame(n, env);
 
@@ -112,7 +115,7 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
       return src;
     }
   }
-  if (mode == 0 && hints && TDeinterlace::getHint(vi, src, passHint, hintField) == 0 && !found)
+  if (mode == 0 && hints && TDeinterlace::getHint(vi, src, passHint, hintField, has_at_least_v8 ? env : nullptr) == 0 && !found)
   {
     if (debug)
     {
@@ -126,7 +129,9 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   if (mode == 0 && !full && !found)
   {
     int MIC;
-    if (!dispatch_checkCombedPlanar(src, MIC, vi_saved, chroma, cthresh, env))
+    const bool combed = dispatch_checkCombedPlanar(src, MIC, vi_saved, chroma, cthresh, env);
+    arec.mics[0] = MIC;
+    if (!combed)
     {
       if (debug)
       {
@@ -149,20 +154,23 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
     field = hintField;
     hintField = tempf;
   }
+  arec.field = field;
+  // prv2/nxt2 are requested by the motion map, if at all
+  LazyFrame prv2, nxt2;
   if (!useClip2)
   {
-    prv2 = child->GetFrame(n > 1 ? n - 2 : n > 0 ? n - 1 : 0, env);
+    prv2.set(child, n > 1 ? n - 2 : n > 0 ? n - 1 : 0);
     prv = child->GetFrame(n > 0 ? n - 1 : 0, env);
     nxt = child->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-    nxt2 = child->GetFrame(n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms, env);
+    nxt2.set(child, n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms);
   }
   else
   {
-    prv2 = clip2->GetFrame(n > 1 ? n - 2 : n > 0 ? n - 1 : 0, env);
-    prv = clip2->GetFrame(n > 0 ? n - 1 : 0, env);
-    src = clip2->GetFrame(n, env);
-    nxt = clip2->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-    nxt2 = clip2->GetFrame(n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms, env);
+    prv2.set(clip2, n > 1 ? n - 2 : n > 0 ? n - 1 : 0);
+    prv = clip2Pf.GetFrame(n > 0 ? n - 1 : 0, env);
+    src = clip2Pf.GetFrame(n, env);
+    nxt = clip2Pf.GetFrame(n < nfrms ? n + 1 : nfrms, env);
+    nxt2.set(clip2, n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms);
   }
 
   // property support
@@ -180,9 +188,14 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
     else if(bits_per_pixel <= 16)
       subtractFields<uint16_t>(prv, src, nxt, vi_mask, accumPn, accumNn, accumPm, accumNm,
         field, order, false, slow, env);
-    if (sa.size() > 0)
-      insertCompStats(n_saved, accumPn, accumNn, accumPm, accumNm);
+    if (sa.enabled())
+      sa.insert({ n_saved, accumPn, accumNn, accumPm, accumNm });
     rmatch = getMatch(accumPn, accumNn, accumPm, accumNm);
+    arec.match = rmatch;
+    arec.counts[0] = accumPn;
+    arec.counts[1] = accumNn;
+    arec.counts[2] = accumPm;
+    arec.counts[3] = accumNm;
     if (debug)
     {
       sprintf(buf, "TDeint2:  frame %d:  accumPn = %u  accumNn = %u\n", n, accumPn, accumNn);
@@ -196,7 +209,9 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   {
     createWeaveFrame(dst, prv, src, nxt, env); // no spc hbd
     int MIC;
-    if (!dispatch_checkCombedPlanar(dst, MIC, vi_saved, chroma, cthresh, env))
+    const bool combed = dispatch_checkCombedPlanar(dst, MIC, vi_saved, chroma, cthresh, env);
+    arec.mics[1] = MIC;
+    if (!combed)
     {
       if (debug)
       {
@@ -218,20 +233,21 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
     }
   }
   wdtd = true;
-  mask = env->NewVideoFrame(vi_mask);
   if (emask) mask = emask->GetFrame(n_saved, env);
   else
   {
+    mask = maskScratch.take(vi_mask, env);
     if (mthreshL <= 0 && mthreshC <= 0) setMaskForUpsize(mask, vi_mask);
     else if (mtnmode >= 0 && mtnmode <= 3)
     {
       if (emtn)
       {
-        PVideoFrame prv2e = emtn->GetFrame(n > 1 ? n - 2 : n > 0 ? n - 1 : 0, env);
-        PVideoFrame prve = emtn->GetFrame(n > 0 ? n - 1 : 0, env);
-        PVideoFrame srce = emtn->GetFrame(n, env);
-        PVideoFrame nxte = emtn->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-        PVideoFrame nxt2e = emtn->GetFrame(n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms, env);
+        LazyFrame prv2e, nxt2e;
+        prv2e.set(emtn, n > 1 ? n - 2 : n > 0 ? n - 1 : 0);
+        PVideoFrame prve = emtnPf.GetFrame(n > 0 ? n - 1 : 0, env);
+        PVideoFrame srce = emtnPf.GetFrame(n, env);
+        PVideoFrame nxte = emtnPf.GetFrame(n < nfrms ? n + 1 : nfrms, env);
+        nxt2e.set(emtn, n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms);
         if (mtnmode == 0 || mtnmode == 2)
           createMotionMap4_PlanarOrYUY2(prv2e, prve, srce, nxte, nxt2e, mask, n, false/*planar*/, env);
         else
@@ -309,9 +325,11 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   }
   PVideoFrame efrm = NULL;
   if (edeint) 
-    efrm = edeint->GetFrame(n_saved, env);
+    efrm = edeintPf.GetFrame(n_saved, env);
   // dmap is of original bit depth
-  PVideoFrame dmap = map ? env->NewVideoFrame(vi_saved) : NULL;
+  PVideoFrame dmap = NULL;
+  if (map > 2) dmap = dmapScratch.take(vi_saved, env); // only stacked below dst
+  else if (map) dmap = env->NewVideoFrame(vi_saved);
   if (map == 1 || map == 3) 
     dispatch_mapColorsPlanar(dmap, mask, vi);
   else if (map == 2 || map == 4) 
@@ -320,6 +338,8 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   const bool uap = (AP >= 0 && AP < 255) ? true : false;
   if (map == 0 || uap || map > 2)
   {
+    // mask is final here
+    buildMaskTiles(mask);
 
     if (edeint) dispatch_eDeintPlanar(dst, mask, prv, src, nxt, efrm, vi);
     else if (type == 0) dispatch_cubicDeintPlanar(dst, mask, prv, src, nxt, vi);
@@ -332,6 +352,7 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   }
   else
   {
+    if (!emask) maskScratch.give(mask);
     if (hintField >= 0 && !fieldOVR) field = hintField;
     return dmap;
   }
@@ -348,14 +369,18 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
       else
         updateMapAP<uint16_t>(dmap, mask, env);
     }
-    if (map > 0 && map < 3)
-    {
-      if (hintField >= 0 && !fieldOVR) field = hintField;
-      return dmap;
-    }
+  }
+  if (!emask) maskScratch.give(mask);
+  if (uap && map > 0 && map < 3)
+  {
+    if (hintField >= 0 && !fieldOVR) field = hintField;
+    return dmap;
   }
   if (map != 1 && map != 2)
+  {
+    if (has_at_least_v8) clearPropHint(dst, env); // pixel hint takes over
     TDeinterlace::putHint(vi, dst, passHint, field);
+  }
   if (debug)
   {
     sprintf(buf, "TDeint2:  frame %d:  field = %s (%d)  order = %s (%d)\n", n,
@@ -370,13 +395,14 @@ PVideoFrame TDeinterlace::GetFramePlanar(int n, IScriptEnvironment* env, bool &w
   {
     PVideoFrame dst2 = has_at_least_v8 ? env->NewVideoFrameP(vi, &dst) : env->NewVideoFrame(vi);
     stackVertical(dst2, dst, dmap, env);
+    dmapScratch.give(dmap);
     return dst2;
   }
   return dst;
 }
 
-void TDeinterlace::createMotionMap4_PlanarOrYUY2(PVideoFrame &prv2, PVideoFrame &prv,
-  PVideoFrame &src, PVideoFrame &nxt, PVideoFrame &nxt2, PVideoFrame &mask,
+void TDeinterlace::createMotionMap4_PlanarOrYUY2(LazyFrame &prv2, PVideoFrame &prv,
+  PVideoFrame &src, PVideoFrame &nxt, LazyFrame &nxt2, PVideoFrame &mask,
   int n, bool isYUY2, IScriptEnvironment *env)
 {
   db->resetCacheStart(n);
@@ -568,8 +594,8 @@ void TDeinterlace::createMotionMap4_PlanarOrYUY2(PVideoFrame &prv2, PVideoFrame
 }
 
 // HBD ready
-void TDeinterlace::createMotionMap5_PlanarOrYUY2(PVideoFrame &prv2, PVideoFrame &prv,
-  PVideoFrame &src, PVideoFrame &nxt, PVideoFrame &nxt2, PVideoFrame &mask,
+void TDeinterlace::createMotionMap5_PlanarOrYUY2(LazyFrame &prv2, PVideoFrame &prv,
+  PVideoFrame &src, PVideoFrame &nxt, LazyFrame &nxt2, PVideoFrame &mask,
   int n, bool isYUY2, IScriptEnvironment *env)
 {
   db->resetCacheStart(n - 1);
@@ -812,6 +838,9 @@ void TDeinterlace::createMotionMap5_PlanarOrYUY2(PVideoFrame &prv2, PVideoFrame
 template<int planarType>
 void TDeinterlace::expandMap_Planar(PVideoFrame &mask)
 {
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+  std::vector<uint8_t> tmp;
+
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   const int np = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   for (int b = 0; b < np; ++b)
@@ -826,6 +855,20 @@ void TDeinterlace::expandMap_Planar(PVideoFrame &mask)
       b == 0 ? 
       expand : // luma
       (expand >> (planarType == 444 ? 0 : planarType == 411 ? 2 : 1 /* 422, 420 */)); // chroma
+    if (dis == 0)
+      continue; // nothing to expand
+
+    if (use_sse2)
+    {
+      tmp.resize(Width + 4 * dis + 48);
+      maskp += mask_pitch*field;
+      for (int y = field; y < Height; y += 2)
+      {
+        expandMapRow_SSE2(maskp, Width, dis, tmp.data());
+        maskp += mask_pitch2;
+      }
+      continue;
+    }
 
     maskp += mask_pitch*field;
     for (int y = field; y < Height; y += 2)
@@ -874,6 +917,7 @@ void TDeinterlace::linkFULL_Planar(PVideoFrame &mask)
   const int mask_pitchUV2 = mask_pitchUV << 1;
   const int HeightUV = mask->GetHeight(PLANAR_V);
   const int WidthUV = mask->GetRowSize(PLANAR_V);
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
   maskpY += mask_pitchY*field;
   maskpV += mask_pitchUV*field;
   maskpU += mask_pitchUV*field;
@@ -881,7 +925,8 @@ void TDeinterlace::linkFULL_Planar(PVideoFrame &mask)
     uint8_t* maskpnY = maskpY + mask_pitchY2;
     for (int y = field; y < HeightUV; y += 2)
     {
-      for (int x = 0; x < WidthUV; ++x)
+      const int xstart = use_sse2 ? linkFULLRow_SSE2<planarType>(maskpY, maskpnY, maskpU, maskpV, WidthUV) : 0;
+      for (int x = xstart; x < WidthUV; ++x)
       {
         if (((((uint16_t*)maskpY)[x] == (uint16_t)0x3C3C) &&
           (((uint16_t*)maskpnY)[x] == (uint16_t)0x3C3C)) ||
@@ -902,7 +947,8 @@ void TDeinterlace::linkFULL_Planar(PVideoFrame &mask)
     // 411, 422, 444
     for (int y = field; y < HeightUV; y+=2) // always by 2
     {
-      for (int x = 0; x < WidthUV; ++x)
+      const int xstart = use_sse2 ? linkFULLRow_SSE2<planarType>(maskpY, nullptr, maskpU, maskpV, WidthUV) : 0;
+      for (int x = xstart; x < WidthUV; ++x)
       {
         if constexpr (planarType == 422) {
           if (
@@ -953,6 +999,7 @@ void TDeinterlace::linkYtoUV_Planar(PVideoFrame &mask)
   const int mask_pitchUV2 = mask_pitchUV << 1;
   const int HeightUV = mask->GetHeight(PLANAR_V);
   const int WidthUV = mask->GetRowSize(PLANAR_V);
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
   maskpY += mask_pitchY*field;
   maskpV += mask_pitchUV*field;
   maskpU += mask_pitchUV*field;
@@ -960,7 +1007,8 @@ void TDeinterlace::linkYtoUV_Planar(PVideoFrame &mask)
     uint8_t* maskpnY = maskpY + mask_pitchY2;
     for (int y = field; y < HeightUV; y += 2)
     {
-      for (int x = 0; x < WidthUV; ++x)
+      const int xstart = use_sse2 ? linkYtoUVRow_SSE2<planarType>(maskpY, maskpnY, maskpU, maskpV, WidthUV) : 0;
+      for (int x = xstart; x < WidthUV; ++x)
       {
         if (((uint16_t*)maskpY)[x] == (uint16_t)0x3C3C &&
           ((uint16_t*)maskpnY)[x] == (uint16_t)0x3C3C)
@@ -978,7 +1026,8 @@ void TDeinterlace::linkYtoUV_Planar(PVideoFrame &mask)
     // 422, 444, 411
     for (int y = field; y < HeightUV; y+=2) // always by 2
     {
-      for (int x = 0; x < WidthUV; ++x)
+      const int xstart = use_sse2 ? linkYtoUVRow_SSE2<planarType>(maskpY, nullptr, maskpU, maskpV, WidthUV) : 0;
+      for (int x = xstart; x < WidthUV; ++x)
       {
         if constexpr (planarType == 422) {
           if (((uint16_t*)maskpY)[x] == (uint16_t)0x3C3C)
@@ -1021,6 +1070,7 @@ void TDeinterlace::linkUVtoY_Planar(PVideoFrame& mask)
   const int mask_pitchUV2 = mask_pitchUV << 1;
   const int HeightUV = mask->GetHeight(PLANAR_V);
   const int WidthUV = mask->GetRowSize(PLANAR_V);
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
   maskpY += mask_pitchY * field;
   maskpV += mask_pitchUV * field;
   maskpU += mask_pitchUV * field;
@@ -1029,7 +1079,8 @@ void TDeinterlace::linkUVtoY_Planar(PVideoFrame& mask)
   uint8_t* maskpnY = maskpY + mask_pitchY2;
   for (int y = field; y < HeightUV; y += 2)
   {
-    for (int x = 0; x < WidthUV; ++x)
+    const int xstart = use_sse2 ? linkUVtoYRow_SSE2<planarType>(maskpY, maskpnY, maskpU, maskpV, WidthUV) : 0;
+    for (int x = xstart; x < WidthUV; ++x)
     {
       if (maskpV[x] == 0x3C || maskpU[x] == 0x3C)
       {
@@ -1042,16 +1093,19 @@ void TDeinterlace::linkUVtoY_Planar(PVideoFrame& mask)
           ((uint16_t*)maskpY)[x] = (uint16_t)0x3C3C;
         }
         else if constexpr (planarType == 411) { // was missing, fixed after 1.3
-          ((uint32_t*)maskpY)[x * 4] = (uint32_t)0x3C3C3C3C;
+          ((uint32_t*)maskpY)[x] = (uint32_t)0x3C3C3C3C;
         }
         else if constexpr (planarType == 444) {
           maskpY[x] = 0x3C;
         }
       }
     }
-    maskpY += mask_pitchY4;
-    if constexpr (planarType == 420)
+    if constexpr (planarType == 420) {
+      maskpY += mask_pitchY4;
       maskpnY += mask_pitchY4;
+    }
+    else
+      maskpY += mask_pitchY2; // same height as chroma
     maskpV += mask_pitchUV2;
     maskpU += mask_pitchUV2;
   }
@@ -1062,6 +1116,7 @@ void TDeinterlace::linkUVtoY_Planar(PVideoFrame& mask)
 // TFMPP::denoisePlanar: PlanarFrame, 0xFF, TDeinterlace:PVideoFrame 0x3C
 void TDeinterlace::denoisePlanar(PVideoFrame &mask)
 {
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   const int np = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   for (int b = 0; b < np; ++b)
@@ -1077,7 +1132,8 @@ void TDeinterlace::denoisePlanar(PVideoFrame &mask)
     uint8_t *maskpn = maskp + mask_pitch2;
     for (int y = 2; y < Height - 2; y += 2)
     {
-      for (int x = 1; x < Width - 1; ++x)
+      const int xstart = use_sse2 ? denoiseMapRow_SSE2(maskp, maskpp, maskpn, Width) : 1;
+      for (int x = xstart; x < Width - 1; ++x)
       {
         if (maskp[x] == 0x3C)
         {
@@ -1133,8 +1189,6 @@ static void do_checkCombedPlanar(PVideoFrame &src, int &MIC, int bits_per_pixel,
   int cpuFlags, const VideoInfo &vi_saved, int metric, IScriptEnvironment *env)
 {
   // vi_saved: original vi, not a possible stacked one (some modes change height for debug)
-  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
-  const bool use_sse4 = (cpuFlags & CPUF_SSE4_1) ? true : false;
   // cthresh: Area combing threshold used for combed frame detection.
   // This essentially controls how "strong" or "visible" combing must be to be detected.
   // Good values are from 6 to 12. If you know your source has a lot of combed frames set 
@@ -1143,8 +1197,6 @@ static void do_checkCombedPlanar(PVideoFrame &src, int &MIC, int bits_per_pixel,
 
   const int scaled_cthresh = cthresh << (bits_per_pixel - 8);
 
-  const int cthresh6 = scaled_cthresh * 6;
-
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   const int np = vi_saved.IsYUY2() || vi_saved.IsY() ? 1 : 3;
   const int stop = chroma ? np : 1;
@@ -1158,139 +1210,10 @@ static void do_checkCombedPlanar(PVideoFrame &src, int &MIC, int bits_per_pixel,
     const int Width = src->GetRowSize(plane) / sizeof(pixel_t);
     const int Height = src->GetHeight(plane);
 
-    const pixel_t* srcpp = srcp - src_pitch;
-    const pixel_t* srcppp = srcpp - src_pitch;
-    const pixel_t* srcpn = srcp + src_pitch;
-    const pixel_t* srcpnn = srcpn + src_pitch;
-
     uint8_t *cmkp = cmask->GetWritePtr(plane);
     const int cmk_pitch = cmask->GetPitch(plane);
-    
-    if (scaled_cthresh < 0) {
-      memset(cmkp, 255, Height*cmk_pitch); // mask. Always 8 bits 
-      continue;
-    }
-    memset(cmkp, 0, Height*cmk_pitch);
 
-    if (metric == 0)
-    {
-      // top 1 
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpn[x];
-        if (sFirst > scaled_cthresh || sFirst < -scaled_cthresh)
-        {
-          if (abs(srcpnn[x] + (srcp[x] << 2) + srcpnn[x] - (3 * (srcpn[x] + srcpn[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-      srcppp += src_pitch;
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      srcpnn += src_pitch;
-      cmkp += cmk_pitch;
-      // top #2
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpp[x];
-        const int sSecond = srcp[x] - srcpn[x];
-        if ((sFirst > scaled_cthresh && sSecond > scaled_cthresh) || (sFirst < -scaled_cthresh && sSecond < -scaled_cthresh))
-        {
-          if (abs(srcpnn[x] + (srcp[x] << 2) + srcpnn[x] - (3 * (srcpp[x] + srcpn[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-      srcppp += src_pitch;
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      srcpnn += src_pitch;
-      cmkp += cmk_pitch;
-      // middle Height - 4
-      const int lines_to_process = Height - 4;
-      if (use_sse2 && sizeof(pixel_t) == 1)
-        check_combing_SSE2((const uint8_t*)srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, scaled_cthresh);
-      else if (use_sse4 && sizeof(pixel_t) == 2)
-        check_combing_uint16_SSE4((const uint16_t *)srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, scaled_cthresh);
-      else
-        check_combing_c<pixel_t, false>(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, scaled_cthresh);
-      srcppp += src_pitch * lines_to_process;
-      srcpp += src_pitch * lines_to_process;
-      srcp += src_pitch * lines_to_process;
-      srcpn += src_pitch * lines_to_process;
-      srcpnn += src_pitch * lines_to_process;
-      cmkp += cmk_pitch * lines_to_process;
-      // bottom #-2
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpp[x];
-        const int sSecond = srcp[x] - srcpn[x];
-        if ((sFirst > scaled_cthresh && sSecond > scaled_cthresh) || (sFirst < -scaled_cthresh && sSecond < -scaled_cthresh))
-        {
-          if (abs(srcppp[x] + (srcp[x] << 2) + srcppp[x] - (3 * (srcpp[x] + srcpn[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-      srcppp += src_pitch;
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      srcpnn += src_pitch;
-      cmkp += cmk_pitch;
-      // bottom #-1
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpp[x];
-        if (sFirst > scaled_cthresh || sFirst < -scaled_cthresh)
-        {
-          if (abs(srcppp[x] + (srcp[x] << 2) + srcppp[x] - (3 * (srcpp[x] + srcpp[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-    }
-    else
-    {
-      // metric == 1: squared
-      typedef typename std::conditional<sizeof(pixel_t) == 1, int, int64_t> ::type safeint_t;
-
-      const safeint_t cthreshsq = (safeint_t)scaled_cthresh * scaled_cthresh;
-      // top #1
-      for (int x = 0; x < Width; ++x)
-      {
-        if ((safeint_t)(srcp[x] - srcpn[x])*(srcp[x] - srcpn[x]) > cthreshsq)
-          cmkp[x] = 0xFF;
-      }
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      cmkp += cmk_pitch;
-      // middle Height - 2
-      const int lines_to_process = Height - 2;
-      if (use_sse2)
-      {
-        if constexpr(sizeof(pixel_t) == 1)
-          check_combing_SSE2_Metric1(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-        else
-          check_combing_c_Metric1<pixel_t, false, safeint_t>(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-        // fixme: hbd SIMD? int64 inside.
-        // check_combing_uint16_SSE2_Metric1(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-      }
-      else
-      {
-        check_combing_c_Metric1<pixel_t, false, safeint_t>(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-      }
-      srcpp += src_pitch * lines_to_process;
-      srcp += src_pitch * lines_to_process;
-      srcpn += src_pitch * lines_to_process;
-      cmkp += cmk_pitch * lines_to_process;
-      // Bottom
-      for (int x = 0; x < Width; ++x)
-      {
-        if ((safeint_t)(srcp[x] - srcpp[x])*(srcp[x] - srcpp[x]) > cthreshsq)
-          cmkp[x] = 0xFF;
-      }
-    }
+    buildCombMask<pixel_t>(srcp, src_pitch, cmkp, cmk_pitch, Width, Height, 0, Height, scaled_cthresh, metric, false, cpuFlags);
   }
 
   // Includes chroma combing in the decision about whether a frame is combed.
@@ -1308,159 +1231,38 @@ static void do_checkCombedPlanar(PVideoFrame &src, int &MIC, int bits_per_pixel,
 template<typename pixel_t>
 bool TDeinterlace::checkCombedPlanar(PVideoFrame& src, int& MIC, int bits_per_pixel, bool chroma, int cthresh, IScriptEnvironment* env)
 {
-  PVideoFrame cmask = env->NewVideoFrame(vi_mask);
+  PVideoFrame& cmask = cmaskScratch.get(vi_mask, env);
+
+  // MIC is only shown in debug mode or written to the analysis file, otherwise it is
+  // just compared against MI and the scan can stop at the first block above it. Without
+  // chroma the luma mask is then built band by band along with the scan.
+  const bool earlyExit = !debug && !analysisOut.enabled();
+  const bool streamMask = earlyExit && (!chroma || vi_saved.IsY());
 
-  do_checkCombedPlanar<pixel_t>(src, MIC, bits_per_pixel, chroma, cthresh, cmask, cpuFlags, vi_saved, metric, env);
+  if (!streamMask)
+    do_checkCombedPlanar<pixel_t>(src, MIC, bits_per_pixel, chroma, cthresh, cmask, cpuFlags, vi_saved, metric, env);
 
   // from now on, only mask is used, no hbd stuff here
 
   const int cmk_pitch = cmask->GetPitch(PLANAR_Y);
-  const uint8_t* cmkp = cmask->GetReadPtr(PLANAR_Y) + cmk_pitch;
+  uint8_t* cmkp = cmask->GetWritePtr(PLANAR_Y);
   const int Width = cmask->GetRowSize(PLANAR_Y);
   const int Height = cmask->GetHeight(PLANAR_Y);
 
-  const uint8_t* cmkpp = cmkp - cmk_pitch;
-  const uint8_t* cmkpn = cmkp + cmk_pitch;
-
   const int xblocks = ((Width + blockx_half) >> blockx_shift) + 1;
-  const int xblocks4 = xblocks << 2;
   const int yblocks = ((Height + blocky_half) >> blocky_shift) + 1;
   const int arraysize = (xblocks * yblocks) << 2;
   memset(cArray, 0, arraysize * sizeof(int));
-  int Heighta = (Height >> (blocky_shift - 1)) << (blocky_shift - 1);
-  if (Heighta == Height) Heighta = Height - blocky_half;
-  const int Widtha = (Width >> (blockx_shift - 1)) << (blockx_shift - 1);
-
-  const bool use_sse2 = cpuFlags & CPUF_SSE2;
-  // quick case for 8x8 base
-  const bool use_sse2_8x8_sum = (use_sse2 && blockx_half == 8 && blocky_half == 8) ? true : false;
-
-  // top y block
-  for (int y = 1; y < blocky_half; ++y)
+  if (earlyExit)
   {
-    const int temp1 = (y >> blocky_shift) * xblocks4;
-    const int temp2 = ((y + blocky_half) >> blocky_shift) * xblocks4;
-    for (int x = 0; x < Width; ++x)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> blockx_shift) << 2;
-        const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-  }
-  // middle y blocks
-  for (int y = blocky_half; y < Heighta; y += blocky_half)
-  {
-    const int temp1 = (y >> blocky_shift) * xblocks4;
-    const int temp2 = ((y + blocky_half) >> blocky_shift) * xblocks4;
-    // fixme: do it probably for other block sizes than 8x8 and dispatch earlier
-    if (use_sse2_8x8_sum)
-    {
-      for (int x = 0; x < Widtha; x += blockx_half)
-      {
-        // only if blockx_half and blocky_half is 8x8!!! checked above
-        int sum = 0;
-        compute_sum_8xN_sse2<8>(cmkpp + x, cmk_pitch, sum);
-        if (sum)
-        {
-          const int box1 = (x >> blockx_shift) << 2;
-          const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    else
-    {
-      for (int x = 0; x < Widtha; x += blockx_half)
-      {
-        int sum = 0;
-        // fixme: put into compute_sum_8xN_C
-        const uint8_t* cmkppT = cmkpp;
-        const uint8_t* cmkpT = cmkp;
-        const uint8_t* cmkpnT = cmkpn;
-        for (int u = 0; u < blocky_half; ++u)
-        {
-          for (int v = 0; v < blockx_half; ++v)
-          {
-            if (cmkppT[x + v] == 0xFF && cmkpT[x + v] == 0xFF && cmkpnT[x + v] == 0xFF)
-              ++sum;
-          }
-          cmkppT += cmk_pitch;
-          cmkpT += cmk_pitch;
-          cmkpnT += cmk_pitch;
-        }
-        if (sum)
-        {
-          const int box1 = (x >> blockx_shift) << 2;
-          const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    // rest on the right
-    for (int x = Widtha; x < Width; ++x)
-    {
-      const uint8_t* cmkppT = cmkpp;
-      const uint8_t* cmkpT = cmkp;
-      const uint8_t* cmkpnT = cmkpn;
-      int sum = 0;
-      for (int u = 0; u < blocky_half; ++u)
-      {
-        if (cmkppT[x] == 0xFF && cmkpT[x] == 0xFF &&
-          cmkpnT[x] == 0xFF) ++sum;
-        cmkppT += cmk_pitch;
-        cmkpT += cmk_pitch;
-        cmkpnT += cmk_pitch;
-      }
-      if (sum)
-      {
-        const int box1 = (x >> blockx_shift) << 2;
-        const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-        cArray[temp1 + box1 + 0] += sum;
-        cArray[temp1 + box2 + 1] += sum;
-        cArray[temp2 + box1 + 2] += sum;
-        cArray[temp2 + box2 + 3] += sum;
-      }
-    }
-    cmkpp += cmk_pitch * blocky_half;
-    cmkp += cmk_pitch * blocky_half;
-    cmkpn += cmk_pitch * blocky_half;
-  }
-  // rest non-whole blocky at the bottom
-  for (int y = Heighta; y < Height - 1; ++y)
-  {
-    const int temp1 = (y >> blocky_shift) * xblocks4;
-    const int temp2 = ((y + blocky_half) >> blocky_shift) * xblocks4;
-    for (int x = 0; x < Width; ++x)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> blockx_shift) << 2;
-        const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
+    const pixel_t* srcp = reinterpret_cast<const pixel_t*>(src->GetReadPtr(PLANAR_Y));
+    const int src_pitch = src->GetPitch(PLANAR_Y) / sizeof(pixel_t);
+    checkCombedBlocksMI<pixel_t>(srcp, src_pitch, cmkp, cmk_pitch, Width, Height, cthresh << (bits_per_pixel - 8),
+      metric, false, streamMask, blockx_half, blockx_shift, blocky_half, blocky_shift, cArray, MI, false, cpuFlags);
   }
+  else
+    accumulateCombedBlocks(cmkp, cmk_pitch, Width, Height, blockx_half, blockx_shift,
+      blocky_half, blocky_shift, cArray, false, cpuFlags);
 
   MIC = 0;
   for (int x = 0; x < arraysize; ++x)
@@ -1482,23 +1284,6 @@ bool TDeinterlace::checkCombedPlanar(PVideoFrame& src, int& MIC, int bits_per_pi
 }
 
 
-template<typename pixel_t>
-void TDeinterlace::buildDiffMapPlane2(const uint8_t* prvp, const uint8_t* nxtp,
-  uint8_t* dstp, int prv_pitch, int nxt_pitch, int dst_pitch, int Height,
-  int Width, int bits_per_pixel, IScriptEnvironment* env)
-{
-  const bool YUY2_LumaOnly = false; // no mChroma like in TFM
-  do_buildABSDiffMask2<pixel_t>(prvp, nxtp, dstp, prv_pitch, nxt_pitch, dst_pitch, Width, Height, YUY2_LumaOnly, cpuFlags, bits_per_pixel);
-}
-
-// instantiate
-template void TDeinterlace::buildDiffMapPlane2<uint8_t>(const uint8_t* prvp, const uint8_t* nxtp,
-  uint8_t* dstp, int prv_pitch, int nxt_pitch, int dst_pitch, int Height,
-  int Width, int bits_per_pixel, IScriptEnvironment* env);
-template void TDeinterlace::buildDiffMapPlane2<uint16_t>(const uint8_t* prvp, const uint8_t* nxtp,
-  uint8_t* dstp, int prv_pitch, int nxt_pitch, int dst_pitch, int Height,
-  int Width, int bits_per_pixel, IScriptEnvironment* env);
-
 // common planar YUY2
 template<typename pixel_t>
 void TDeinterlace::subtractFields(PVideoFrame &prv, PVideoFrame &src, PVideoFrame &nxt,
@@ -1516,12 +1301,14 @@ void TDeinterlace::subtractFields(PVideoFrame &prv, PVideoFrame &src, PVideoFram
       aPn, aNn, aPm, aNm,
       fieldt, ordert, d2, bits_per_pixel, env);
 
-  PVideoFrame map = env->NewVideoFrame(vi_map);
   const int np = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
 
   uint64_t accumPns = 0, accumNns = 0;
   uint64_t accumPms = 0, accumNms = 0;
+
+  compareFieldsRow_fn_t* compareFieldsRow_fn = get_compareFieldsRow_fn<3>(sizeof(pixel_t), cpuFlags);
+  uint64_t accum[6] = { 0 }; // Pn, Nn, Pm, Nm
   
   aPn = aNn = 0;
   aPm = aNm = 0;
@@ -1529,8 +1316,6 @@ void TDeinterlace::subtractFields(PVideoFrame &prv, PVideoFrame &src, PVideoFram
   for (int b = 0; b < np; ++b)
   {
     const int plane = planes[b];
-    uint8_t *mapp = map->GetWritePtr(plane);
-    const int map_pitch = map->GetPitch(plane) << 1;
 
     const pixel_t *prvp = reinterpret_cast<const pixel_t *>(prv->GetReadPtr(plane));
     const int prv_pitch = prv->GetPitch(plane) / sizeof(pixel_t);
@@ -1576,65 +1361,53 @@ void TDeinterlace::subtractFields(PVideoFrame &prv, PVideoFrame &src, PVideoFram
       curf = srcp + ((3 - fieldt)*src_pitch);
       nxtpf = srcp + ((fieldt == 1 ? 1 : 2)*src_pitch);
     }
-    mapp = mapp + ((fieldt == 1 ? 1 : 2)*(map_pitch >> 1));
-
     const pixel_t* prvnf = prvpf + prvf_pitch;
     const pixel_t* curpf = curf - curf_pitch;
     const pixel_t* curnf = curf + curf_pitch;
     const pixel_t* nxtnf = nxtpf + nxtf_pitch;
-    uint8_t *mapn = mapp + map_pitch;
-    
-    // back to byte pointers
-    if (fieldt != 1)
-      buildDiffMapPlane2<pixel_t>(
-        reinterpret_cast<const uint8_t *>(prvpf - prvf_pitch), 
-        reinterpret_cast<const uint8_t *>(nxtpf - nxtf_pitch),
-        mapp - map_pitch,
-        prvf_pitch * sizeof(pixel_t),
-        nxtf_pitch * sizeof(pixel_t),
-        map_pitch, Height >> 1, Width, bits_per_pixel, env);
-    else
-      buildDiffMapPlane2<pixel_t>(
-        reinterpret_cast<const uint8_t*>(prvnf - prvf_pitch),
-        reinterpret_cast<const uint8_t*>(nxtnf - nxtf_pitch),
-        mapn - map_pitch, 
-        prvf_pitch * sizeof(pixel_t),
-        nxtf_pitch * sizeof(pixel_t),
-        map_pitch, Height >> 1, Width, bits_per_pixel, env);
 
     const int Const23 = 23 << (bits_per_pixel - 8);
     const int Const42 = 42 << (bits_per_pixel - 8);
+    // No difference map frame: its flags are computed in place from prvpf/nxtpf and
+    // prvnf/nxtnf, 1 where the difference is above Const3, 3 where above Const19
+    const int Const3 = 3 << (bits_per_pixel - 8);
+    const int Const19 = 19 << (bits_per_pixel - 8);
 
     for (int y = 2; y < Height - 2; y += 2)
     {
-      for (int x = startx; x < stopx; x++)
+      int x = startx;
+      if (compareFieldsRow_fn) {
+        const CompareFieldsLines lines = { nullptr, nullptr,
+          reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+          reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+          reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+          nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, Const3, Const19 };
+        x = compareFieldsRow_fn(lines, startx, stopx, false, Const23, Const42, accum);
+      }
+      for (; x < stopx; x++)
       {
-        int map_flag = (mapp[x] << 2) + mapn[x];
-        if (map_flag == 0)
+        const int diff_mp = abs(prvpf[x] - nxtpf[x]);
+        const int diff_mn = abs(prvnf[x] - nxtnf[x]);
+        if (diff_mp <= Const3 && diff_mn <= Const3)
           continue;
+        const bool map19 = diff_mp > Const19 || diff_mn > Const19;
 
         int cur_sum = curpf[x] + (curf[x] << 2) + curnf[x];
 
         int diff_p = abs((prvpf[x] + prvnf[x]) * 3 - cur_sum);
         if (diff_p > Const23) {
           accumPns += diff_p;
-          if (diff_p > Const42)
-          {
-            if ((map_flag & 10) != 0)
-              accumPms += diff_p;
-          }
+          if (diff_p > Const42 && map19)
+            accumPms += diff_p;
         }
 
         int diff_n = abs((nxtpf[x] + nxtnf[x]) * 3 - cur_sum);
         if (diff_n > Const23) {
           accumNns += diff_n;
-          if (diff_n > Const42) {
-            if ((map_flag & 10) != 0)
-              accumNms += diff_n;
-          }
+          if (diff_n > Const42 && map19)
+            accumNms += diff_n;
         }
       }
-      mapp += map_pitch;
       prvpf += prvf_pitch;
       curpf += curf_pitch;
       prvnf += prvf_pitch;
@@ -1642,9 +1415,12 @@ void TDeinterlace::subtractFields(PVideoFrame &prv, PVideoFrame &src, PVideoFram
       nxtpf += nxtf_pitch;
       curnf += curf_pitch;
       nxtnf += nxtf_pitch;
-      mapn += map_pitch;
     }
   }
+  accumPns += accum[0];
+  accumNns += accum[1];
+  accumPms += accum[2];
+  accumNms += accum[3];
   // High bit depth: I chose to scale back to 8 bit range.
   // Or else we should threat them as int64 and act upon them outside
   const double factor = 1.0 / (1 << (bits_per_pixel - 8));
@@ -1662,13 +1438,16 @@ void TDeinterlace::subtractFields1(PVideoFrame &prv, PVideoFrame &src, PVideoFra
   int fieldt, int ordert,
   bool d2, int bits_per_pixel, IScriptEnvironment *env)
 {
-  PVideoFrame map = env->NewVideoFrame(vi_map);
+  PVideoFrame& map = mapScratch.get(vi_map, env);
   const int np = vi_map.IsYUY2() || vi_map.IsY() ? 1 : 3;
   int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   
   uint64_t accumPns = 0, accumNns = 0, accumNmls = 0;
   uint64_t accumPms = 0, accumNms = 0, accumPmls = 0;
 
+  compareFieldsRow_fn_t* compareFieldsRow_fn = get_compareFieldsRow_fn<1>(sizeof(pixel_t), cpuFlags);
+  uint64_t accum[6] = { 0 }; // Pn, Nn, Pm, Nm, Pml, Nml
+
   aPn = aNn = 0;
   aPm = aNm = 0;
   for (int b = 0; b < np; ++b)
@@ -1786,7 +1565,16 @@ void TDeinterlace::subtractFields1(PVideoFrame &prv, PVideoFrame &src, PVideoFra
 
     for (int y = 2; y < Height - 2; y += 2)
     {
-      for (int x = startx; x < stopx; x++) {
+      int x = startx;
+      if (compareFieldsRow_fn) {
+        const CompareFieldsLines lines = { mapp, mapn,
+          reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+          reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+          reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+          nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, 0, 0 };
+        x = compareFieldsRow_fn(lines, startx, stopx, false, Const23, Const42, accum);
+      }
+      for (; x < stopx; x++) {
         int map_flag = (mapp[x] << 3) + mapn[x];
         if (map_flag == 0)
             continue;
@@ -1830,6 +1618,13 @@ void TDeinterlace::subtractFields1(PVideoFrame &prv, PVideoFrame &src, PVideoFra
     }// for y
   } //for b 
 
+  accumPns += accum[0];
+  accumNns += accum[1];
+  accumPms += accum[2];
+  accumNms += accum[3];
+  accumPmls += accum[4];
+  accumNmls += accum[5];
+
   const int Const500 = 500 << (bits_per_pixel - 8);
   if (accumPms < Const500 && 
     accumNms < Const500 && 
@@ -1855,13 +1650,16 @@ void TDeinterlace::subtractFields2(PVideoFrame& prv, PVideoFrame& src, PVideoFra
   int fieldt, int ordert,
   bool d2, int bits_per_pixel, IScriptEnvironment* env)
 {
-  PVideoFrame map = env->NewVideoFrame(vi_map);
+  PVideoFrame& map = mapScratch.get(vi_map, env);
 
   const int stop = vi_map.IsYUY2() || vi_map.IsY() ? 1 : 3;
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   
   uint64_t accumPns = 0, accumNns = 0, accumNmls = 0;
   uint64_t accumPms = 0, accumNms = 0, accumPmls = 0;
+
+  compareFieldsRow_fn_t* compareFieldsRow_fn = get_compareFieldsRow_fn<2>(sizeof(pixel_t), cpuFlags);
+  uint64_t accum[6] = { 0 }; // Pn, Nn, Pm, Nm, Pml, Nml
   
   aPn = aNn = 0;
   aPm = aNm = 0;
@@ -1988,7 +1786,18 @@ void TDeinterlace::subtractFields2(PVideoFrame& prv, PVideoFrame& src, PVideoFra
     {
       for (int y = 2; y < Height - 2; y += 2)
       {
-        for (int x = startx; x < stopx; x++) {
+        int x = startx;
+        if (compareFieldsRow_fn) {
+          const CompareFieldsLines lines = { mapp, mapn,
+            reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+            reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+            reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+            reinterpret_cast<const uint8_t*>(prvppf), reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+            reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf),
+            reinterpret_cast<const uint8_t*>(nxtppf), reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf), 3, 0, 0 };
+          x = compareFieldsRow_fn(lines, startx, stopx, false, Const23, Const42, accum);
+        }
+        for (; x < stopx; x++) {
           int map_flag = (mapp[x] << 3) + mapn[x];
           if (map_flag == 0)
               continue;
@@ -2072,7 +1881,18 @@ void TDeinterlace::subtractFields2(PVideoFrame& prv, PVideoFrame& src, PVideoFra
     { // fieldt == 0 else
       for (int y = 2; y < Height - 2; y += 2)
       {
-        for (int x = startx; x < stopx; x++) {
+        int x = startx;
+        if (compareFieldsRow_fn) {
+          const CompareFieldsLines lines = { mapp, mapn,
+            reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+            reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+            reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+            reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf), reinterpret_cast<const uint8_t*>(prvnnf),
+            reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+            reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf), reinterpret_cast<const uint8_t*>(nxtnnf), 0, 0, 0 };
+          x = compareFieldsRow_fn(lines, startx, stopx, false, Const23, Const42, accum);
+        }
+        for (; x < stopx; x++) {
           int map_flag = (mapp[x] << 3) + mapn[x];
           if (map_flag == 0)
             continue;
@@ -2156,6 +1976,13 @@ void TDeinterlace::subtractFields2(PVideoFrame& prv, PVideoFrame& src, PVideoFra
     } // if
   } // for b
 
+  accumPns += accum[0];
+  accumNns += accum[1];
+  accumPms += accum[2];
+  accumNms += accum[3];
+  accumPmls += accum[4];
+  accumNmls += accum[5];
+
   const int Const500 = 500 << (bits_per_pixel - 8);
   if (accumPms < Const500 && 
     accumNms < Const500 && 
@@ -2286,6 +2113,24 @@ void TDeinterlace::mapMergePlanar(PVideoFrame &dst, PVideoFrame &mask,
   }
 }
 
+// Copies a run of weave-only tiles of the current row, starting at tile tx, from
+// the frame selected by the row's mask value. Returns the tile index after the run.
+template<typename pixel_t>
+static int copyWeaveTiles(const uint8_t *trow, int tx, int tilesX, int Width, const uint8_t *maskp,
+  pixel_t *dstp, const pixel_t *srcp, const pixel_t *prvp, const pixel_t *nxtp)
+{
+  const int x0 = tx * MTILE_W;
+  const uint8_t v = maskp[x0];
+  int tend = tx + 1;
+  while (tend < tilesX && trow[tend] && maskp[tend * MTILE_W] == v)
+    ++tend;
+  const int x1 = std::min(tend * MTILE_W, Width);
+  const pixel_t *copyp = v == 10 ? srcp : v == 20 ? prvp : nxtp;
+  if (copyp != dstp) // AP recheck runs in place
+    memcpy(dstp + x0, copyp + x0, (x1 - x0) * sizeof(pixel_t));
+  return tend;
+}
+
 void TDeinterlace::dispatch_eDeintPlanar(PVideoFrame& dst, PVideoFrame& mask,
   PVideoFrame& prv, PVideoFrame& src, PVideoFrame& nxt, PVideoFrame& efrm, const VideoInfo& vi) {
   switch (vi.BitsPerComponent()) {
@@ -2328,10 +2173,18 @@ void TDeinterlace::eDeintPlanar(PVideoFrame &dst, PVideoFrame &mask,
     pixel_t *dstp = reinterpret_cast<pixel_t*>(dst->GetWritePtr(plane));
     const int dst_pitch = dst->GetPitch(plane) / sizeof(pixel_t);
 
+    const uint8_t *tiles = maskTilesValid ? maskTiles[b].data() : nullptr;
+    const int tilesX = maskTilesX[b];
     for (int y = 0; y < height; ++y)
     {
+      const uint8_t *trow = tiles ? tiles + (y / MTILE_H) * tilesX : nullptr;
       for (int x = 0; x < width; ++x)
       {
+        if (trow && !(x & (MTILE_W - 1)) && trow[x / MTILE_W])
+        {
+          x = copyWeaveTiles(trow, x / MTILE_W, tilesX, width, maskp, dstp, srcp, prvp, nxtp) * MTILE_W - 1;
+          continue;
+        }
         if (maskp[x] == 10) dstp[x] = srcp[x];
         else if (maskp[x] == 20) dstp[x] = prvp[x];
         else if (maskp[x] == 30) dstp[x] = nxtp[x];
@@ -2395,10 +2248,18 @@ void TDeinterlace::cubicDeintPlanar(PVideoFrame &dst, PVideoFrame &mask,
     const pixel_t*srcpn = srcp + src_pitch;
     const pixel_t*srcpnn = srcpn + src_pitch2;
 
+    const uint8_t *tiles = maskTilesValid ? maskTiles[b].data() : nullptr;
+    const int tilesX = maskTilesX[b];
     for (int y = 0; y < Height; ++y)
     {
+      const uint8_t *trow = tiles ? tiles + (y / MTILE_H) * tilesX : nullptr;
       for (int x = 0; x < Width; ++x)
       {
+        if (trow && !(x & (MTILE_W - 1)) && trow[x / MTILE_W])
+        {
+          x = copyWeaveTiles(trow, x / MTILE_W, tilesX, Width, maskp, dstp, srcp, prvp, nxtp) * MTILE_W - 1;
+          continue;
+        }
         if (maskp[x] == 10) dstp[x] = srcp[x];
         else if (maskp[x] == 20) dstp[x] = prvp[x];
         else if (maskp[x] == 30) dstp[x] = nxtp[x];
@@ -2470,11 +2331,19 @@ void TDeinterlace::ELADeintPlanar(PVideoFrame &dst, PVideoFrame &mask,
     const pixel_t *srcpp = srcp - src_pitch;
     const pixel_t *srcpn = srcp + src_pitch;
 
+    const uint8_t *tiles = maskTilesValid ? maskTiles[b].data() : nullptr;
+    const int tilesX = maskTilesX[b];
     const int ustop = 8 >> vi.GetPlaneWidthSubsampling(plane);
     for (int y = 0; y < Height; ++y)
     {
+      const uint8_t *trow = tiles ? tiles + (y / MTILE_H) * tilesX : nullptr;
       for (int x = 0; x < Width; ++x)
       {
+        if (trow && !(x & (MTILE_W - 1)) && trow[x / MTILE_W])
+        {
+          x = copyWeaveTiles(trow, x / MTILE_W, tilesX, Width, maskp, dstp, srcp, prvp, nxtp) * MTILE_W - 1;
+          continue;
+        }
         if (maskp[x] == 10) dstp[x] = srcp[x];
         else if (maskp[x] == 20) dstp[x] = prvp[x];
         else if (maskp[x] == 30) dstp[x] = nxtp[x];
@@ -2640,10 +2509,18 @@ void TDeinterlace::kernelDeintPlanar(PVideoFrame &dst, PVideoFrame &mask,
         kernn = srcp + (src_pitch2 << 1);
       }
     }
+    const uint8_t *tiles = maskTilesValid ? maskTiles[b].data() : nullptr;
+    const int tilesX = maskTilesX[b];
     for (int y = 0; y < Height; ++y)
     {
+      const uint8_t *trow = tiles ? tiles + (y / MTILE_H) * tilesX : nullptr;
       for (int x = 0; x < Width; ++x)
       {
+        if (trow && !(x & (MTILE_W - 1)) && trow[x / MTILE_W])
+        {
+          x = copyWeaveTiles(trow, x / MTILE_W, tilesX, Width, maskp, dstp, srcp, prvp, nxtp) * MTILE_W - 1;
+          continue;
+        }
         if (maskp[x] == 10) dstp[x] = srcp[x];
         else if (maskp[x] == 20) dstp[x] = prvp[x];
         else if (maskp[x] == 30) dstp[x] = nxtp[x];
@@ -3052,7 +2929,7 @@ void TDeinterlace::blendDeint(PVideoFrame& dst, PVideoFrame& mask,
   PVideoFrame& prv, PVideoFrame& src, PVideoFrame& nxt,
   IScriptEnvironment* env)
 {
-  PVideoFrame tf = env->NewVideoFrame(vi_saved);
+  PVideoFrame& tf = tfScratch.get(vi_saved, env);
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   const int stop = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   for (int b = 0; b < stop; ++b)
@@ -3160,7 +3037,7 @@ void TDeinterlace::blendDeint2(PVideoFrame& dst, PVideoFrame& mask,
   PVideoFrame& prv, PVideoFrame& src, PVideoFrame& nxt,
   IScriptEnvironment* env)
 {
-  PVideoFrame tf = env->NewVideoFrame(vi_saved);
+  PVideoFrame& tf = tfScratch.get(vi_saved, env);
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   const int stop = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   for (int b = 0; b < stop; ++b)
@@ -25,6 +25,7 @@
 
 #include "TDeinterlace.h"
 #include "TCommonASM.h"
+#include "hintprop.h"
 
 PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdtd)
 {
@@ -33,7 +34,7 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
   {
     PVideoFrame src2up = child->GetFrame(n, env);
     PVideoFrame dst2up = env->NewVideoFrame(vi_saved);
-    PVideoFrame msk2up = env->NewVideoFrame(vi_saved);
+    PVideoFrame& msk2up = maskScratch.get(vi_saved, env);
     copyForUpsize(dst2up, src2up, vi_saved, env);
     setMaskForUpsize(msk2up, vi_mask);
     if (mode == -2) smartELADeintYUY2(dst2up, msk2up, dst2up, dst2up, dst2up);
@@ -52,7 +53,7 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
     order = child->GetParity(n) ? 1 : 0;
     if (field_origSaved == -1) field = order;
   }
-  PVideoFrame prv2, prv, nxt, nxt2, dst, mask;
+  PVideoFrame prv, nxt, dst, mask;
   PVideoFrame src = child->GetFrame(n, env);
   bool found = false, fieldOVR = false;
   int x, hintField = -1;
@@ -102,7 +103,7 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
       return src;
     }
   }
-  if (mode == 0 && hints && TDeinterlace::getHint(vi_saved, src, passHint, hintField) == 0 && !found)
+  if (mode == 0 && hints && TDeinterlace::getHint(vi_saved, src, passHint, hintField, has_at_least_v8 ? env : nullptr) == 0 && !found)
   {
     if (debug)
     {
@@ -116,7 +117,9 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
   if (mode == 0 && !full && !found)
   {
     int MIC;
-    if (!checkCombedYUY2(src, MIC, chroma, cthresh, env))
+    const bool combed = checkCombedYUY2(src, MIC, chroma, cthresh, env);
+    arec.mics[0] = MIC;
+    if (!combed)
     {
       if (debug)
       {
@@ -139,20 +142,23 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
     field = hintField;
     hintField = tempf;
   }
+  arec.field = field;
+  // prv2/nxt2 are requested by the motion map, if at all
+  LazyFrame prv2, nxt2;
   if (!useClip2)
   {
-    prv2 = child->GetFrame(n > 1 ? n - 2 : n > 0 ? n - 1 : 0, env);
+    prv2.set(child, n > 1 ? n - 2 : n > 0 ? n - 1 : 0);
     prv = child->GetFrame(n > 0 ? n - 1 : 0, env);
     nxt = child->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-    nxt2 = child->GetFrame(n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms, env);
+    nxt2.set(child, n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms);
   }
   else
   {
-    prv2 = clip2->GetFrame(n > 1 ? n - 2 : n > 0 ? n - 1 : 0, env);
-    prv = clip2->GetFrame(n > 0 ? n - 1 : 0, env);
-    src = clip2->GetFrame(n, env);
-    nxt = clip2->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-    nxt2 = clip2->GetFrame(n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms, env);
+    prv2.set(clip2, n > 1 ? n - 2 : n > 0 ? n - 1 : 0);
+    prv = clip2Pf.GetFrame(n > 0 ? n - 1 : 0, env);
+    src = clip2Pf.GetFrame(n, env);
+    nxt = clip2Pf.GetFrame(n < nfrms ? n + 1 : nfrms, env);
+    nxt2.set(clip2, n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms);
   }
 
   // property support
@@ -167,9 +173,14 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
     subtractFields<uint8_t>(prv, src, nxt, vi_saved, accumPn, accumNn, accumPm, accumNm,
         field, order, false, slow, env);
 
-    if (sa.size() > 0)
-      insertCompStats(n_saved, accumPn, accumNn, accumPm, accumNm);
+    if (sa.enabled())
+      sa.insert({ n_saved, accumPn, accumNn, accumPm, accumNm });
     rmatch = getMatch(accumPn, accumNn, accumPm, accumNm);
+    arec.match = rmatch;
+    arec.counts[0] = accumPn;
+    arec.counts[1] = accumNn;
+    arec.counts[2] = accumPm;
+    arec.counts[3] = accumNm;
     if (debug)
     {
       sprintf(buf, "TDeint2y:  frame %d:  accumPn = %u  accumNn = %u\n", n, accumPn, accumNn);
@@ -184,7 +195,9 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
   {
     createWeaveFrame(dst, prv, src, nxt, env);
     int MIC;
-    if (!checkCombedYUY2(dst, MIC, chroma, cthresh, env))
+    const bool combed = checkCombedYUY2(dst, MIC, chroma, cthresh, env);
+    arec.mics[1] = MIC;
+    if (!combed)
     {
       if (debug)
       {
@@ -206,20 +219,21 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
     }
   }
   wdtd = true;
-  mask = env->NewVideoFrame(vi_saved);
   if (emask) mask = emask->GetFrame(n_saved, env);
   else
   {
+    mask = maskScratch.take(vi_saved, env);
     if (mthreshL <= 0 && mthreshC <= 0) setMaskForUpsize(mask, vi_mask);
     else if (mtnmode >= 0 && mtnmode <= 3)
     {
       if (emtn)
       {
-        PVideoFrame prv2e = emtn->GetFrame(n > 1 ? n - 2 : n > 0 ? n - 1 : 0, env);
-        PVideoFrame prve = emtn->GetFrame(n > 0 ? n - 1 : 0, env);
-        PVideoFrame srce = emtn->GetFrame(n, env);
-        PVideoFrame nxte = emtn->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-        PVideoFrame nxt2e = emtn->GetFrame(n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms, env);
+        LazyFrame prv2e, nxt2e;
+        prv2e.set(emtn, n > 1 ? n - 2 : n > 0 ? n - 1 : 0);
+        PVideoFrame prve = emtnPf.GetFrame(n > 0 ? n - 1 : 0, env);
+        PVideoFrame srce = emtnPf.GetFrame(n, env);
+        PVideoFrame nxte = emtnPf.GetFrame(n < nfrms ? n + 1 : nfrms, env);
+        nxt2e.set(emtn, n < nfrms - 1 ? n + 2 : n < nfrms ? n + 1 : nfrms);
         if (mtnmode == 0 || mtnmode == 2)
           createMotionMap4_PlanarOrYUY2(prv2e, prve, srce, nxte, nxt2e, mask, n, true /*yuy2*/, env);
         else
@@ -242,8 +256,10 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
     else if (link != 0) env->ThrowError("TDeint:  an unknown error occured (link)!");
   }
   PVideoFrame efrm = NULL;
-  if (edeint) efrm = edeint->GetFrame(n_saved, env);
-  PVideoFrame dmap = map ? env->NewVideoFrame(vi_saved) : NULL;
+  if (edeint) efrm = edeintPf.GetFrame(n_saved, env);
+  PVideoFrame dmap = NULL;
+  if (map > 2) dmap = dmapScratch.take(vi_saved, env); // only stacked below dst
+  else if (map) dmap = env->NewVideoFrame(vi_saved);
   if (map == 1 || map == 3) mapColorsYUY2(dmap, mask);
   else if (map == 2 || map == 4) mapMergeYUY2(dmap, mask, prv, src, nxt);
   const bool uap = (AP >= 0 && AP < 255) ? true : false;
@@ -260,6 +276,7 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
   }
   else
   {
+    if (!emask) maskScratch.give(mask);
     if (hintField >= 0 && !fieldOVR) field = hintField;
     return dmap;
   }
@@ -268,14 +285,18 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
     apPostCheck<uint8_t>(dst, mask, efrm, env);
     if (map) 
       updateMapAP<uint8_t>(dmap, mask, env);
-    if (map > 0 && map < 3)
-    {
-      if (hintField >= 0 && !fieldOVR) field = hintField;
-      return dmap;
-    }
+  }
+  if (!emask) maskScratch.give(mask);
+  if (uap && map > 0 && map < 3)
+  {
+    if (hintField >= 0 && !fieldOVR) field = hintField;
+    return dmap;
   }
   if (map != 1 && map != 2)
+  {
+    if (has_at_least_v8) clearPropHint(dst, env); // pixel hint takes over
     TDeinterlace::putHint(vi_saved, dst, passHint, field);
+  }
   if (debug)
   {
     sprintf(buf, "TDeint2y:  frame %d:  field = %s (%d)  order = %s (%d)\n", n,
@@ -290,6 +311,7 @@ PVideoFrame TDeinterlace::GetFrameYUY2(int n, IScriptEnvironment* env, bool &wdt
   {
     PVideoFrame dst2 = has_at_least_v8 ? env->NewVideoFrameP(vi, &dst) : env->NewVideoFrame(vi);
     stackVertical(dst2, dst, dmap, env);
+    dmapScratch.give(dmap);
     return dst2;
   }
   return dst;
@@ -489,14 +511,12 @@ bool TDeinterlace::checkCombedYUY2(PVideoFrame &src, int &MIC, bool chroma, int
   const uint8_t *srcpn = srcp + src_pitch;
   const uint8_t *srcpnn = srcpn + src_pitch;
   
-  PVideoFrame cmask = env->NewVideoFrame(vi_saved);
+  PVideoFrame& cmask = cmaskScratch.get(vi_saved, env);
 
   uint8_t *cmkw = cmask->GetWritePtr();
   const int cmk_pitch = cmask->GetPitch();
   const int inc = chroma ? 1 : 2;
   const int xblocks = ((Width + blockx_half) >> blockx_shift) + 1;
-  const int xblocks4 = xblocks << 2;
-  //xblocksi = xblocks4;
   const int yblocks = ((Height + blocky_half) >> blocky_shift) + 1;
   const int arraysize = (xblocks*yblocks) << 2;
   if (cthresh < 0) { memset(cmkw, 255, Height*cmk_pitch); goto cjump; }
@@ -657,138 +677,15 @@ cjump:
       cmkpn += cmk_pitch;
     }
   }
-  const uint8_t *cmkp = cmask->GetReadPtr() + cmk_pitch;
-  const uint8_t *cmkpp = cmkp - cmk_pitch;
-  const uint8_t *cmkpn = cmkp + cmk_pitch;
+  // only the luma bytes of the mask are counted, combed chroma has been moved to them above
   memset(cArray, 0, arraysize * sizeof(int));
-  int Heighta = (Height >> (blocky_shift - 1)) << (blocky_shift - 1);
-  if (Heighta == Height) Heighta = Height - blocky_half;
-  const int Widtha = (Width >> (blockx_shift - 1)) << (blockx_shift - 1);
-  const bool use_16x8_sse2_sum = (use_sse2 && blockx_half == 16 && blocky_half == 8) ? true : false;
-  // top y block
-  for (int y = 1; y < blocky_half; ++y)
-  {
-    const int temp1 = (y >> blocky_shift)*xblocks4;
-    const int temp2 = ((y + blocky_half) >> blocky_shift)*xblocks4;
-    for (int x = 0; x < Width; x += 2)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> blockx_shift) << 2;
-        const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-  }
-  // middle y blocks
-  for (int y = blocky_half; y < Heighta; y += blocky_half)
-  {
-    const int temp1 = (y >> blocky_shift)*xblocks4;
-    const int temp2 = ((y + blocky_half) >> blocky_shift)*xblocks4;
-    if (use_16x8_sse2_sum)
-    {
-      // use_sse2_sum is checked agains 16x8 blocksize
-      for (int x = 0; x < Widtha; x += blockx_half)
-      {
-        int sum = 0;
-        compute_sum_16x8_sse2_luma(cmkpp + x, cmk_pitch, sum);
-        if (sum)
-        {
-          const int box1 = (x >> blockx_shift) << 2;
-          const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    else
-    {
-      for (int x = 0; x < Widtha; x += blockx_half)
-      {
-        const uint8_t *cmkppT = cmkpp;
-        const uint8_t *cmkpT = cmkp;
-        const uint8_t *cmkpnT = cmkpn;
-        int sum = 0;
-        for (int u = 0; u < blocky_half; ++u)
-        {
-          for (int v = 0; v < blockx_half; v += 2) // luma: x2
-          {
-            if (cmkppT[x + v] == 0xFF && cmkpT[x + v] == 0xFF &&
-              cmkpnT[x + v] == 0xFF) ++sum;
-          }
-          cmkppT += cmk_pitch;
-          cmkpT += cmk_pitch;
-          cmkpnT += cmk_pitch;
-        }
-        if (sum)
-        {
-          const int box1 = (x >> blockx_shift) << 2;
-          const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    // rest unaligned on the right
-    for (int x = Widtha; x < Width; x += 2)
-    {
-      const uint8_t *cmkppT = cmkpp;
-      const uint8_t *cmkpT = cmkp;
-      const uint8_t *cmkpnT = cmkpn;
-      int sum = 0;
-      for (int u = 0; u < blocky_half; ++u)
-      {
-        if (cmkppT[x] == 0xFF && cmkpT[x] == 0xFF &&
-          cmkpnT[x] == 0xFF) ++sum;
-        cmkppT += cmk_pitch;
-        cmkpT += cmk_pitch;
-        cmkpnT += cmk_pitch;
-      }
-      if (sum)
-      {
-        const int box1 = (x >> blockx_shift) << 2;
-        const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-        cArray[temp1 + box1 + 0] += sum;
-        cArray[temp1 + box2 + 1] += sum;
-        cArray[temp2 + box1 + 2] += sum;
-        cArray[temp2 + box2 + 3] += sum;
-      }
-    }
-    cmkpp += cmk_pitch*blocky_half;
-    cmkp += cmk_pitch*blocky_half;
-    cmkpn += cmk_pitch*blocky_half;
-  }
-  // bottom non-whole y block
-  for (int y = Heighta; y < Height - 1; ++y)
-  {
-    const int temp1 = (y >> blocky_shift)*xblocks4;
-    const int temp2 = ((y + blocky_half) >> blocky_shift)*xblocks4;
-    for (int x = 0; x < Width; x += 2)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> blockx_shift) << 2;
-        const int box2 = ((x + blockx_half) >> blockx_shift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-  }
+  if (!debug && !analysisOut.enabled())
+    checkCombedBlocksMI<uint8_t>(nullptr, 0, cmask->GetWritePtr(), cmk_pitch, Width, Height, cthresh, metric, false, false,
+      blockx_half, blockx_shift, blocky_half, blocky_shift, cArray, MI, true, cpuFlags);
+  else
+    accumulateCombedBlocks(cmask->GetWritePtr(), cmk_pitch, Width, Height, blockx_half, blockx_shift,
+      blocky_half, blocky_shift, cArray, true, cpuFlags);
+
   MIC = 0;
   for (int x = 0; x < arraysize; ++x)
   {
@@ -1461,6 +1358,41 @@ void smartELADeintYUY2(PVideoFrame &dst, PVideoFrame &mask,
   }
 }
 
+// APType 1 and 2: keep the pixels of row y that apPostCheckRow set to 60 only if
+// enough of their neighbours in the motion mask are moving (60). Returns the kept count.
+int TDeinterlace::apVoteNeighbors(uint8_t *maskw, const uint8_t *maskp, int maskp_pitch,
+  int Width, int Height, int y, bool planar)
+{
+  const int maskp_pitch2 = maskp_pitch << 1;
+  const int starty = y - 4 < 0 ? y - 2 < 0 ? y : y - 2 : y - 4;
+  const int stopy = y + 4 > Height - 1 ? y + 2 > Height - 1 ? y : y + 2 : y + 4;
+  int count = 0;
+  for (int x = 0; x < Width; ++x)
+  {
+    if (maskw[x] != 60) continue;
+    const int inc = planar ? 1 : x & 1 ? 4 : 2;
+    const int startx = x - (inc << 1) < 0 ? x - inc < 0 ? x : x - inc : x - (inc << 1);
+    const int stopx = x + (inc << 1) > Width - 1 ? x + inc > Width - 1 ? x : x + inc : x + (inc << 1);
+    int neighbors = 0, moving = 0;
+    const uint8_t *maskpT = maskp + starty*maskp_pitch;
+    for (int u = starty; u <= stopy; u += 2)
+    {
+      for (int v = startx; v <= stopx; v += inc)
+      {
+        if (maskpT[v] == 60) ++moving;
+        ++neighbors;
+      }
+      maskpT += maskp_pitch2;
+    }
+    if ((APType == 1 && (moving << 1) >= neighbors) ||
+      (APType == 2 && (moving * 3) >= neighbors))
+      ++count;
+    else
+      maskw[x] = 10;
+  }
+  return count;
+}
+
 // common planar / YUY2
 template<typename pixel_t>
 void TDeinterlace::apPostCheck(PVideoFrame &dst, PVideoFrame &mask, PVideoFrame &efrm, IScriptEnvironment *env)
@@ -1468,8 +1400,9 @@ void TDeinterlace::apPostCheck(PVideoFrame &dst, PVideoFrame &mask, PVideoFrame
   PVideoFrame maskt;
   if (APType > 0)
   {
-    maskt = env->NewVideoFrame(vi_mask); // v1.6 was: vi_saved
-    copyFrame(maskt, mask, vi_mask, env);
+    PVideoFrame& maskw = masktScratch.get(vi_mask, env); // v1.6 was: vi_saved
+    copyFrame(maskw, mask, vi_mask, env);
+    maskt = maskw; // read only from here
   }
   int count = 0;
 
@@ -1482,70 +1415,32 @@ void TDeinterlace::apPostCheck(PVideoFrame &dst, PVideoFrame &mask, PVideoFrame
   for (int b = 0; b < stop; ++b)
   {
     int plane = planes[b];
-    const pixel_t *dstp = reinterpret_cast<const pixel_t *>(dst->GetReadPtr(plane));
-    const int dst_pitch = dst->GetPitch(plane) / sizeof(pixel_t);
+    const uint8_t *dstp = dst->GetReadPtr(plane);
+    const int dst_pitch = dst->GetPitch(plane);
     const int dst_pitch2 = dst_pitch << 1;
     const int Width = dst->GetRowSize(plane) / sizeof(pixel_t);
     const int Height = dst->GetHeight(plane);
     dstp += (2 - field)*dst_pitch;
-    const pixel_t *dstppp = dstp - dst_pitch2;
-    const pixel_t*dstpp = dstp - dst_pitch;
-    const pixel_t *dstpn = dstp + dst_pitch;
-    const pixel_t*dstpnn = dstp + dst_pitch2;
-    
+    const uint8_t *dstppp = dstp - dst_pitch2;
+    const uint8_t *dstpp = dstp - dst_pitch;
+    const uint8_t *dstpn = dstp + dst_pitch;
+    const uint8_t *dstpnn = dstp + dst_pitch2;
+
     uint8_t *maskw = mask->GetWritePtr(plane);
     const int mask_pitch = mask->GetPitch(plane);
     const int mask_pitch2 = mask_pitch << 1;
     const uint8_t *maskp = APType > 0 ? maskt->GetReadPtr(plane) : NULL;
     int maskp_pitch = APType > 0 ? maskt->GetPitch(plane) : 0;
-    const int maskp_pitch2 = maskp_pitch << 1;
     maskw += (2 - field)*mask_pitch;
 
     int y = 2 - field;
-    
-    for (int x = 0; x < Width; ++x)
-    {
-      if (maskw[x] == 60) { maskw[x] = 10; continue; }
-      maskw[x] = 10;
-      const int sFirst = dstp[x] - dstpp[x];
-      const int sSecond = dstp[x] - dstpn[x];
-      if ((sFirst > scaled_AP && sSecond > scaled_AP) || (sFirst < -scaled_AP && sSecond < -scaled_AP))
-      {
-        if (abs(dstpnn[x] + (dstp[x] << 2) + dstpnn[x] - (3 * (dstpp[x] + dstpn[x]))) > scaled_AP6)
-        {
-          if (APType > 0)
-          {
-            const int inc = stop > 1 ? 1 : x & 1 ? 4 : 2;
-            const int startx = x - (inc << 1) < 0 ? x - inc < 0 ? x : x - inc : x - (inc << 1);
-            const int stopx = x + (inc << 1) > Width - 1 ? x + inc > Width - 1 ? x : x + inc : x + (inc << 1);
-            const int starty = y - 4 < 0 ? y - 2 < 0 ? y : y - 2 : y - 4;
-            const int stopy = y + 4 > Height - 1 ? y + 2 > Height - 1 ? y : y + 2 : y + 4;
-            int neighbors = 0, moving = 0;
-            const uint8_t *maskpT = maskp + starty*maskp_pitch;
-            for (int u = starty; u <= stopy; u += 2)
-            {
-              for (int v = startx; v <= stopx; v += inc)
-              {
-                if (maskpT[v] == 60) ++moving;
-                ++neighbors;
-              }
-              maskpT += maskp_pitch2;
-            }
-            if ((APType == 1 && (moving << 1) >= neighbors) ||
-              (APType == 2 && (moving * 3) >= neighbors))
-            {
-              maskw[x] = 60;
-              ++count;
-            }
-          }
-          else
-          {
-            maskw[x] = 60;
-            ++count;
-          }
-        }
-      }
-    }
+
+    // the spike test runs vectorized over the row, the neighbour vote only on its hits
+    // first row: y-3 is mirrored to y+3
+    int c = dispatch_apPostCheckRow<pixel_t>(dstp, dstpp, dstpn, dstpnn, dstpnn, maskw, Width, scaled_AP, scaled_AP6, cpuFlags);
+    if (c > 0 && APType > 0)
+      c = apVoteNeighbors(maskw, maskp, maskp_pitch, Width, Height, y, stop > 1);
+    count += c;
     dstppp += dst_pitch2;
     dstpp += dst_pitch2;
     dstp += dst_pitch2;
@@ -1555,49 +1450,10 @@ void TDeinterlace::apPostCheck(PVideoFrame &dst, PVideoFrame &mask, PVideoFrame
     y += 2;
     for (; y < Height - 3; y += 2)
     {
-      const int starty = y - 4 < 0 ? y - 2 < 0 ? y : y - 2 : y - 4;
-      const int stopy = y + 4 > Height - 1 ? y + 2 > Height - 1 ? y : y + 2 : y + 4;
-      for (int x = 0; x < Width; ++x)
-      {
-        if (maskw[x] == 60) { maskw[x] = 10; continue; }
-        maskw[x] = 10;
-        const int sFirst = dstp[x] - dstpp[x];
-        const int sSecond = dstp[x] - dstpn[x];
-        if ((sFirst > scaled_AP && sSecond > scaled_AP) || (sFirst < -scaled_AP && sSecond < -scaled_AP))
-        {
-          if (abs(dstppp[x] + (dstp[x] << 2) + dstpnn[x] - (3 * (dstpp[x] + dstpn[x]))) > scaled_AP6)
-          {
-            if (APType > 0)
-            {
-              const int inc = stop > 1 ? 1 : x & 1 ? 4 : 2;
-              const int startx = x - (inc << 1) < 0 ? x - inc < 0 ? x : x - inc : x - (inc << 1);
-              const int stopx = x + (inc << 1) > Width - 1 ? x + inc > Width - 1 ? x : x + inc : x + (inc << 1);
-              int neighbors = 0, moving = 0;
-              const uint8_t *maskpT = maskp + starty*maskp_pitch;
-              for (int u = starty; u <= stopy; u += 2)
-              {
-                for (int v = startx; v <= stopx; v += inc)
-                {
-                  if (maskpT[v] == 60) ++moving;
-                  ++neighbors;
-                }
-                maskpT += maskp_pitch2;
-              }
-              if ((APType == 1 && (moving << 1) >= neighbors) ||
-                (APType == 2 && (moving * 3) >= neighbors))
-              {
-                maskw[x] = 60;
-                ++count;
-              }
-            }
-            else
-            {
-              maskw[x] = 60;
-              ++count;
-            }
-          }
-        }
-      }
+      c = dispatch_apPostCheckRow<pixel_t>(dstp, dstpp, dstpn, dstppp, dstpnn, maskw, Width, scaled_AP, scaled_AP6, cpuFlags);
+      if (c > 0 && APType > 0)
+        c = apVoteNeighbors(maskw, maskp, maskp_pitch, Width, Height, y, stop > 1);
+      count += c;
       dstppp += dst_pitch2;
       dstpp += dst_pitch2;
       dstp += dst_pitch2;
@@ -1605,54 +1461,18 @@ void TDeinterlace::apPostCheck(PVideoFrame &dst, PVideoFrame &mask, PVideoFrame
       dstpnn += dst_pitch2;
       maskw += mask_pitch2;
     }
-    for (int x = 0; x < Width; ++x)
-    {
-      if (maskw[x] == 60) { maskw[x] = 10; continue; }
-      maskw[x] = 10;
-      const int sFirst = dstp[x] - dstpp[x];
-      const int sSecond = dstp[x] - dstpn[x];
-      if ((sFirst > scaled_AP && sSecond > scaled_AP) || (sFirst < -scaled_AP && sSecond < -scaled_AP))
-      {
-        if (abs(dstppp[x] + (dstp[x] << 2) + dstppp[x] - (3 * (dstpp[x] + dstpn[x]))) > scaled_AP6)
-        {
-          if (APType > 0)
-          {
-            const int inc = stop > 1 ? 1 : x & 1 ? 4 : 2;
-            const int startx = x - (inc << 1) < 0 ? x - inc < 0 ? x : x - inc : x - (inc << 1);
-            const int stopx = x + (inc << 1) > Width - 1 ? x + inc > Width - 1 ? x : x + inc : x + (inc << 1);
-            const int starty = y - 4 < 0 ? y - 2 < 0 ? y : y - 2 : y - 4;
-            const int stopy = y + 4 > Height - 1 ? y + 2 > Height - 1 ? y : y + 2 : y + 4;
-            int neighbors = 0, moving = 0;
-            const uint8_t *maskpT = maskp + starty*maskp_pitch;
-            for (int u = starty; u <= stopy; u += 2)
-            {
-              for (int v = startx; v <= stopx; v += inc)
-              {
-                if (maskpT[v] == 60) ++moving;
-                ++neighbors;
-              }
-              maskpT += maskp_pitch2;
-            }
-            if ((APType == 1 && (moving << 1) >= neighbors) ||
-              (APType == 2 && (moving * 3) >= neighbors))
-            {
-              maskw[x] = 60;
-              ++count;
-            }
-          }
-          else
-          {
-            maskw[x] = 60;
-            ++count;
-          }
-        }
-      }
-    }
+    // last row: y+3 is mirrored to y-3
+    c = dispatch_apPostCheckRow<pixel_t>(dstp, dstpp, dstpn, dstppp, dstppp, maskw, Width, scaled_AP, scaled_AP6, cpuFlags);
+    if (c > 0 && APType > 0)
+      c = apVoteNeighbors(maskw, maskp, maskp_pitch, Width, Height, y, stop > 1);
+    count += c;
   }
   if (count > 0)
   {
     if (vi.IsPlanar())
     {
+      // the rechecked mask is mostly plain weave again
+      buildMaskTiles(mask);
       if (edeint) dispatch_eDeintPlanar(dst, mask, dst, dst, dst, efrm, vi);
       else if (type == 0) dispatch_cubicDeintPlanar(dst, mask, dst, dst, dst, vi);
       else if (type == 1) dispatch_smartELADeintPlanar(dst, mask, dst, dst, dst, vi);
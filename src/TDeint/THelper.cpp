@@ -35,7 +35,7 @@ TDHelper::~TDHelper()
 }
 
 TDHelper::TDHelper(PClip _child, int _order, int _field, double _lim, bool _debug,
-  int _opt, std::vector<int> &_sa, int _slow, TDeinterlace * _tdptr, IScriptEnvironment *env) :
+  int _opt, CompStats &_sa, int _slow, TDeinterlace * _tdptr, IScriptEnvironment *env) :
   GenericVideoFilter(_child), order(_order), field(_field), debug(_debug), opt(_opt),
   sa(_sa), slow(_slow), tdptr(_tdptr)
 {
@@ -101,21 +101,15 @@ PVideoFrame __stdcall TDHelper::GetFrame(int n, IScriptEnvironment *env)
 
   const int bits_per_pixel = vi.BitsPerComponent();
 
-  if (sa.size() > 0)
+  if (sa.enabled())
   {
-    for (int i = 0; i < 500; ++i)
-    {
-      if (sa[i * 5] == n)
-      {
-        norm1 = sa[i * 5 + 1];
-        norm2 = sa[i * 5 + 2];
-        mtn1 = sa[i * 5 + 3];
-        mtn2 = sa[i * 5 + 4];
-        break;
-      }
-    }
-    if (norm1 == -1 || norm2 == -1 || mtn1 == -1 || mtn2 == -1)
+    CompStats::Entry e{};
+    if (!sa.lookup(n, e))
       env->ThrowError("TDeint:  mode 2 internal communication problem!");
+    norm1 = e.norm1;
+    norm2 = e.norm2;
+    mtn1 = e.mtn1;
+    mtn2 = e.mtn2;
   }
   else {
     VideoInfo vi_map = vi;
@@ -226,15 +220,18 @@ uint64_t TDHelper::subtractFrames(PVideoFrame &src1, PVideoFrame &src2, IScriptE
   const int src1_pitch = src1->GetPitch();
   const int height = src1->GetHeight();
   //const int rowsize = (src1->GetRowSize() >> 4) << 4; // mod 16
-  const int rowsize = src1->GetRowSize(); // no problem if SSE2 is overworking to 16 bytes
+  const int rowsize = src1->GetRowSize(); // SIMD does whole chunks, the rest is done in C
   const int width = src1->GetRowSize() / sizeof(pixel_t);
   const uint8_t *srcp2 = src2->GetReadPtr();
   const int src2_pitch = src2->GetPitch();
   const int inc = vi.IsPlanar() ? 1 : 2; // YUY2 lumaonly: step 2
 
   const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+  const bool use_avx2 = (cpuFlags & CPUF_AVX2) ? true : false;
 
-  if (use_sse2)
+  if (use_avx2)
+    subtractFrames_AVX2<pixel_t>(srcp1, src1_pitch, srcp2, src2_pitch, height, rowsize, inc, diff);
+  else if (use_sse2)
     subtractFrames_SSE2<pixel_t>(srcp1, src1_pitch, srcp2, src2_pitch, height, rowsize, inc, diff);
   else
   {
@@ -256,6 +253,7 @@ void TDHelper::blendFrames_5050(PVideoFrame &src1, PVideoFrame &src2, PVideoFram
   const int stop = vi.IsYUY2() || vi.IsY() ? 1 : 3;
 
   const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+  const bool use_avx2 = (cpuFlags & CPUF_AVX2) ? true : false;
 
   for (int b = 0; b < stop; ++b)
   {
@@ -272,10 +270,12 @@ void TDHelper::blendFrames_5050(PVideoFrame &src1, PVideoFrame &src2, PVideoFram
     uint8_t *dstp = dst->GetWritePtr(plane);
     const int dst_pitch = dst->GetPitch(plane);
 
-    if (use_sse2)
+    if (use_avx2)
+      blend_5050_AVX2<pixel_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
+    else if (use_sse2)
       blend_5050_SSE2<pixel_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
     else
-      blend_5050_c<pixel_t>(dstp, srcp1, srcp2, dst_pitch, width, height, src1_pitch, src2_pitch);
+      blend_5050_c<pixel_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
   }
 }
 
@@ -285,77 +285,46 @@ void subtractFrames_SSE2(const uint8_t *srcp1, int src1_pitch,
   uint64_t &diff)
 {
   // inc: 2 (YUY2 lumaonly chroma skip) or 1 (YV12)
-/*
+  // whole 16 byte chunks only, the rest of the row (and not the padding) in C
+  const int rowsize_simd = rowsize & ~15;
+  const auto zero = _mm_setzero_si128();
+  const __m128i lumaMask = _mm_set1_epi16(0x00FF);
+  auto sum = _mm_setzero_si128(); // 2x64 bits
   for (int y = 0; y < height; ++y)
   {
-    for (int x = 0; x < width; x += inc)
-      diff += abs(srcp1[x] - srcp2[x]);
-    srcp1 += src1_pitch;
-    srcp2 += src2_pitch;
-  }
-*/
-  if (inc == 1)
-  {
-    auto zero = _mm_setzero_si128();
-    auto sum = _mm_setzero_si128();
-    for (int y = 0; y < height; ++y)
-    {
-      for (int x = 0; x < rowsize; x += 16)
+    if constexpr (sizeof(pixel_t) == 1) {
+      for (int x = 0; x < rowsize_simd; x += 16)
       {
         auto src1 = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp1 + x));
         auto src2 = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp2 + x));
-        if constexpr (sizeof(pixel_t) == 1) {
-          auto absdiff = _mm_sad_epu8(src1, src2);
-          sum = _mm_add_epi64(sum, absdiff);
-        }
-        else { // uint16_t
-          auto diff12 = _mm_subs_epu16(src1, src2);
-          auto diff21 = _mm_subs_epu16(src2, src1);
-          auto absdiff = _mm_or_si128(diff12, diff21);
-          sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(absdiff, zero));
-          sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(absdiff, zero)); // 4x32 bits
+        if (inc == 2) {
+          src1 = _mm_and_si128(src1, lumaMask);
+          src2 = _mm_and_si128(src2, lumaMask);
         }
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(src1, src2));
       }
-      srcp1 += src1_pitch;
-      srcp2 += src2_pitch;
-    }
-    if constexpr (sizeof(pixel_t) == 1) {
-      sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8)); // 8 bit sad lo64 hi64
     }
     else {
-      // at 16 bits: we have 4 integers for sum: a0 a1 a2 a3
-      __m128i a0_a1 = _mm_unpacklo_epi32(sum, zero); // a0 0 a1 0
-      __m128i a2_a3 = _mm_unpackhi_epi32(sum, zero); // a2 0 a3 0
-      sum = _mm_add_epi32(a0_a1, a2_a3); // a0+a2, 0, a1+a3, 0
-                                         // sum here: two 32 bit partial result: sum1 0 sum2 0
-      __m128i sum_hi = _mm_unpackhi_epi64(sum, zero); // a1 + a3. 2 dwords right 
-      sum = _mm_add_epi32(sum, sum_hi);  // a0 + a2 + a1 + a3
-    }
-    diff += _mm_cvtsi128_si32(sum);
-  }
-  else
-  {
-    // inc = 2 YUY2 lumaonly
-    const __m128i lumaMask = _mm_set1_epi16(0x00FF);
-
-    auto sum = _mm_setzero_si128();
-    for (int y = 0; y < height; ++y)
-    {
-      for (int x = 0; x < rowsize; x += 16)
+      // 32 bit lanes are enough for a row, moved to 64 bits after each row
+      auto rowsum = _mm_setzero_si128();
+      for (int x = 0; x < rowsize_simd; x += 16)
       {
         auto src1 = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp1 + x));
-        src1 = _mm_and_si128(src1, lumaMask);
         auto src2 = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp2 + x));
-        src1 = _mm_and_si128(src2, lumaMask);
-        auto sad = _mm_sad_epu8(src1, src2);
-        sum = _mm_add_epi64(sum, sad);
+        auto absdiff = _mm_or_si128(_mm_subs_epu16(src1, src2), _mm_subs_epu16(src2, src1));
+        rowsum = _mm_add_epi32(rowsum, _mm_unpacklo_epi16(absdiff, zero));
+        rowsum = _mm_add_epi32(rowsum, _mm_unpackhi_epi16(absdiff, zero));
       }
-      srcp1 += src1_pitch;
-      srcp2 += src2_pitch;
+      sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(rowsum, zero));
+      sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(rowsum, zero));
     }
-    sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
-    diff += _mm_cvtsi128_si32(sum);
+    for (int x = rowsize_simd / sizeof(pixel_t); x < rowsize / (int)sizeof(pixel_t); x += inc)
+      diff += abs(reinterpret_cast<const pixel_t*>(srcp1)[x] - reinterpret_cast<const pixel_t*>(srcp2)[x]);
+    srcp1 += src1_pitch;
+    srcp2 += src2_pitch;
   }
+  sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
+  uint64_t total;
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&total), sum);
+  diff += total;
 }
-
-
@@ -36,6 +36,7 @@
 #include <vector>
 
 class TDeinterlace;
+class CompStats;
 
 template<typename pixel_t>
 void subtractFrames_SSE2(const uint8_t* srcp1, int src1_pitch,
@@ -53,7 +54,7 @@ private:
   uint64_t lim;
   int debug;
   int opt;
-  std::vector<int> &sa;
+  CompStats &sa;
   int slow;
   TDeinterlace* tdptr;
 
@@ -68,7 +69,7 @@ public:
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment *env) override;
   ~TDHelper();
   TDHelper(PClip _child, int _order, int _field, double _lim, bool _debug,
-    int _opt, std::vector<int>& _sa, int _slow, TDeinterlace *_tdptr, IScriptEnvironment *env);
+    int _opt, CompStats& _sa, int _slow, TDeinterlace *_tdptr, IScriptEnvironment *env);
 
   int __stdcall SetCacheHints(int cachehints, int frame_range) override {
     return cachehints == CACHE_GET_MTMODE ? MT_SERIALIZED : 0;
@@ -25,6 +25,7 @@
 
 #include "TSwitch.h"
 #include "internal.h"
+#include "hintprop.h"
 #ifdef _WIN32
 #include <Windows.h> // OutputDebugString
 #endif
@@ -35,6 +36,8 @@ TSwitch::TSwitch(PClip _child, PClip _c1, PClip _c2, bool _debug,
 {
   if (!c1 || !c2)
     env->ThrowError("TSwitch:  either c1 or c2 was not specified!");
+  has_at_least_v8 = true;
+  try { env->CheckVersion(8); } catch (const AvisynthError&) { has_at_least_v8 = false; }
   VideoInfo vic1 = c1->GetVideoInfo();
   VideoInfo vic2 = c2->GetVideoInfo();
   if (vic1.pixel_type != vic2.pixel_type ||
@@ -80,6 +83,7 @@ PVideoFrame __stdcall TSwitch::GetFrame(int n, IScriptEnvironment *env)
   else
     env->ThrowError("TSwitch:  internal error!");
   env->MakeWritable(&dst);
+  if (has_at_least_v8) clearPropHint(dst, env); // c1/c2 may carry one from TFM
   putHint(vi, dst, hint, htype);
   return dst;
 }
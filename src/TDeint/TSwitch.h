@@ -32,6 +32,7 @@ private:
   char buf[512];
   PClip c1, c2;
   bool debug;
+  bool has_at_least_v8;
   int getHint(const VideoInfo &vi, PVideoFrame &src, unsigned int &hint, int &htype);
   template<typename pixel_t>
   int getHint_core(PVideoFrame& src, unsigned int& hint, int& htype);
@@ -0,0 +1,66 @@
+/*
+**                    TIVTC for AviSynth 2.6 interface
+**
+**   TIVTC includes a field matching filter (TFM) and a decimation
+**   filter (TDecimate) which can be used together to achieve an
+**   IVTC or for other uses. TIVTC currently supports 8 bit planar YUV and
+**   YUY2 colorspaces.
+**
+**   Copyright (C) 2004-2008 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __CALCMETRIC_H__
+#define __CALCMETRIC_H__
+
+#include <stdint.h>
+#include "internal.h"
+#include "scratchframe.h"
+
+// All the rest of this code was just copied from tdecimate.cpp because I'm
+// too lazy to make it work such that it could call that code.
+// pinterf 2020: moved the three versions to common codebase again: CalcMetricsExtracted().
+
+// predenoise work frames of the calling filter instance
+struct MetricScratch {
+  ScratchFrame prev, curr, blurtmp;
+};
+
+struct CalcMetricData {
+  bool predenoise;
+  VideoInfo vi;
+  bool chroma;
+  int cpuFlags;
+  int blockx;
+  int blockx_half;
+  int blockx_shift;
+  int blocky;
+  int blocky_half;
+  int blocky_shift;
+  uint64_t* diff;
+  int nt;
+  bool ssd; // ssd or sad
+  MetricScratch* scratch = nullptr; // needed for predenoise
+
+  bool metricF_needed; // from TDecimate: true, from FrameDiff: false
+  // TDecimate
+  uint64_t* metricF; // out!
+  bool scene;
+};
+
+void CalcMetricsExtracted(IScriptEnvironment* env, PVideoFrame& prevt, PVideoFrame& currt, CalcMetricData& d);
+
+#endif // __CALCMETRIC_H__
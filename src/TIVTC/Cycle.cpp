@@ -451,6 +451,7 @@ Cycle::Cycle(int _size, int _sdlim)
   length = frame = frameE = cycleS = cycleE = offE = -20;
   frameSO = frameEO = maxFrame = dupCount = blend = -20;
   type = -1;
+  arena = NULL;
   dupArray = lowest = match = decimate = decimate2 = filmd2v = NULL;
   dect = dect2 = NULL;
   diffMetricsU = diffMetricsUF = tArray = NULL;
@@ -468,50 +469,36 @@ Cycle::Cycle(int _size, int _sdlim)
 
 Cycle::~Cycle()
 {
-  if (dupArray != NULL) { free(dupArray); dupArray = NULL; }
-  if (lowest != NULL) { free(lowest); lowest = NULL; }
-  if (match != NULL) { free(match); match = NULL; }
-  if (filmd2v != NULL) { free(filmd2v); filmd2v = NULL; }
-  if (decimate != NULL) { free(decimate); decimate = NULL; }
-  if (decimate2 != NULL) { free(decimate2); decimate2 = NULL; }
-  if (dect != NULL) { free(dect); dect = NULL; }
-  if (dect2 != NULL) { free(dect2); dect2 = NULL; }
-  if (diffMetricsU != NULL) { free(diffMetricsU); diffMetricsU = NULL; }
-  if (diffMetricsUF != NULL) { free(diffMetricsUF); diffMetricsUF = NULL; }
-  if (tArray != NULL) { free(tArray); tArray = NULL; }
-  if (diffMetricsN != NULL) { free(diffMetricsN); diffMetricsN = NULL; }
+  if (arena != NULL) { free(arena); arena = NULL; }
 }
 
+// All per frame arrays live in one block: the 8 byte wide ones first,
+// then the int ones, so every array stays naturally aligned.
 bool Cycle::allocSpace()
 {
-  if (dupArray != NULL) { free(dupArray); dupArray = NULL; }
-  if (lowest != NULL) { free(lowest); lowest = NULL; }
-  if (match != NULL) { free(match); match = NULL; }
-  if (filmd2v != NULL) { free(filmd2v); filmd2v = NULL; }
-  if (decimate != NULL) { free(decimate); decimate = NULL; }
-  if (decimate2 != NULL) { free(decimate2); decimate2 = NULL; }
-  if (dect != NULL) { free(dect); dect = NULL; }
-  if (dect2 != NULL) { free(dect2); dect2 = NULL; }
-  if (diffMetricsU != NULL) { free(diffMetricsU); diffMetricsU = NULL; }
-  if (diffMetricsUF != NULL) { free(diffMetricsUF); diffMetricsUF = NULL; }
-  if (tArray != NULL) { free(tArray); tArray = NULL; }
-  if (diffMetricsN != NULL) { free(diffMetricsN); diffMetricsN = NULL; }
-  dupArray = (int *)malloc(cycleSize * sizeof(int));
-  lowest = (int *)malloc(cycleSize * sizeof(int));
-  match = (int *)malloc(cycleSize * sizeof(int));
-  filmd2v = (int *)malloc(cycleSize * sizeof(int));
-  decimate = (int *)malloc(cycleSize * sizeof(int));
-  decimate2 = (int *)malloc(cycleSize * sizeof(int));
-  dect = (int *)malloc(cycleSize * sizeof(int));
-  dect2 = (int *)malloc(cycleSize * sizeof(int));
-  diffMetricsU = (uint64_t *)malloc(cycleSize * sizeof(uint64_t));
-  diffMetricsUF = (uint64_t *)malloc(cycleSize * sizeof(uint64_t));
-  tArray = (uint64_t *)malloc(cycleSize * sizeof(uint64_t));
-  diffMetricsN = (double *)malloc(cycleSize * sizeof(double));
-  if (dupArray == NULL || lowest == NULL || match == NULL || filmd2v == NULL ||
-    decimate == NULL || decimate2 == NULL || diffMetricsU == NULL ||
-    diffMetricsUF == NULL || diffMetricsN == NULL || tArray == NULL ||
-    dect == NULL || dect2 == NULL) return false;
+  if (arena != NULL) { free(arena); arena = NULL; }
+  const size_t n = std::max(cycleSize, 1);
+  arena = (uint8_t *)malloc(n * (3 * sizeof(uint64_t) + sizeof(double) + 8 * sizeof(int)));
+  if (arena == NULL)
+  {
+    dupArray = lowest = match = decimate = decimate2 = filmd2v = NULL;
+    dect = dect2 = NULL;
+    diffMetricsU = diffMetricsUF = tArray = NULL;
+    diffMetricsN = NULL;
+    return false;
+  }
+  diffMetricsU = (uint64_t *)arena;
+  diffMetricsUF = diffMetricsU + n;
+  tArray = diffMetricsUF + n;
+  diffMetricsN = (double *)(tArray + n);
+  dupArray = (int *)(diffMetricsN + n);
+  lowest = dupArray + n;
+  match = lowest + n;
+  filmd2v = match + n;
+  decimate = filmd2v + n;
+  decimate2 = decimate + n;
+  dect = decimate2 + n;
+  dect2 = dect + n;
   return true;
 }
 
@@ -527,35 +514,65 @@ void Cycle::setSize(int _size)
   }
 }
 
-Cycle& Cycle::operator=(Cycle& ob2)
+// Exchanges the whole state with ob2, the arrays by pointer.
+void Cycle::swap(Cycle& ob2)
+{
+  std::swap(cycleSize, ob2.cycleSize);
+  std::swap(sdlim, ob2.sdlim);
+  std::swap(length, ob2.length);
+  std::swap(maxFrame, ob2.maxFrame);
+  std::swap(frame, ob2.frame);
+  std::swap(frameE, ob2.frameE);
+  std::swap(offE, ob2.offE);
+  std::swap(cycleS, ob2.cycleS);
+  std::swap(cycleE, ob2.cycleE);
+  std::swap(frameSO, ob2.frameSO);
+  std::swap(frameEO, ob2.frameEO);
+  std::swap(type, ob2.type);
+  std::swap(dupsSet, ob2.dupsSet);
+  std::swap(mSet, ob2.mSet);
+  std::swap(lowSet, ob2.lowSet);
+  std::swap(decSet, ob2.decSet);
+  std::swap(isfilmd2v, ob2.isfilmd2v);
+  std::swap(dupCount, ob2.dupCount);
+  std::swap(blend, ob2.blend);
+  std::swap(arena, ob2.arena);
+  std::swap(diffMetricsN, ob2.diffMetricsN);
+  std::swap(diffMetricsU, ob2.diffMetricsU);
+  std::swap(diffMetricsUF, ob2.diffMetricsUF);
+  std::swap(tArray, ob2.tArray);
+  std::swap(dupArray, ob2.dupArray);
+  std::swap(lowest, ob2.lowest);
+  std::swap(decimate, ob2.decimate);
+  std::swap(decimate2, ob2.decimate2);
+  std::swap(match, ob2.match);
+  std::swap(filmd2v, ob2.filmd2v);
+  std::swap(dect, ob2.dect);
+  std::swap(dect2, ob2.dect2);
+}
+
+// Marks the contents stale: the next setFrame() clears them whatever frame it gets.
+void Cycle::invalidate()
+{
+  mSet = lowSet = dupsSet = decSet = false;
+  frame = INT_MIN;
+}
+
+// prev <- curr <- next <- nbuf, the old prev is recycled as the new nbuf.
+// Same result as the former prev = curr; curr = next; next = nbuf; copies
+// followed by nbuf.setFrame(), without copying any of the arrays.
+void Cycle::rotate(Cycle& prev, Cycle& curr, Cycle& next, Cycle& nbuf)
+{
+  prev.swap(curr); // prev = curr, curr = old prev
+  curr.swap(next); // curr = next, next = old prev
+  next.swap(nbuf); // next = nbuf, nbuf = old prev
+  nbuf.invalidate();
+}
+
+// prev <- curr <- next, the old prev is recycled as the new next.
+void Cycle::rotate(Cycle& prev, Cycle& curr, Cycle& next)
 {
-  length = ob2.length;
-  maxFrame = ob2.maxFrame;
-  frame = ob2.frame;
-  frameE = ob2.frameE;
-  offE = ob2.offE;
-  cycleS = ob2.cycleS;
-  cycleE = ob2.cycleE;
-  frameSO = ob2.frameSO;
-  frameEO = ob2.frameEO;
-  type = ob2.type;
-  dupsSet = ob2.dupsSet;
-  mSet = ob2.mSet;
-  lowSet = ob2.lowSet;
-  decSet = ob2.decSet;
-  dupCount = ob2.dupCount;
-  blend = ob2.blend;
-  isfilmd2v = ob2.isfilmd2v;
-  cycleSize = std::min(cycleSize, ob2.cycleSize);
-  if (length > cycleSize) length = cycleSize;
-  memcpy(dupArray, ob2.dupArray, cycleSize * sizeof(int));
-  memcpy(lowest, ob2.lowest, cycleSize * sizeof(int));
-  memcpy(match, ob2.match, cycleSize * sizeof(int));
-  memcpy(filmd2v, ob2.filmd2v, cycleSize * sizeof(int));
-  memcpy(decimate, ob2.decimate, cycleSize * sizeof(int));
-  memcpy(decimate2, ob2.decimate2, cycleSize * sizeof(int));
-  memcpy(diffMetricsU, ob2.diffMetricsU, cycleSize * sizeof(uint64_t));
-  memcpy(diffMetricsUF, ob2.diffMetricsUF, cycleSize * sizeof(uint64_t));
-  memcpy(diffMetricsN, ob2.diffMetricsN, cycleSize * sizeof(double));
-  return *this;
-}
\ No newline at end of file
+  prev.swap(curr);
+  curr.swap(next);
+  next.invalidate();
+}
@@ -59,6 +59,7 @@ class Cycle
 {
 private:
   int cycleSize;
+  uint8_t *arena; // one allocation holding all the per frame arrays below
   bool allocSpace();
   bool checkMatchDup(int mp, int mc);
 
@@ -107,8 +108,14 @@ public:
   void debugOutput();
   void debugMetrics(int length);
 
+  void swap(Cycle &ob2);
+  void invalidate();
+  static void rotate(Cycle &prev, Cycle &curr, Cycle &next, Cycle &nbuf);
+  static void rotate(Cycle &prev, Cycle &curr, Cycle &next);
+
   Cycle(int _size, int _sdlim);
   void setSize(int _size);
   ~Cycle();
-  Cycle& operator=(Cycle& ob2);
+  Cycle(const Cycle&) = delete;
+  Cycle& operator=(const Cycle&) = delete;
 };
\ No newline at end of file
@@ -370,6 +370,7 @@ void FrameDiff::calcMetric(PVideoFrame &prevt, PVideoFrame &currt, const VideoIn
   d.diff = diff;
   d.nt = nt;
   d.ssd = ssd;
+  d.scratch = &metricScratch;
 
   d.metricF_needed = false;
   // only for TDecimate:
@@ -387,10 +388,14 @@ void CalcMetricsExtracted(IScriptEnvironment* env, PVideoFrame& prevt, PVideoFra
 
   if (d.predenoise)
   {
-    prev = env->NewVideoFrame(d.vi);
-    curr = env->NewVideoFrame(d.vi);
-    blurFrame(prevt, prev, 2, d.chroma, env, d.vi, d.cpuFlags);
-    blurFrame(currt, curr, 2, d.chroma, env, d.vi, d.cpuFlags);
+    PVideoFrame& prevb = d.scratch->prev.get(d.vi, env);
+    PVideoFrame& currb = d.scratch->curr.get(d.vi, env);
+    PVideoFrame& tmp = d.scratch->blurtmp.get(d.vi, env);
+    blurFrame(prevt, prevb, tmp, 2, d.chroma, d.vi, d.cpuFlags);
+    blurFrame(currt, currb, tmp, 2, d.chroma, d.vi, d.cpuFlags);
+    // read only from here
+    prev = prevb;
+    curr = currb;
   }
   else
   {
@@ -436,18 +441,18 @@ void CalcMetricsExtracted(IScriptEnvironment* env, PVideoFrame& prevt, PVideoFra
     if (pixelsize == 1 && d.blockx == 32 && d.blocky == 32 && d.nt <= 0)
     {
       if (d.ssd && use_sse2)
-        calcDiffSSD_32x32_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.vi);
+        calcDiffSSD_32x32_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.vi, d.cpuFlags);
       else if (!d.ssd && use_sse2)
-        calcDiffSAD_32x32_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.vi);
+        calcDiffSAD_32x32_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.vi, d.cpuFlags);
       else { goto use_c; }
     }
     else if (pixelsize == 1 && ((!IsYUY2 && d.blockx >= 16 && d.blocky >= 16) || (IsYUY2 && d.blockx >= 8 && d.blocky >= 8)) && d.nt <= 0)
     {
       // YUY2 block size 8 is really 16 in width because luma + chroma
       if (d.ssd && use_sse2)
-        calcDiffSSD_Generic_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.blockx_shift, d.blocky_shift, d.blockx_half, d.blocky_half, d.vi);
+        calcDiffSSD_Generic_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.blockx_shift, d.blocky_shift, d.blockx_half, d.blocky_half, d.vi, d.cpuFlags);
       else if (!d.ssd && use_sse2)
-        calcDiffSAD_Generic_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.blockx_shift, d.blocky_shift, d.blockx_half, d.blocky_half, d.vi);
+        calcDiffSAD_Generic_SSE2(prvp, curp, prv_pitch, cur_pitch, width, height, plane, xblocks4, d.diff, d.chroma, d.blockx_shift, d.blocky_shift, d.blockx_half, d.blocky_half, d.vi, d.cpuFlags);
       else { goto use_c; }
     }
     else
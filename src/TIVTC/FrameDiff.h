@@ -43,6 +43,7 @@ private:
 
   char buf[512];
   bool predenoise, ssd, rpos;
+  MetricScratch metricScratch;
   int nt, nfrms, blockx, blocky, mode, display;
   double thresh;
   int opt;
@@ -53,7 +53,7 @@ AVSValue __cdecl Create_IsCombedTIVTC(AVSValue args, void* user_data, IScriptEnv
   TFM *f = new TFM(args[0].AsClip(), -1, -1, 1, 5, "", "", "", "", false, false, false, false,
     15, args[1].AsInt(9), args[2].AsInt(80), chroma, args[4].AsInt(16),
     args[5].AsInt(16), 0, 0, "", 0, 0, 12.0, 0, 0, "", false, args[6].AsInt(0), false, false, false,
-    args[7].AsInt(4), env);
+    args[7].AsInt(4), args[8].AsBool(false), "", env);
   AVSValue IsCombedTIVTC = f->ConditionalIsCombedTIVTC(n, env);
   delete f;
   return IsCombedTIVTC;
@@ -73,7 +73,7 @@ private:
 
   char buf[512];
   int cthresh, MI, blockx, blocky, display, opt, metric;
-  bool debug, chroma, fill;
+  bool debug, chroma, fill, mcascade;
   int yhalf, xhalf, yshift, xshift, nfrms, *cArray;
   PlanarFrame *cmask;
   void fillCombedYUY2(PVideoFrame &src, int &MICount,
@@ -89,16 +89,16 @@ public:
   PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment *env) override;
   ShowCombedTIVTC(PClip _child, int _cthresh, bool _chroma, int _MI,
     int _blockx, int _blocky, int _metric, bool _debug, int _display, bool _fill,
-    int _opt, IScriptEnvironment *env);
+    int _opt, bool _mcascade, IScriptEnvironment *env);
   ~ShowCombedTIVTC();
 };
 
 ShowCombedTIVTC::ShowCombedTIVTC(PClip _child, int _cthresh, bool _chroma, int _MI,
   int _blockx, int _blocky, int _metric, bool _debug, int _display, bool _fill,
-  int _opt, IScriptEnvironment *env) : GenericVideoFilter(_child),
+  int _opt, bool _mcascade, IScriptEnvironment *env) : GenericVideoFilter(_child),
   cthresh(_cthresh), MI(_MI), blockx(_blockx), blocky(_blocky),
   display(_display), opt(_opt), metric(_metric),
-  debug(_debug), chroma(_chroma), fill(_fill)
+  debug(_debug), chroma(_chroma), fill(_fill), mcascade(_mcascade)
 {
   cArray = NULL;
   cmask = NULL;
@@ -345,7 +345,18 @@ void ShowCombedTIVTC::fillCombedYUY2(PVideoFrame &src, int &MICount,
     srcpn += src_pitch;
     cmkw += cmk_pitch;
     // middle
-    if (use_sse2)
+    if (use_sse2 && mcascade)
+    {
+      if (chroma)
+        check_combing_SSE2_Metric1_Cascade(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthresh);
+      else
+        check_combing_SSE2_Luma_Metric1_Cascade(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthresh);
+      srcpp += src_pitch * (Height - 2);
+      srcp += src_pitch * (Height - 2);
+      srcpn += src_pitch * (Height - 2);
+      cmkw += cmk_pitch * (Height - 2);
+    }
+    else if (use_sse2)
     {
       if (chroma)
         check_combing_SSE2_Metric1(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthreshsq);
@@ -410,38 +421,32 @@ cjump:
       cmkpn += cmk_pitch;
     }
   }
-  const uint8_t *cmkp = cmask->GetPtr() + cmk_pitch;
-  const uint8_t *cmkpp = cmkp - cmk_pitch;
-  const uint8_t *cmkpn = cmkp + cmk_pitch;
   memset(cArray, 0, arraysize * sizeof(int));
   env->MakeWritable(&src);
-  uint8_t *dstp = src->GetWritePtr();
-  const int dst_pitch = src->GetPitch();
-  dstp += dst_pitch;
-  c_over = 0;
-  for (int y = 1; y < Height - 1; ++y)
+
+  // only the luma bytes of the mask are counted, combed chroma has been moved to them above
+  c_over = accumulateCombedBlocks(cmask->GetPtr(), cmk_pitch, Width, Height, xhalf, xshift, yhalf, yshift, cArray, true, cpuFlags);
+
+  if (c_over > 0 && (display == 0 || (display > 2 && display != 5)))
   {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    for (int x = 0; x < Width; x += 2)
+    uint8_t *dstp = src->GetWritePtr();
+    const int dst_pitch = src->GetPitch();
+    dstp += dst_pitch;
+    const uint8_t *cmkpp = cmask->GetPtr();
+    const uint8_t *cmkp = cmkpp + cmk_pitch;
+    const uint8_t *cmkpn = cmkp + cmk_pitch;
+    for (int y = 1; y < Height - 1; ++y)
     {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
+      for (int x = 0; x < Width; x += 2)
       {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-        ++c_over;
-        if (display == 0 || (display > 2 && display != 5))
+        if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
           dstp[x] = 0xFF;
       }
+      cmkpp += cmk_pitch;
+      cmkp += cmk_pitch;
+      cmkpn += cmk_pitch;
+      dstp += dst_pitch;
     }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-    dstp += dst_pitch;
   }
 
   MICount = -1;
@@ -477,11 +482,11 @@ void ShowCombedTIVTC::fillCombedPlanar(const VideoInfo& vi, PVideoFrame& src, in
 {
   const int bits_per_pixel = vi.BitsPerComponent();
   if (vi.ComponentSize() == 1) {
-    checkCombedPlanarAnalyze_core<uint8_t>(vi, cthresh, chroma, cpuFlags, metric, src, cmask);
+    checkCombedPlanarAnalyze_core<uint8_t>(vi, cthresh, chroma, cpuFlags, metric, mcascade, src, cmask);
     fillCombedPlanar_core<uint8_t>(src, MICount, b_over, c_over, bits_per_pixel, env);
   }
   else {
-    checkCombedPlanarAnalyze_core<uint16_t>(vi, cthresh, chroma, cpuFlags, metric, src, cmask);
+    checkCombedPlanarAnalyze_core<uint16_t>(vi, cthresh, chroma, cpuFlags, metric, mcascade, src, cmask);
     fillCombedPlanar_core<uint16_t>(src, MICount, b_over, c_over, bits_per_pixel, env);
   }
 }
@@ -493,9 +498,7 @@ void ShowCombedTIVTC::fillCombedPlanar_core(PVideoFrame &src, int &MICount,
 {
 
   const int cmk_pitch = cmask->GetPitch(0);
-  const uint8_t *cmkp = cmask->GetPtr(0) + cmk_pitch;
-  const uint8_t *cmkpp = cmkp - cmk_pitch;
-  const uint8_t *cmkpn = cmkp + cmk_pitch;
+  const uint8_t *cmkp = cmask->GetPtr(0);
   const int Width = cmask->GetWidth(0);
   const int Height = cmask->GetHeight(0);
   const int xblocks = ((Width + xhalf) >> xshift) + 1;
@@ -506,35 +509,30 @@ void ShowCombedTIVTC::fillCombedPlanar_core(PVideoFrame &src, int &MICount,
 
   env->MakeWritable(&src);
 
-  // hbd OK
-  const int max_pixel_value = (1 << bits_per_pixel) - 1;
-  pixel_t *dstp = reinterpret_cast<pixel_t *>(src->GetWritePtr(PLANAR_Y));
-  const int dst_pitch = src->GetPitch(PLANAR_Y) / sizeof(pixel_t);
-  dstp += dst_pitch;
-  c_over = 0;
-  for (int y = 1; y < Height - 1; ++y)
+  c_over = accumulateCombedBlocks(cmkp, cmk_pitch, Width, Height, xhalf, xshift, yhalf, yshift, cArray, false, cpuFlags);
+
+  if (c_over > 0 && (display == 0 || (display > 2 && display != 5)))
   {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    for (int x = 0; x < Width; ++x)
+    // hbd OK
+    const int max_pixel_value = (1 << bits_per_pixel) - 1;
+    pixel_t *dstp = reinterpret_cast<pixel_t *>(src->GetWritePtr(PLANAR_Y));
+    const int dst_pitch = src->GetPitch(PLANAR_Y) / sizeof(pixel_t);
+    dstp += dst_pitch;
+    const uint8_t *cmkpp = cmkp;
+    cmkp += cmk_pitch;
+    const uint8_t *cmkpn = cmkp + cmk_pitch;
+    for (int y = 1; y < Height - 1; ++y)
     {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
+      for (int x = 0; x < Width; ++x)
       {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-        ++c_over;
-        if (display == 0 || (display > 2 && display != 5))
+        if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
           dstp[x] = max_pixel_value;
       }
+      cmkpp += cmk_pitch;
+      cmkp += cmk_pitch;
+      cmkpn += cmk_pitch;
+      dstp += dst_pitch;
     }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-    dstp += dst_pitch;
   }
 
   MICount = -1;
@@ -573,7 +571,8 @@ AVSValue __cdecl Create_ShowCombedTIVTC(AVSValue args, void* user_data, IScriptE
 
   return new ShowCombedTIVTC(args[0].AsClip(), args[1].AsInt(9), chroma,
     args[3].AsInt(80), args[4].AsInt(16), args[5].AsInt(16), args[6].AsInt(0),
-    args[7].AsBool(false), args[8].AsInt(3), args[9].AsBool(false), args[10].AsInt(4), env);
+    args[7].AsBool(false), args[8].AsInt(3), args[9].AsBool(false), args[10].AsInt(4),
+    args[11].AsBool(false), env);
 }
 
 // These are just copied from TFMASM.cpp.  One day I'll make it
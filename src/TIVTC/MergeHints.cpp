@@ -25,6 +25,7 @@
 
 #include "MergeHints.h"
 #include "avisynth.h"
+#include "hintprop.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -42,6 +43,9 @@ MergeHints::MergeHints(PClip _child, PClip _hintClip, bool _debug, IScriptEnviro
     env->ThrowError("MergeHints:  only YUV input supported!");
   child->SetCacheHints(CACHE_NOTHING, 0);
   hintClip->SetCacheHints(CACHE_NOTHING, 0);
+  has_at_least_v8 = true;
+  try { env->CheckVersion(8); }
+  catch (const AvisynthError&) { has_at_least_v8 = false; }
   if (debug)
   {
     sprintf(buf, "MergeHints:  %s by tritical\n", VERSION);
@@ -58,6 +62,18 @@ PVideoFrame __stdcall MergeHints::GetFrame(int n, IScriptEnvironment *env)
 {
   PVideoFrame hnt = hintClip->GetFrame(n, env);
   unsigned int i, magic_number = 0, hint = 0;
+  if (has_at_least_v8 && getPropHint(hnt, hint, env))
+  {
+    // hint as frame property (TFM passthrough): hand it over, no pixel copy
+    if (debug)
+    {
+      sprintf(buf, "MergeHints:  identifier = frame property (TIVTC)  hint = %#x\n", hint);
+      OutputDebugString(buf);
+    }
+    PVideoFrame src = shareFrame(child->GetFrame(n, env), vi, env);
+    setPropHint(src, hint, env);
+    return src;
+  }
   if (vi.ComponentSize() == 1) {
     const uint8_t* hntp = hnt->GetReadPtr(PLANAR_Y);
     for (i = 0; i < 32; ++i) magic_number |= ((*hntp++ & 1) << i);
@@ -78,6 +94,7 @@ PVideoFrame __stdcall MergeHints::GetFrame(int n, IScriptEnvironment *env)
   }
   PVideoFrame src = child->GetFrame(n, env);
   env->MakeWritable(&src);
+  if (has_at_least_v8) clearPropHint(src, env);
   if (vi.ComponentSize() == 1) {
     uint8_t* dstp = src->GetWritePtr(PLANAR_Y);
     for (i = 0; i < 32; ++i)
@@ -33,6 +33,7 @@ private:
   char buf[512];
   PClip hintClip;
   bool debug;
+  bool has_at_least_v8;
 
 public:
   MergeHints(PClip _child, PClip _hintClip, bool _debug, IScriptEnvironment *env);
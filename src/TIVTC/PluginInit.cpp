@@ -56,7 +56,7 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
     "[debug]b[display]b[slow]i[mChroma]b[cNum]i[cthresh]i[MI]i" \
     "[chroma]b[blockx]i[blocky]i[y0]i[y1]i[mthresh]i[clip2]c[d2v]s" \
     "[ovrDefault]i[flags]i[scthresh]f[micout]i[micmatching]i[trimIn]s" \
-    "[hint]b[metric]i[batch]b[ubsco]b[mmsco]b[opt]i", Create_TFM, 0);
+    "[hint]b[metric]i[batch]b[ubsco]b[mmsco]b[opt]i[mcascade]b[analysis]s", Create_TFM, 0);
   env->AddFunction("TDecimate", "c[mode]i[cycleR]i[cycle]i[rate]f[dupThresh]f[vidThresh]f" \
     "[sceneThresh]f[hybrid]i[vidDetect]i[conCycle]i[conCycleTP]i" \
     "[ovr]s[output]s[input]s[tfmIn]s[mkvOut]s[nt]i[blockx]i" \
@@ -72,9 +72,9 @@ AvisynthPluginInit3(IScriptEnvironment* env, const AVS_Linkage* const vectors) {
   env->AddFunction("CFrameDiff", "c[mode]i[prevf]b[nt]i[blockx]i[blocky]i[chroma]b[debug]b" \
     "[norm]b[denoise]b[ssd]b[rpos]b[opt]i", Create_CFrameDiff, 0);
   env->AddFunction("ShowCombedTIVTC", "c[cthresh]i[chroma]b[MI]i[blockx]i[blocky]i[metric]i" \
-    "[debug]b[display]i[fill]b[opt]i", Create_ShowCombedTIVTC, 0);
+    "[debug]b[display]i[fill]b[opt]i[mcascade]b", Create_ShowCombedTIVTC, 0);
   env->AddFunction("IsCombedTIVTC", "c[cthresh]i[MI]i[chroma]b[blockx]i[blocky]i[metric]i" \
-    "[opt]i", Create_IsCombedTIVTC, 0);
+    "[opt]i[mcascade]b", Create_IsCombedTIVTC, 0);
   env->AddFunction("RequestLinear", "c[rlim]i[clim]i[elim]i[rall]b[debug]b",
     Create_RequestLinear, 0);
   return 0;
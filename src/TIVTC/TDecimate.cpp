@@ -29,7 +29,14 @@
 #include "TCommonASM.h"
 #include <inttypes.h>
 #include <algorithm>
+#include <cstdarg>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include "info.h"
+#include "hintprop.h"
 
 PVideoFrame __stdcall TDecimate::GetFrame(int n, IScriptEnvironment *env)
 {
@@ -47,7 +54,14 @@ PVideoFrame __stdcall TDecimate::GetFrame(int n, IScriptEnvironment *env)
   else if (mode == 7) dst = GetFrameMode7(n, env, vi2); // arbitrary framerate v2
   else env->ThrowError("TDecimate:  unknown error (no such mode)!");
   if (usehints) {
-    if (vi.ComponentSize() == 1)
+    unsigned int prop_hint;
+    if (has_at_least_v8 && getPropHint(dst, prop_hint, env))
+    {
+      // hint came as frame property, the pixels are the original ones
+      dst = shareFrame(dst, vi, env);
+      clearPropHint(dst, env);
+    }
+    else if (vi.ComponentSize() == 1)
       restoreHint<uint8_t>(dst, env);
     else
       restoreHint<uint16_t>(dst, env);
@@ -106,7 +120,7 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
   if (ecf) child->SetCacheHints(EvalGroup, -20);
   if (curr.frame != EvalGroup)
   {
-    prev = curr;
+    Cycle::rotate(prev, curr, next, nbuf); // prev = curr, curr = next, next = nbuf
     if (prev.frame != EvalGroup - cycle)
     {
       prev.setFrame(EvalGroup - cycle);
@@ -119,7 +133,6 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
       }
       if (*output) addMetricCycle(prev);
     }
-    curr = next;
     if (curr.frame != EvalGroup)
     {
       curr.setFrame(EvalGroup);
@@ -132,7 +145,6 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
       }
       if (*output) addMetricCycle(curr);
     }
-    next = nbuf;
     if (next.frame != EvalGroup + cycle)
       next.setFrame(EvalGroup + cycle);
     getOvrCycle(next, false);
@@ -269,8 +281,6 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
       }
       else
       {
-        dst = env->NewVideoFrame(vi2);
-
         if (!useclip2) {
           PVideoFrame frame1 = child->GetFrame(f1, env);
           PVideoFrame frame2 = child->GetFrame(f2, env);
@@ -281,6 +291,7 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
           PVideoFrame frame2 = clip2->GetFrame(f2, env);
           blendFrames(frame1, frame2, dst, a1, vi2, env);
         }
+        if (display) env->MakeWritable(&dst);
       }
       if (debug) debugOutput2(n, 0, true, f1, f2, a1, a2);
       if (display) displayOutput(env, dst, n, 0, true, a1, a2, f1, f2, vi2);
@@ -335,7 +346,7 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
 
     if (f1 != 0)
     {
-      PVideoFrame dst = env->NewVideoFrame(vi2);
+      PVideoFrame dst;
       if (!useclip2)
       {
         PVideoFrame frame1 = child->GetFrame(f1, env);
@@ -346,8 +357,9 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
       {
         PVideoFrame frame1 = clip2->GetFrame(f1, env);
         PVideoFrame frame2 = clip2->GetFrame(f2, env);
-        blendFrames(frame1, frame2, dst, a1, vi, env);
+        blendFrames(frame1, frame2, dst, a1, vi2, env);
       }
+      if (display) env->MakeWritable(&dst);
       if (display) displayOutput(env, dst, n, 0, true, a1, a2, f1, f2, vi2);
       if (debug) debugOutput2(n, 0, true, f1, f2, a1, a2);
       return dst;
@@ -428,8 +440,6 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
       }
       else
       {
-        dst = env->NewVideoFrame(vi2);
-
         if (!useclip2) {
           PVideoFrame frame1 = child->GetFrame(f1, env);
           PVideoFrame frame2 = child->GetFrame(f2, env);
@@ -440,6 +450,7 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
           PVideoFrame frame2 = clip2->GetFrame(f2, env);
           blendFrames(frame1, frame2, dst, a1, vi2, env);
         }
+        if (display) env->MakeWritable(&dst);
       }
       if (debug) debugOutput2(n, 0, true, f1, f2, a1, a2);
       if (display) displayOutput(env, dst, n, 0, true, a1, a2, f1, f2, vi2);
@@ -505,7 +516,6 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
     }
     else
     {
-      dst = env->NewVideoFrame(vi2);
       if (!useclip2) {
         PVideoFrame frame1 = child->GetFrame(f1, env);
         PVideoFrame frame2 = child->GetFrame(f2, env);
@@ -516,6 +526,7 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
         PVideoFrame frame2 = clip2->GetFrame(f2, env);
         blendFrames(frame1, frame2, dst, a1, vi2, env);
       }
+      if (display) env->MakeWritable(&dst);
     }
 
     if (debug) debugOutput2(n, 0, false, f1, f2, a1, a2);
@@ -526,16 +537,10 @@ PVideoFrame TDecimate::GetFrameMode01(int n, IScriptEnvironment* env, const Vide
 
 PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const VideoInfo &vi)
 {
-  static int vidC = 0;
-  static int filmC = 0;
-  static int longestT = 0;
-  static int longestV = 0;
-  static int countVT = 0;
-  static double timestamp = 0.0;
   if (n == 0)
   {
-    vidC = filmC = longestT = longestV = countVT = 0;
-    timestamp = 0.0;
+    mode3_vidC = mode3_filmC = mode3_longestT = mode3_longestV = mode3_countVT = 0;
+    mode3_timestamp = 0.0;
   }
   if (linearCount != n) env->ThrowError("TDecimate:  non-linear access detected in mode 3!");
   ++linearCount;
@@ -544,7 +549,7 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
     lastGroup = n;
     lastCycle += cycle;
     if (ecf) child->SetCacheHints(lastCycle, -20);
-    prev = curr;
+    Cycle::rotate(prev, curr, next, nbuf); // prev = curr, curr = next, next = nbuf
     if (prev.frame != lastCycle - cycle)
     {
       prev.setFrame(lastCycle - cycle);
@@ -554,7 +559,6 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
       checkVideoMetrics(prev, vidThresh);
       if (*output) addMetricCycle(prev);
     }
-    curr = next;
     if (curr.frame != lastCycle)
     {
       curr.setFrame(lastCycle);
@@ -564,7 +568,6 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
       checkVideoMetrics(curr, vidThresh);
       if (*output) addMetricCycle(curr);
     }
-    next = nbuf;
     if (next.frame != lastCycle + cycle)
       next.setFrame(lastCycle + cycle);
     getOvrCycle(next, false);
@@ -587,15 +590,15 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
       (vidDetect == 2 && (isVid2 || isVid)) || (vidDetect == 3 && (isVid2 && isVid)))
     {
       retFrames = cycle;
-      vidC += (curr.frame + cycle <= nfrms ? cycle : nfrms - curr.frame + 1);
-      longestT += (curr.frame + cycle <= nfrms ? cycle : nfrms - curr.frame + 1);
+      mode3_vidC += (curr.frame + cycle <= nfrms ? cycle : nfrms - curr.frame + 1);
+      mode3_longestT += (curr.frame + cycle <= nfrms ? cycle : nfrms - curr.frame + 1);
       if (!tcfv1)
       {
         int stop = (lastCycle + cycle <= nfrms ? cycle : nfrms - lastCycle + 1);
         for (int u = 0; u < stop; ++u)
         {
-          fprintf(mkvOutF, "%3.6f\n", timestamp);
-          timestamp += 1000.0 / fps;
+          fprintf(mkvOutF, "%3.6f\n", mode3_timestamp);
+          mode3_timestamp += 1000.0 / fps;
         }
       }
     }
@@ -612,12 +615,12 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
         next.setDups(dupThresh);
         findDupStrings(prev, curr, next, env);
       }
-      filmC += (curr.frame + cycle <= nfrms ? cycle : nfrms - curr.frame + 1);
+      mode3_filmC += (curr.frame + cycle <= nfrms ? cycle : nfrms - curr.frame + 1);
       if (retFrames == cycle)
       {
-        if (longestT > longestV) longestV = longestT;
-        ++countVT;
-        longestT = 0;
+        if (mode3_longestT > mode3_longestV) mode3_longestV = mode3_longestT;
+        ++mode3_countVT;
+        mode3_longestT = 0;
       }
       if (curr.blend != 3)
       {
@@ -626,8 +629,8 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
           int stop = (lastCycle + cycle <= nfrms ? cycle - cycleR : nfrms - lastCycle + 1 - cycleR);
           for (int u = 0; u < stop; ++u)
           {
-            fprintf(mkvOutF, "%3.6f\n", timestamp);
-            timestamp += 1000.0 / mkvfps;
+            fprintf(mkvOutF, "%3.6f\n", mode3_timestamp);
+            mode3_timestamp += 1000.0 / mkvfps;
           }
         }
         retFrames = cycle - cycleR;
@@ -641,8 +644,8 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
           int stop = (lastCycle + cycle <= nfrms ? cycle - cycleR - 1 : nfrms - lastCycle + 1 - cycleR - 1);
           for (int u = 0; u < stop; ++u)
           {
-            fprintf(mkvOutF, "%3.6f\n", timestamp);
-            timestamp += 1000.0 / mkvfps2;
+            fprintf(mkvOutF, "%3.6f\n", mode3_timestamp);
+            mode3_timestamp += 1000.0 / mkvfps2;
           }
         }
         else fprintf(mkvOutF, "%d,%d,%4.6f\n", lastGroup, lastGroup + cycle - cycleR - 2, mkvfps2);
@@ -736,12 +739,12 @@ PVideoFrame TDecimate::GetFrameMode3(int n, IScriptEnvironment *env, const Video
   }
   if (retFrames == -1 && mkvOutF != NULL)
   {
-    double filmCf = ((double)(filmC) / (double)(nfrms + 1))*100.0;
-    double videoCf = ((double)(vidC) / (double)(nfrms + 1))*100.0;
+    double filmCf = ((double)(mode3_filmC) / (double)(nfrms + 1))*100.0;
+    double videoCf = ((double)(mode3_vidC) / (double)(nfrms + 1))*100.0;
     fprintf(mkvOutF, "# vfr stats:  %05.2f%c film  %05.2f%c video\n", filmCf, '%', videoCf, '%');
-    fprintf(mkvOutF, "# vfr stats:  %d - film  %d - video  %d - total\n", filmC, vidC, nfrms + 1);
-    fprintf(mkvOutF, "# vfr stats:  longest vid section - %d frames\n", longestV);
-    fprintf(mkvOutF, "# vfr stats:  # of detected vid sections - %d", countVT);
+    fprintf(mkvOutF, "# vfr stats:  %d - film  %d - video  %d - total\n", mode3_filmC, mode3_vidC, nfrms + 1);
+    fprintf(mkvOutF, "# vfr stats:  longest vid section - %d frames\n", mode3_longestV);
+    fprintf(mkvOutF, "# vfr stats:  # of detected vid sections - %d", mode3_countVT);
     fclose(mkvOutF);
     mkvOutF = NULL;
   }
@@ -871,7 +874,7 @@ void TDecimate::rerunFromStart(int s, const VideoInfo &vi, IScriptEnvironment *e
   int EvalGroup = 0;
   while (EvalGroup < s)
   {
-    prev = curr;
+    Cycle::rotate(prev, curr, next); // prev = curr, curr = next
     if (prev.frame != EvalGroup - cycle)
     {
       prev.setFrame(EvalGroup - cycle);
@@ -883,7 +886,6 @@ void TDecimate::rerunFromStart(int s, const VideoInfo &vi, IScriptEnvironment *e
         checkVideoMetrics(prev, vidThresh);
       }
     }
-    curr = next;
     if (curr.frame != EvalGroup)
     {
       curr.setFrame(EvalGroup);
@@ -983,10 +985,10 @@ void TDecimate::calcMetricPreBuf(int n1, int n2, int pos, const VideoInfo &vit,
     {
       if (!src) {
         PVideoFrame frame = child->GetFrame(n2, env);
-        nbuf.match[pos] = getHint(vit, frame, nbuf.filmd2v[pos]);
+        nbuf.match[pos] = getHint(vit, frame, nbuf.filmd2v[pos], env);
       }
       else {
-        nbuf.match[pos] = getHint(vit, src, nbuf.filmd2v[pos]);
+        nbuf.match[pos] = getHint(vit, src, nbuf.filmd2v[pos], env);
       }
     }
   }
@@ -1012,6 +1014,7 @@ uint64_t TDecimate::calcMetric(PVideoFrame &prevt, PVideoFrame &currt, const Vid
   d.diff = diff;
   d.nt = nt;
   d.ssd = ssd;
+  d.scratch = &metricScratch;
 
   d.metricF_needed = true;
   d.metricF = &metricF;
@@ -1059,11 +1062,9 @@ void TDecimate::calcMetricCycle(Cycle &current, IScriptEnvironment *env, const V
   int next_num = -20, next_numd = -20;
 
   PVideoFrame prev, next, prevt, nextt;
-  if (predenoise)
-  {
-    prev = env->NewVideoFrame(vit);
-    next = env->NewVideoFrame(vit);
-  }
+  // predenoise: the blurred frames are the instance's work frames, swapped instead of copied
+  // (fetched on first use, cycles with known metrics don't touch them)
+  PVideoFrame* prevp = &prev, * nextp = &next;
 
   for (w = current.frameSO, i = current.cycleS; i < current.cycleE; ++i, ++w)
   {
@@ -1081,12 +1082,17 @@ void TDecimate::calcMetricCycle(Cycle &current, IScriptEnvironment *env, const V
           {
             nextt = child->GetFrame(w, env);
             next_num = w;
-            current.match[i] = getHint(vit, nextt, current.filmd2v[i]); // hints: vit not vi (are they different?)
+            current.match[i] = getHint(vit, nextt, current.filmd2v[i], env); // hints: vit not vi (are they different?)
           }
         }
         continue;
       }
       
+      if (prevp == &prev)
+      {
+        prevp = &metricScratch.prev.get(vit, env);
+        nextp = &metricScratch.curr.get(vit, env);
+      }
       if (next_num == w - 1) 
         prevt = nextt;
       else 
@@ -1097,14 +1103,15 @@ void TDecimate::calcMetricCycle(Cycle &current, IScriptEnvironment *env, const V
       if (current.match[i] == -20 && hnt)
       {
         if (!usehints) current.match[i] = -200;
-        else current.match[i] = getHint(vit, nextt, current.filmd2v[i]);
+        else current.match[i] = getHint(vit, nextt, current.filmd2v[i], env);
       }
+      PVideoFrame& tmp = metricScratch.blurtmp.get(vit, env);
       if (next_numd == w - 1) 
-        copyFrame(prev, next, vit, env);
+        std::swap(prevp, nextp);
       else 
-        blurFrame(prevt, prev, 2, chroma, env, vit, opt);
+        blurFrame(prevt, *prevp, tmp, 2, chroma, vit, opt);
       
-      blurFrame(nextt, next, 2, chroma, env, vit, opt);
+      blurFrame(nextt, *nextp, tmp, 2, chroma, vit, opt);
       next_numd = w;
     }
     else
@@ -1119,7 +1126,7 @@ void TDecimate::calcMetricCycle(Cycle &current, IScriptEnvironment *env, const V
           {
             next = child->GetFrame(w, env);
             next_num = w;
-            current.match[i] = getHint(vit, next, current.filmd2v[i]);
+            current.match[i] = getHint(vit, next, current.filmd2v[i], env);
           }
         }
         continue;
@@ -1133,7 +1140,7 @@ void TDecimate::calcMetricCycle(Cycle &current, IScriptEnvironment *env, const V
       if (current.match[i] == -20 && hnt)
       {
         if (!usehints) current.match[i] = -200;
-        else current.match[i] = getHint(vit, next, current.filmd2v[i]);
+        else current.match[i] = getHint(vit, next, current.filmd2v[i], env);
       }
     }
 
@@ -1158,7 +1165,7 @@ void TDecimate::calcMetricCycle(Cycle &current, IScriptEnvironment *env, const V
     d.metricF = &current.diffMetricsUF[i];
     d.scene = scene;
 
-    CalcMetricsExtracted(env, prev, next, d);
+    CalcMetricsExtracted(env, *prevp, *nextp, d);
 
     int xblocks = ((d.vi.width + d.blockx_half) >> d.blockx_shift) + 1;
     int yblocks = ((d.vi.height + d.blocky_half) >> d.blocky_shift) + 1;
@@ -1246,30 +1253,20 @@ uint64_t calcLumaDiffYUY2_SSD(const uint8_t* prvp, const uint8_t* nxtp,
   return calcLumaDiffYUY2_SADorSSD<false>(prvp, nxtp, width, height, prv_pitch, nxt_pitch, nt, cpuFlags);
 }
 
-int TDecimate::getHint(const VideoInfo& vi, PVideoFrame& src, int& d2vfilm)
+// frame property hint first (frames TFM passed through by reference), then pixels
+int TDecimate::getHint(const VideoInfo& vi, PVideoFrame& src, int& d2vfilm, IScriptEnvironment *env)
 {
-  if (vi.ComponentSize() == 1)
-    return getHint_core<uint8_t>(src, d2vfilm);
-  else // 2
-    return getHint_core<uint16_t>(src, d2vfilm);
-}
-
-template<typename pixel_t>
-int TDecimate::getHint_core(PVideoFrame &src, int &d2vfilm)
-{
-  const pixel_t *p = reinterpret_cast<const pixel_t *>(src->GetReadPtr(PLANAR_Y));
-  unsigned int i, magic_number = 0, hint = 0;
+  unsigned int hint = 0;
   int match = -200, field = 0;
   d2vfilm = 0;
-  for (i = 0; i < 32; ++i)
-  {
-    magic_number |= ((*p++ & 1) << i);
-  }
-  if (magic_number != MAGIC_NUMBER) return match;
-  for (i = 0; i < 32; ++i)
-  {
-    hint |= ((*p++ & 1) << i);
-  }
+  bool res;
+  if (has_at_least_v8 && getPropHint(src, hint, env))
+    res = true;
+  else if (vi.ComponentSize() == 1)
+    res = getHint_core<uint8_t>(src, hint);
+  else // 2
+    res = getHint_core<uint16_t>(src, hint);
+  if (!res) return match;
   if (hint & 0xFFFF0000) return match;
   if (hint&TOP_FIELD) field = 1;
   if (hint&D2VFILM) d2vfilm = 1;
@@ -1291,6 +1288,23 @@ int TDecimate::getHint_core(PVideoFrame &src, int &d2vfilm)
   return match;
 }
 
+template<typename pixel_t>
+bool TDecimate::getHint_core(PVideoFrame &src, unsigned int &hint)
+{
+  const pixel_t *p = reinterpret_cast<const pixel_t *>(src->GetReadPtr(PLANAR_Y));
+  unsigned int i, magic_number = 0;
+  for (i = 0; i < 32; ++i)
+  {
+    magic_number |= ((*p++ & 1) << i);
+  }
+  if (magic_number != MAGIC_NUMBER) return false;
+  for (i = 0; i < 32; ++i)
+  {
+    hint |= ((*p++ & 1) << i);
+  }
+  return true;
+}
+
 /*
 **  This function checks to see if there is a single match dup in the
 **  current cycle and if that frame also has the lowest metric in the
@@ -2149,6 +2163,7 @@ void TDecimate::calcBlendRatios2(double &amount1, double &amount2, int &frame1,
 
 // used in GetFrameMode01
 // hbd ready
+// dst is set by the function: a new frame or one of the sources (not writable)
 void TDecimate::blendFrames(PVideoFrame &src1, PVideoFrame &src2, PVideoFrame &dst,
   double amount1, const VideoInfo &vi, IScriptEnvironment *env)
 {
@@ -2162,17 +2177,20 @@ void TDecimate::blendFrames(PVideoFrame &src1, PVideoFrame &src2, PVideoFrame &d
   // 15 bit arithmetic (used as 16 bi at 8 bit case)
   const int weight_i = (int)(weight_f * 32768.0f + 0.5f);
 
+  // a full weight blend is the source itself: pass it by reference
   if (weight_i >= 32768)
   {
-    copyFrame(dst, src1, vi, env); // 1000% src1
+    dst = src1; // 100% src1
     return;
   }
   if (weight_i <= 0)
   {
-    copyFrame(dst, src2, vi, env); // 100% src2
+    dst = src2; // 100% src2
     return;
   }
 
+  if (has_at_least_v8) dst = env->NewVideoFrameP(vi, &src1); else dst = env->NewVideoFrame(vi);
+
   const int np = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   const int bits_per_pixel = vi.BitsPerComponent();
 
@@ -2329,155 +2347,226 @@ AVSValue __cdecl Create_TDecimate(AVSValue args, void* user_data, IScriptEnviron
   return v;
 }
 
-void TDecimate::init_mode_5(IScriptEnvironment* env) {
-  FILE *f = NULL;
+// printf style append for the mode 5 timecode file, which is formatted in
+// memory and written with a single fwrite
+static void appendf(std::string& out, const char* fmt, ...)
+{
+  char line[256];
+  va_list args;
+  va_start(args, fmt);
+  const int len = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (len > 0) out.append(line, std::min(len, (int)sizeof(line) - 1));
+}
 
-  mkvfps = (fps*(cycle - cycleR)) / cycle;
-  mkvfps2 = (fps*(cycle - cycleR - 1)) / cycle;
-  int *input = NULL;
-  input = (int*)malloc(vi.num_frames * sizeof(int));
-  if (input == NULL) env->ThrowError("TDecimate:  malloc failure (mode 5, input)!");
-  memset(input, 0, vi.num_frames * sizeof(int));
-  Cycle prevM(5, sdlim), currM(5, sdlim), nextM(5, sdlim);
-  if (cycle > 5)
+// True if preparing some cycle of the mode 5 planner would have to fetch frames
+// (missing metrics or hints), which must not happen outside the calling thread.
+bool TDecimate::mode5NeedsFrames()
+{
+  for (int i = 0; i <= nfrms; ++i)
   {
-    prevM.setSize(cycle);
-    currM.setSize(cycle);
-    nextM.setSize(cycle);
+    const bool inArray = metricsArray != NULL && metricsArray[i << 1] != UINT64_MAX;
+    const uint64_t *m = inArray ? metricsArray : metricsOutArray;
+    if (m == NULL || m[i << 1] == UINT64_MAX || m[(i << 1) + 1] == UINT64_MAX)
+      return true;
+    if (usehints && (ovrArray == NULL || (ovrArray[i] & ISMATCH) == 0x70))
+      return true;
   }
-  prevM.length = currM.length = nextM.length = cycle;
-  prevM.maxFrame = currM.maxFrame = nextM.maxFrame = nfrms;
-  bool vid, prevVid;
-  int i, h, w, firstkv, countprev, filmC, videoC, longestT, longestV, countVT;
-  int count, b, passThrough = 0;
-twopassrun:
-  ++passThrough;
-#if 0
-  if ((f = fopen("debug.txt", "a")) != NULL) {
-    fprintf(f, "passThrough=%d cycle=%d nfrms=%d vidThresh=%f np=%d\n", passThrough, cycle, nfrms, (float)vidThresh, np);
-    fclose(f);
-    f = NULL;
+  return false;
+}
+
+// Loads the cycle starting at frame b: override flags, matches and metrics.
+void TDecimate::setupMode5Cycle(Cycle &c, int b, IScriptEnvironment *env)
+{
+  c.setFrame(b);
+  getOvrCycle(c, false); // PF 180131 uses usehints!
+  calcMetricCycle(c, env, vi, true, true); // PF 180131 uses usehints!
+}
+
+// Sets up the cycles cFirst..cLast (at most prep.size() of them) into prep[0],
+// prep[1], ... on nthreads worker threads. Only used when mode5NeedsFrames() is
+// false, so no frames are requested.
+void TDecimate::prepareMode5Cycles(std::vector<std::unique_ptr<Cycle>> &prep, int cFirst, int cLast,
+  int nthreads, IScriptEnvironment *env)
+{
+  const int num = std::min((int)prep.size(), cLast - cFirst + 1);
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(nthreads);
+  for (int t = 0; t < nthreads; ++t)
+  {
+    const int kFirst = (int)((int64_t)num * t / nthreads);
+    const int kEnd = (int)((int64_t)num * (t + 1) / nthreads);
+    workers.emplace_back([&, t, kFirst, kEnd]() {
+      try {
+        for (int k = kFirst; k < kEnd; ++k)
+        {
+          prep[k]->invalidate();
+          setupMode5Cycle(*prep[k], (cFirst + k) * cycle, env);
+        }
+      }
+      catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
   }
-#endif
-  count = 0;
-  for (b = 0; b <= nfrms; b += cycle)
+  for (auto &worker : workers) worker.join();
+  for (auto &error : errors)
+  {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+// Runs one pass of the mode 5 planner. The decisions are made in cycle order:
+// with vfrDec=1 the dup strings of a cycle depend on how its predecessor was
+// decimated, so a cycle can depend on every cycle before it. With a non-empty
+// prep, the setup of the upcoming cycles is done ahead in batches of prep.size()
+// on worker threads and nextM is swapped in from there.
+void TDecimate::runMode5Cycles(int passThrough, int numCycles, Cycle &prevM, Cycle &currM, Cycle &nextM,
+  std::vector<std::unique_ptr<Cycle>> &prep, int nthreads, int *input, const uint8_t *filmCycle,
+  int &count, IScriptEnvironment *env)
+{
+  const int batch = (int)prep.size();
+  int i, w;
+  for (int c = 0; c < numCycles; ++c)
   {
-    if (b == 0)
+    const int b = c * cycle;
+    if (c == 0)
     {
-      currM.setFrame(0);
-      getOvrCycle(currM, false); // PF 180131 uses usehints!
-      calcMetricCycle(currM, env, vi, true, true);
+      setupMode5Cycle(currM, 0, env);
       checkVideoMatches(currM, currM);
       checkVideoMetrics(currM, vidThresh);
     }
+    else
+      Cycle::rotate(prevM, currM, nextM); // prevM = currM, currM = nextM
+    if (batch == 0)
+      setupMode5Cycle(nextM, b + cycle, env);
     else
     {
-      prevM = currM;
-      currM = nextM;
+      // prep[c % batch] holds cycle c + 1
+      if (c % batch == 0)
+        prepareMode5Cycles(prep, c + 1, numCycles, nthreads, env);
+      nextM.swap(*prep[c % batch]);
     }
-    nextM.setFrame(b + cycle);
-    getOvrCycle(nextM, false); // PF 180131 uses usehints!
-    calcMetricCycle(nextM, env, vi, true, true); // PF 180131 uses usehints!
     checkVideoMatches(currM, nextM);
     checkVideoMetrics(nextM, vidThresh);
+    bool decide;
     if (passThrough == 1)
     {
-      if (currM.type == 5 || (!currM.isfilmd2v && ((currM.type == 2 && (vidDetect == 0 || vidDetect == 2)) ||
-        (currM.type == 3 && (vidDetect == 1 || vidDetect == 2)) || (currM.type == 4 && vidDetect == 3))))
+      decide = !(currM.type == 5 || (!currM.isfilmd2v && ((currM.type == 2 && (vidDetect == 0 || vidDetect == 2)) ||
+        (currM.type == 3 && (vidDetect == 1 || vidDetect == 2)) || (currM.type == 4 && vidDetect == 3))));
+      if (!decide)
       {
         if (currM.type == 5) input[b] = 8;
         if (currM.sceneDetect(prevM, nextM, sceneThreshU) != -20) input[b] = 8;
       }
-      else
+    }
+    else
+    {
+      decide = filmCycle[c] != 0;
+      if (!decide)
       {
-        if (vfrDec != 1)
-        {
-          mostSimilarDecDecision(prevM, currM, nextM, env);
-        }
-        else
-        {
-          prevM.setDups(dupThresh);
-          currM.setDups(dupThresh);
-          nextM.setDups(dupThresh);
-          findDupStrings(prevM, currM, nextM, env);
-        }
-        for (w = 0, i = b; i < b + cycle && i <= nfrms; ++i, ++w)
-        {
-          if (currM.decimate[w] == 1) input[i] = 2;
-        }
+        for (i = b; i < b + cycle && i <= nfrms; ++i) input[i] = 0;
       }
-    } // passthrough == 1
+    }
+    if (!decide) continue;
+    if (vfrDec != 1)
+    {
+      mostSimilarDecDecision(prevM, currM, nextM, env);
+    }
     else
-    { // passthrough != 1
-      for (vid = true, i = b; i <= nfrms && i < b + cycle; ++i)
+    {
+      prevM.setDups(dupThresh);
+      currM.setDups(dupThresh);
+      nextM.setDups(dupThresh);
+      findDupStrings(prevM, currM, nextM, env);
+    }
+    for (w = 0, i = b; i < b + cycle && i <= nfrms; ++i, ++w)
+    {
+      if (currM.decimate[w] == 1)
       {
-        if (input[i] == 2) vid = false;
+        input[i] = 2;
+        if (passThrough == 2) ++count;
       }
-      if (!vid)
+      else if (passThrough == 2) input[i] = 0;
+    }
+  }
+}
+
+void TDecimate::init_mode_5(IScriptEnvironment* env) {
+  mkvfps = (fps*(cycle - cycleR)) / cycle;
+  mkvfps2 = (fps*(cycle - cycleR - 1)) / cycle;
+  const int numCycles = nfrms / cycle + 1;
+  std::vector<int> input(vi.num_frames, 0);
+  std::vector<uint8_t> filmCycle(numCycles, 0);
+
+  // With every metric and match known up front the cycle setup can run ahead
+  // on worker threads, otherwise the frames are fetched here.
+  int nthreads = 1;
+  if (!debug && !mode5NeedsFrames())
+    nthreads = std::max(1, std::min((int)std::thread::hardware_concurrency(), numCycles / MODE5_CHUNK_CYCLES));
+  Cycle prevM(5, sdlim), currM(5, sdlim), nextM(5, sdlim);
+  if (cycle > 5)
+  {
+    prevM.setSize(cycle);
+    currM.setSize(cycle);
+    nextM.setSize(cycle);
+  }
+  prevM.length = currM.length = nextM.length = cycle;
+  prevM.maxFrame = currM.maxFrame = nextM.maxFrame = nfrms;
+  std::vector<std::unique_ptr<Cycle>> prep; // cycles set up ahead, with nthreads > 1
+  for (int t = 0; nthreads > 1 && t < nthreads * MODE5_CHUNK_CYCLES; ++t)
+  {
+    prep.emplace_back(new Cycle(5, sdlim));
+    Cycle &c = *prep.back();
+    if (cycle > 5) c.setSize(cycle);
+    c.length = cycle;
+    c.maxFrame = nfrms;
+  }
+  bool vid, prevVid;
+  int i, h, w, firstkv, countprev, filmC, videoC, longestT, longestV, countVT;
+  int count = 0, b;
+  for (int passThrough = 1; passThrough <= 2; ++passThrough)
+  {
+    if (passThrough == 2)
+    {
+      for (w = 0, h = 0; h <= nfrms; h += cycle)
       {
-        if (vfrDec != 1)
+        for (vid = true, i = h; i < h + cycle && i <= nfrms; ++i)
         {
-          mostSimilarDecDecision(prevM, currM, nextM, env);
+          if (input[i] == 2) vid = false;
         }
+        if (vid) ++w;
         else
         {
-          prevM.setDups(dupThresh);
-          currM.setDups(dupThresh);
-          nextM.setDups(dupThresh);
-          findDupStrings(prevM, currM, nextM, env);
-        }
-        for (w = 0, i = b; i < b + cycle && i <= nfrms; ++i, ++w)
-        {
-          if (currM.decimate[w] == 1)
+          if (w > 0 && w < conCycleTP)
           {
-            input[i] = 2;
-            ++count;
-#if 0
-            if ((f = fopen("debug.txt", "a")) != NULL) {
-              fprintf(f, "count=%03d b=%d w=%d i=%d \n", count, b, w, i);
-              fclose(f);
-              f = NULL;
+            for (i = std::max(0, h - w * cycle); i < h && i <= nfrms; i += cycle)
+            {
+              if (input[i] != 8) input[i] = 2;
             }
-#endif
           }
-          else input[i] = 0;
+          w = 0;
         }
       }
-      else
-      {
-        for (i = b; i < b + cycle && i <= nfrms; ++i) input[i] = 0;
-      }
-    } // passthrough != 1
-  }
-  if (passThrough == 2) { goto finishTP; }
-  for (w = 0, h = 0; h <= nfrms; h += cycle)
-  {
-    for (vid = true, i = h; i < h + cycle && i <= nfrms; ++i)
-    {
-      if (input[i] == 2) vid = false;
-    }
-    if (vid) ++w;
-    else
-    {
       if (w > 0 && w < conCycleTP)
       {
-        for (i = std::max(0, h - w * cycle); i < h && i <= nfrms; i += cycle)
+        for (i = h - w * cycle; i < h && i <= nfrms; i += cycle)
         {
           if (input[i] != 8) input[i] = 2;
         }
       }
-      w = 0;
-    }
-  }
-  if (w > 0 && w < conCycleTP)
-  {
-    for (i = h - w * cycle; i < h && i <= nfrms; i += cycle)
-    {
-      if (input[i] != 8) input[i] = 2;
+      for (int c = 0; c < numCycles; ++c)
+      {
+        for (i = c * cycle; i < (c + 1) * cycle && i <= nfrms; ++i)
+        {
+          if (input[i] == 2) filmCycle[c] = 1;
+        }
+      }
     }
+    runMode5Cycles(passThrough, numCycles, prevM, currM, nextM, prep, nthreads,
+      input.data(), filmCycle.data(), count, env);
   }
-  goto twopassrun;
-finishTP:
+
   if (metricsArray != NULL)
   {
     free(metricsArray);
@@ -2489,17 +2578,10 @@ finishTP:
     ovrArray = NULL;
   }
 
-#if 0
-  if ((f = fopen("debug.txt", "a")) != NULL) {
-    fprintf(f, "new_num_frames=%d vi.num_frames=%d count=%d\n", vi.num_frames - count, vi.num_frames, count);
-    fclose(f);
-    f = NULL;
-  }
-#endif
-
   vi.MulDivFPS(vi.num_frames - count, vi.num_frames);
   vi.num_frames = vi.num_frames - count;
-  if ((f = fopen(mkvOut, "w")) != NULL)
+  std::string tc;
+  tc.reserve((size_t)(nfrms + 1) * 16 + 512);
   {
     double timestamp = 0.0;
     double sample1 = 1000.0 / fps;
@@ -2508,12 +2590,12 @@ finishTP:
     int ddup;
     if (tcfv1)
     {
-      fprintf(f, "# timecode format v1\n");
-      fprintf(f, "Assume %4.6f\n", fps);
+      appendf(tc, "# timecode format v1\n");
+      appendf(tc, "Assume %4.6f\n", fps);
     }
-    else fprintf(f, "# timecode format v2\n");
-    fprintf(f, "# TDecimate %s by tritical\n", VERSION);
-    fprintf(f, "# Mode 5 - Auto-generated mkv timecodes file\n");
+    else appendf(tc, "# timecode format v2\n");
+    appendf(tc, "# TDecimate %s by tritical\n", VERSION);
+    appendf(tc, "# Mode 5 - Auto-generated mkv timecodes file\n");
     firstkv = countprev = 0;
     vid = prevVid = true;
     filmC = videoC = longestT = longestV = countVT = 0;
@@ -2539,7 +2621,7 @@ finishTP:
           int stop = (b + cycle <= nfrms ? cycle : nfrms - b + 1);
           for (int x = 0; x < stop; ++x)
           {
-            fprintf(f, "%3.6f\n", timestamp);
+            appendf(tc, "%3.6f\n", timestamp);
             timestamp += sample1;
           }
         }
@@ -2553,7 +2635,7 @@ finishTP:
           int stop = (b + cycle <= nfrms ? cycle - cycleR : nfrms - b + 1 - cycleR);
           for (int x = 0; x < stop; ++x)
           {
-            fprintf(f, "%3.6f\n", timestamp);
+            appendf(tc, "%3.6f\n", timestamp);
             timestamp += sample2;
           }
         }
@@ -2562,7 +2644,7 @@ finishTP:
           int stop = (b + cycle <= nfrms ? cycle - cycleR - 1 : nfrms - b + 1 - cycleR - 1);
           for (int x = 0; x < stop; ++x)
           {
-            fprintf(f, "%3.6f\n", timestamp);
+            appendf(tc, "%3.6f\n", timestamp);
             timestamp += sample3;
           }
         }
@@ -2570,13 +2652,13 @@ finishTP:
       }
       else if (ddup == 2)
       {
-        if (!prevVid) fprintf(f, "%d,%d,%4.6f\n", firstkv, countprev - 1, mkvfps);
-        fprintf(f, "%d,%d,%4.6f\n", countprev, countprev + cycle - cycleR - 2, mkvfps2);
+        if (!prevVid) appendf(tc, "%d,%d,%4.6f\n", firstkv, countprev - 1, mkvfps);
+        appendf(tc, "%d,%d,%4.6f\n", countprev, countprev + cycle - cycleR - 2, mkvfps2);
         firstkv = countprev + cycle - cycleR - 1;
       }
       if (prevVid != vid && countprev != 0 && ddup != 2 && countprev > firstkv)
       {
-        if (!prevVid && tcfv1) fprintf(f, "%d,%d,%4.6f\n", firstkv, countprev - 1, mkvfps);
+        if (!prevVid && tcfv1) appendf(tc, "%d,%d,%4.6f\n", firstkv, countprev - 1, mkvfps);
         firstkv = countprev;
       }
       else if (prevVid != vid && ddup != 2) firstkv = countprev;
@@ -2587,22 +2669,21 @@ finishTP:
         longestT = 0;
       }
     }
-    if (!vid && tcfv1) fprintf(f, "%d,%d,%4.6f\n", firstkv, count - 1, mkvfps);
+    if (!vid && tcfv1) appendf(tc, "%d,%d,%4.6f\n", firstkv, count - 1, mkvfps);
     double filmCf = ((double)(filmC) / (double)(nfrms + 1))*100.0;
     double videoCf = ((double)(videoC) / (double)(nfrms + 1))*100.0;
-    fprintf(f, "# vfr stats:  %05.2f%c film  %05.2f%c video\n", filmCf, '%', videoCf, '%');
-    fprintf(f, "# vfr stats:  %d - film  %d - video  %d - total\n", filmC, videoC, nfrms + 1);
-    fprintf(f, "# vfr stats:  longest vid section - %d frames\n", longestV);
-    fprintf(f, "# vfr stats:  # of detected vid sections - %d", countVT);
-    fclose(f);
-    f = NULL;
+    appendf(tc, "# vfr stats:  %05.2f%c film  %05.2f%c video\n", filmCf, '%', videoCf, '%');
+    appendf(tc, "# vfr stats:  %d - film  %d - video  %d - total\n", filmC, videoC, nfrms + 1);
+    appendf(tc, "# vfr stats:  longest vid section - %d frames\n", longestV);
+    appendf(tc, "# vfr stats:  # of detected vid sections - %d", countVT);
   }
-  else
-  {
-    free(input);
-    input = NULL;
+  FILE *f = fopen(mkvOut, "w");
+  if (f == NULL)
     env->ThrowError("TDecimate:  mkvOut file output error (cannot create file)!");
-  }
+  const bool written = fwrite(tc.data(), 1, tc.size(), f) == tc.size();
+  fclose(f);
+  if (!written)
+    env->ThrowError("TDecimate:  mkvOut file output error (cannot write file)!");
   if (aLUT != NULL)
   {
     free(aLUT);
@@ -2610,11 +2691,7 @@ finishTP:
   }
   aLUT = (int *)malloc((vi.num_frames + 1) * sizeof(int));
   if (aLUT == NULL)
-  {
-    free(input);
-    input = NULL;
     env->ThrowError("TDecimate:  malloc failure (aLUT, mode 5)!");
-  }
   memset(aLUT, 0, (vi.num_frames + 1) * sizeof(int));
   i = w = 0;
   while (i <= nfrms && w <= vi.num_frames - 1)
@@ -2626,12 +2703,8 @@ finishTP:
     }
     ++i;
   }
-  free(input);
-  input = NULL;
   nfrmsN = vi.num_frames - 1;
 
-  if (f != NULL) fclose(f);
-
   //nfrms and nfrmsN may give some hints as well.
   //8day
   if (*orgOut)
@@ -2807,7 +2880,7 @@ TDecimate::TDecimate(PClip _child, int _mode, int _cycleR, int _cycle, double _r
     int d2hg;
     
     PVideoFrame sthg = child->GetFrame(0, env);
-    int mhg = getHint(vi, sthg, d2hg);
+    int mhg = getHint(vi, sthg, d2hg, env);
     if (mhg != -200) usehints = true;
     else usehints = false;
   }
@@ -3498,8 +3571,12 @@ TDecimate::TDecimate(PClip _child, int _mode, int _cycleR, int _cycle, double _r
     lastCycle = -cycle;
     retFrames = -200;
     lastType = linearCount = 0;
+    mode3_vidC = mode3_filmC = mode3_longestT = mode3_longestV = mode3_countVT = 0;
+    mode3_timestamp = 0.0;
     if ((mkvOutF = fopen(mkvOut, "w")) != NULL)
     {
+      // timecodes are appended per cycle, let stdio batch them
+      setvbuf(mkvOutF, NULL, _IOFBF, 1 << 16);
       if (tcfv1)
       {
         fprintf(mkvOutF, "# timecode format v1\n");
@@ -26,12 +26,15 @@
 #include <stdio.h>
 #include <malloc.h>
 #include <math.h>
+#include <memory>
+#include <vector>
 #include "internal.h"
 #include "Font.h"
 #include "Cycle.h"
 #include "calcCRC.h"
 #include "profUtil.h"
 #include "Cache.h"
+#include "CalcMetric.h"
 
 constexpr int ISP = 0x00000000; // p
 constexpr int ISC = 0x00000001; // c
@@ -59,37 +62,15 @@ constexpr int ISD2VFILM = 0x00000080; // ovr array - bit 8
 
 #define VERSION "v1.0.7"
 
+// cycles per worker and batch of the mode 5 planner setup; clips with fewer
+// than twice as many cycles are set up in the calling thread
+constexpr int MODE5_CHUNK_CYCLES = 1024;
+
 #define cfps(n) n == 1 ? "119.880120" : n == 2 ? "59.940060" : n == 3 ? "39.960040" : \
 				n == 4 ? "29.970030" : n == 5 ? "23.976024" : "unknown"
 
-// All the rest of this code was just copied from tdecimate.cpp because I'm
-// too lazy to make it work such that it could call that code.
-// pinterf 2020: moved the three versions to common codebase again: CalcMetricsExtracted().
-struct CalcMetricData {
-  bool predenoise;
-  VideoInfo vi;
-  bool chroma;
-  int cpuFlags;
-  int blockx;
-  int blockx_half;
-  int blockx_shift;
-  int blocky;
-  int blocky_half;
-  int blocky_shift;
-  uint64_t* diff;
-  int nt;
-  bool ssd; // ssd or sad
-
-  bool metricF_needed; // from TDecimate: true, from FrameDiff: false
-  // TDecimate
-  uint64_t* metricF; // out!
-  bool scene;
-};
-
-void CalcMetricsExtracted(IScriptEnvironment* env, PVideoFrame& prevt, PVideoFrame& currt, CalcMetricData& d);
-
-void blurFrame(PVideoFrame& src, PVideoFrame& dst, int iterations,
-  bool bchroma, IScriptEnvironment* env, VideoInfo& vi_t, int cpuFlags);
+void blurFrame(PVideoFrame& src, PVideoFrame& dst, PVideoFrame& tmp, int iterations,
+  bool bchroma, VideoInfo& vi_t, int cpuFlags);
 
 uint64_t calcLumaDiffYUY2_SSD(const uint8_t* prvp, const uint8_t* nxtp,
   int width, int height, int prv_pitch, int nxt_pitch, int nt, int cpuFlags);
@@ -130,6 +111,7 @@ private:
   bool exPP;
   bool noblend;
   bool predenoise;
+  MetricScratch metricScratch; // predenoise work frames, calcMetric and calcMetricCycle
   bool ssd; // sum of squared distances (false = SAD)
   int sdlim;
   int opt;
@@ -151,6 +133,9 @@ private:
   uint8_t *ovrArray;
   int mode2_num, mode2_den, mode2_numCycles, mode2_cfs[10];
   FILE *mkvOutF;
+  // mode 3 timecode and vfr stats state
+  int mode3_vidC, mode3_filmC, mode3_longestT, mode3_longestV, mode3_countVT;
+  double mode3_timestamp;
   char buf[8192];
 #ifdef _WIN32
   char outputFull[MAX_PATH + 1];
@@ -159,15 +144,22 @@ private:
 #endif
 
   void init_mode_5(IScriptEnvironment* env);
+  bool mode5NeedsFrames();
+  void setupMode5Cycle(Cycle &c, int b, IScriptEnvironment *env);
+  void prepareMode5Cycles(std::vector<std::unique_ptr<Cycle>> &prep, int cFirst, int cLast,
+    int nthreads, IScriptEnvironment *env);
+  void runMode5Cycles(int passThrough, int numCycles, Cycle &prevM, Cycle &currM, Cycle &nextM,
+    std::vector<std::unique_ptr<Cycle>> &prep, int nthreads, int *input, const uint8_t *filmCycle,
+    int &count, IScriptEnvironment *env);
   void rerunFromStart(int s, const VideoInfo& vi, IScriptEnvironment *env);
   void checkVideoMetrics(Cycle &c, double thresh);
   void checkVideoMatches(Cycle &p, Cycle &c);
   bool checkMatchDup(int mp, int mc);
   void findDupStrings(Cycle &p, Cycle &c, Cycle &n, IScriptEnvironment *env);
 
-  int getHint(const VideoInfo& vi, PVideoFrame& src, int& d2vfilm);
+  int getHint(const VideoInfo& vi, PVideoFrame& src, int& d2vfilm, IScriptEnvironment *env);
   template<typename pixel_t>
-  int getHint_core(PVideoFrame &src, int &d2vfilm);
+  bool getHint_core(PVideoFrame &src, unsigned int &hint);
 
   template<typename pixel_t>
   void restoreHint(PVideoFrame &dst, IScriptEnvironment *env);
@@ -200,6 +192,7 @@ private:
   void mostSimilarDecDecision(Cycle &p, Cycle &c, Cycle &n, IScriptEnvironment *env);
   int checkForD2VDecFrame(Cycle &p, Cycle &c, Cycle &n);
   bool checkForTwoDropLongestString(Cycle &p, Cycle &c, Cycle &n);
+  int findCycleMode2(int n);
   int getNonDecMode2(int n, int start, int stop);
   double buildDecStrategy(IScriptEnvironment *env);
   void mode2MarkDecFrames(int cycleF);
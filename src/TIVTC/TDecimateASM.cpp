@@ -29,6 +29,7 @@
 #include "emmintrin.h"
 #include "smmintrin.h" // SSE4
 #include <assert.h>
+#include <vector>
 
 static void blend_uint8_c(uint8_t* dstp, const uint8_t* srcp1,
   const uint8_t* srcp2, int width, int height, int dst_pitch,
@@ -174,6 +175,7 @@ void dispatch_blend(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, i
 {
   const bool use_sse2 = cpuFlags & CPUF_SSE2;
   const bool use_sse4 = cpuFlags & CPUF_SSE4_1;
+  const bool use_avx2 = cpuFlags & CPUF_AVX2;
 
   // weight_i 0 and max --> copy is already handled!
   // weight_i is of 15 bit scale
@@ -181,13 +183,17 @@ void dispatch_blend(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, i
   // special 50% case
   if (weight_i == 32768 / 2) {
     if (bits_per_pixel == 8) {
-      if (use_sse2)
+      if (use_avx2)
+        blend_5050_AVX2<uint8_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
+      else if (use_sse2)
         blend_5050_SSE2<uint8_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
       else
         blend_5050_c<uint8_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
     }
     else {
-      if (use_sse2)
+      if (use_avx2)
+        blend_5050_AVX2<uint16_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
+      else if (use_sse2)
         blend_5050_SSE2<uint16_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
       else
         blend_5050_c<uint16_t>(dstp, srcp1, srcp2, width, height, dst_pitch, src1_pitch, src2_pitch);
@@ -1049,10 +1055,36 @@ void VerticalBlurSSE2_R(const uint8_t *srcp, uint8_t *dstp,
 
 //-------- helpers
 
+// AVX512 or AVX2 block row kernel for blkw wide blocks, nullptr if there is none
+template<bool SAD>
+static calcBlockRow_fn_t* get_calcBlockRow_fn(int blkw, bool lumaonly, int cpuFlags)
+{
+  const bool use_avx2 = (cpuFlags & CPUF_AVX2) ? true : false;
+  const bool use_avx512 = (cpuFlags & CPUF_AVX512BW) ? true : false;
+
+  if (use_avx512) {
+    switch (blkw) {
+    case 4: return lumaonly ? nullptr : calcBlockRow_AVX512<SAD, 4, false>;
+    case 8: return lumaonly ? calcBlockRow_AVX512<SAD, 8, true> : calcBlockRow_AVX512<SAD, 8, false>;
+    case 16: return lumaonly ? nullptr : calcBlockRow_AVX512<SAD, 16, false>;
+    case 32: return lumaonly ? calcBlockRow_AVX512<SAD, 32, true> : calcBlockRow_AVX512<SAD, 32, false>;
+    }
+  }
+  else if (use_avx2) {
+    switch (blkw) {
+    case 4: return lumaonly ? nullptr : calcBlockRow_AVX2<SAD, 4, false>;
+    case 8: return lumaonly ? calcBlockRow_AVX2<SAD, 8, true> : calcBlockRow_AVX2<SAD, 8, false>;
+    case 16: return lumaonly ? nullptr : calcBlockRow_AVX2<SAD, 16, false>;
+    case 32: return lumaonly ? calcBlockRow_AVX2<SAD, 32, true> : calcBlockRow_AVX2<SAD, 32, false>;
+    }
+  }
+  return nullptr; // SSE2 only
+}
+
 // true SAD false SSD
 template<bool SAD>
 static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, const VideoInfo& vi)
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, const VideoInfo& vi, int cpuFlags)
 {
   int temp1, temp2, y, x, u, difft, box1, box2;
   int widtha, heighta, heights = height, widths = width;
@@ -1095,6 +1127,9 @@ static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr
     }
     // other formats are forbidden and were pre-checked
 
+    calcBlockRow_fn_t* row_fn = get_calcBlockRow_fn<SAD>(1 << w_to_shift, false, cpuFlags);
+    std::vector<int> rowsums(row_fn ? width : 0);
+
     // number of whole blocks
     for (y = 0; y < height; ++y)
     {
@@ -1107,9 +1142,13 @@ static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr
       // Fact 2: Because we do 32x32 but with 16x16 luma (and divided chroma) blocks?
       temp1 = (y >> 1) * xblocks4;
       temp2 = ((y + 1) >> 1) * xblocks4;
+      const int xdone = row_fn ? row_fn(ptr1, ptr2, pitch1, pitch2, width, 1 << h_to_shift, rowsums.data()) : 0;
       for (x = 0; x < width; ++x) // width is the number of blocks
       {
-        SAD_fn(ptr1 + (x << w_to_shift), ptr2 + (x << w_to_shift), pitch1, pitch2, difft);
+        if (x < xdone)
+          difft = rowsums[x];
+        else
+          SAD_fn(ptr1 + (x << w_to_shift), ptr2 + (x << w_to_shift), pitch1, pitch2, difft);
         box1 = (x >> 1) << 2;
         box2 = ((x + 1) >> 1) << 2;
         diff[temp1 + box1 + 0] += difft;
@@ -1172,6 +1211,8 @@ static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr
     widtha = (width >> 5) << 5;
     height >>= 4;
     width >>= 5;
+    calcBlockRow_fn_t* row_fn = get_calcBlockRow_fn<SAD>(32, !chroma, cpuFlags);
+    std::vector<int> rowsums(row_fn ? width : 0);
     if (chroma)
     {
       // YUY2 common luma chroma
@@ -1179,9 +1220,12 @@ static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr
       {
         temp1 = (y >> 1) * xblocks4;
         temp2 = ((y + 1) >> 1) * xblocks4;
+        const int xdone = row_fn ? row_fn(ptr1, ptr2, pitch1, pitch2, width, 16, rowsums.data()) : 0;
         for (x = 0; x < width; ++x)
         {
-          if constexpr (SAD)
+          if (x < xdone)
+            difft = rowsums[x];
+          else if constexpr (SAD)
             calcSAD_SSE2_32x16(ptr1 + (x << 5), ptr2 + (x << 5), pitch1, pitch2, difft);
           else
             calcSSD_SSE2_32x16(ptr1 + (x << 5), ptr2 + (x << 5), pitch1, pitch2, difft);
@@ -1245,9 +1289,12 @@ static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr
       {
         temp1 = (y >> 1) * xblocks4;
         temp2 = ((y + 1) >> 1) * xblocks4;
+        const int xdone = row_fn ? row_fn(ptr1, ptr2, pitch1, pitch2, width, 16, rowsums.data()) : 0;
         for (x = 0; x < width; ++x)
         {
-          if constexpr (SAD)
+          if (x < xdone)
+            difft = rowsums[x];
+          else if constexpr (SAD)
             calcSAD_SSE2_32x16_YUY2_lumaonly(ptr1 + (x << 5), ptr2 + (x << 5), pitch1, pitch2, difft);
           else
             calcSSD_SSE2_32x16_YUY2_lumaonly(ptr1 + (x << 5), ptr2 + (x << 5), pitch1, pitch2, difft);
@@ -1309,22 +1356,22 @@ static void calcDiff_SADorSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr
 }
 
 void calcDiffSAD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, const VideoInfo& vi)
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, const VideoInfo& vi, int cpuFlags)
 {
-  calcDiff_SADorSSD_32x32_SSE2<true>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, vi);
+  calcDiff_SADorSSD_32x32_SSE2<true>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, vi, cpuFlags);
 }
 
 void calcDiffSSD_32x32_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, const VideoInfo& vi)
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, const VideoInfo& vi, int cpuFlags)
 {
-  calcDiff_SADorSSD_32x32_SSE2<false>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, vi);
+  calcDiff_SADorSSD_32x32_SSE2<false>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, vi, cpuFlags);
 }
 
 
 // true: SAD, false: SSD
 template<bool SAD>
 void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi)
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi, int cpuFlags)
 {
   int temp1, temp2, y, x, u, difft, box1, box2;
   int yshift, yhalf, xshift, xhalf;
@@ -1369,6 +1416,9 @@ void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
     }
     // other formats are forbidden and were pre-checked
 
+    calcBlockRow_fn_t* row_fn = get_calcBlockRow_fn<SAD>(1 << w_to_shift, false, cpuFlags);
+    std::vector<int> rowsums(row_fn ? width : 0);
+
     yshifta = yshiftS - ysubsampling; // yshiftS  or yshiftS - 1
     yhalfa = yhalfS >> ysubsampling; // yhalfS  or yhalfS >> 1;
     xshifta = xshiftS - xsubsampling; //  xshiftS or  xshiftS - 1;
@@ -1383,9 +1433,13 @@ void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
     {
       temp1 = (y >> yshift) * xblocks4;
       temp2 = ((y + yhalf) >> yshift) * xblocks4;
+      const int xdone = row_fn ? row_fn(ptr1, ptr2, pitch1, pitch2, width, 1 << h_to_shift, rowsums.data()) : 0;
       for (x = 0; x < width; ++x)
       {
-        SAD_fn(ptr1 + (x << w_to_shift), ptr2 + (x << w_to_shift), pitch1, pitch2, difft);
+        if (x < xdone)
+          difft = rowsums[x];
+        else
+          SAD_fn(ptr1 + (x << w_to_shift), ptr2 + (x << w_to_shift), pitch1, pitch2, difft);
         box1 = (x >> xshift) << 2;
         box2 = ((x + xhalf) >> xshift) << 2;
         diff[temp1 + box1 + 0] += difft;
@@ -1446,6 +1500,8 @@ void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
     widtha = (width >> 3) << 3;
     height >>= 3;
     width >>= 3;
+    calcBlockRow_fn_t* row_fn = get_calcBlockRow_fn<SAD>(8, !chroma, cpuFlags);
+    std::vector<int> rowsums(row_fn ? width : 0);
     yshifta = yshiftS;
     yhalfa = yhalfS;
     xshifta = xshiftS + 1;
@@ -1460,9 +1516,12 @@ void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
       {
         temp1 = (y >> yshift) * xblocks4;
         temp2 = ((y + yhalf) >> yshift) * xblocks4;
+        const int xdone = row_fn ? row_fn(ptr1, ptr2, pitch1, pitch2, width, 8, rowsums.data()) : 0;
         for (x = 0; x < width; ++x)
         {
-          if constexpr (SAD)
+          if (x < xdone)
+            difft = rowsums[x];
+          else if constexpr (SAD)
             calcSAD_SSE2_8xN<8>(ptr1 + (x << 3), ptr2 + (x << 3), pitch1, pitch2, difft);
           else
             calcSSD_SSE2_8xN<8>(ptr1 + (x << 3), ptr2 + (x << 3), pitch1, pitch2, difft);
@@ -1528,9 +1587,12 @@ void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
       {
         temp1 = (y >> yshift) * xblocks4;
         temp2 = ((y + yhalf) >> yshift) * xblocks4;
+        const int xdone = row_fn ? row_fn(ptr1, ptr2, pitch1, pitch2, width, 8, rowsums.data()) : 0;
         for (x = 0; x < width; ++x)
         {
-          if constexpr (SAD)
+          if (x < xdone)
+            difft = rowsums[x];
+          else if constexpr (SAD)
             calcSAD_SSE2_8x8_YUY2_lumaonly(ptr1 + (x << 3), ptr2 + (x << 3), pitch1, pitch2, difft);
           else
             calcSSD_SSE2_8x8_YUY2_lumaonly(ptr1 + (x << 3), ptr2 + (x << 3), pitch1, pitch2, difft);
@@ -1596,15 +1658,15 @@ void calcDiff_SADorSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
 }
 
 void calcDiffSAD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi)
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi, int cpuFlags)
 {
-  calcDiff_SADorSSD_Generic_SSE2<true>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, xshiftS, yshiftS, xhalfS, yhalfS, vi);
+  calcDiff_SADorSSD_Generic_SSE2<true>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, xshiftS, yshiftS, xhalfS, yhalfS, vi, cpuFlags);
 }
 
 void calcDiffSSD_Generic_SSE2(const uint8_t* ptr1, const uint8_t* ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi)
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t* diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi, int cpuFlags)
 {
-  calcDiff_SADorSSD_Generic_SSE2<false>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, xshiftS, yshiftS, xhalfS, yhalfS, vi);
+  calcDiff_SADorSSD_Generic_SSE2<false>(ptr1, ptr2, pitch1, pitch2, width, height, plane, xblocks4, diff, chroma, xshiftS, yshiftS, xhalfS, yhalfS, vi, cpuFlags);
 }
 
 
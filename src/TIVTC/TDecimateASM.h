@@ -29,6 +29,7 @@
 #include <xmmintrin.h>
 #include <emmintrin.h>
 #include "internal.h"
+#include "CalcMetric.h"
 
 void HorizontalBlurSSE2_YUY2_R_luma(const uint8_t* srcp, uint8_t* dstp, int src_pitch, int dst_pitch, int width, int height);
 void HorizontalBlurSSE2_YUY2_R(const uint8_t* srcp, uint8_t* dstp, int src_pitch, int dst_pitch, int width, int height);
@@ -70,18 +71,33 @@ template<int blkSizeY>
 void calcSAD_SSE2_16xN(const uint8_t *ptr1, const uint8_t *ptr2, int pitch1, int pitch2, int &sad);
 
 
+// Block row kernels: SAD or SSD of nblocks horizontally adjacent blkw x blkh
+// blocks (blkw bytes) into sums[]. They do whole vector steps only and return
+// the number of blocks done, the rest of the row is left to the caller.
+// lumaonly: YUY2 without chroma, only the even bytes are counted
+using calcBlockRow_fn_t = int(const uint8_t* ptr1, const uint8_t* ptr2,
+  int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+
+template<bool SAD, int blkw, bool lumaonly>
+int calcBlockRow_AVX2(const uint8_t* ptr1, const uint8_t* ptr2,
+  int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template<bool SAD, int blkw, bool lumaonly>
+int calcBlockRow_AVX512(const uint8_t* ptr1, const uint8_t* ptr2,
+  int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+
 //-- helpers
+// SSE2 baseline, whole block rows go to the AVX2/AVX512 block row kernels when cpuFlags allows
 void calcDiffSAD_32x32_SSE2(const uint8_t *ptr1, const uint8_t *ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, const VideoInfo& vi);
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, const VideoInfo& vi, int cpuFlags);
 
 void calcDiffSSD_32x32_SSE2(const uint8_t *ptr1, const uint8_t *ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, const VideoInfo& vi);
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, const VideoInfo& vi, int cpuFlags);
 
 void calcDiffSSD_Generic_SSE2(const uint8_t *ptr1, const uint8_t *ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi);
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi, int cpuFlags);
 
 void calcDiffSAD_Generic_SSE2(const uint8_t *ptr1, const uint8_t *ptr2,
-  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi);
+  int pitch1, int pitch2, int width, int height, int plane, int xblocks4, uint64_t *diff, bool chroma, int xshiftS, int yshiftS, int xhalfS, int yhalfS, const VideoInfo& vi, int cpuFlags);
 
 template<typename pixel_t, bool SAD, int inc>
 void calcDiff_SADorSSD_Generic_c(const pixel_t* prvp, const pixel_t* curp,
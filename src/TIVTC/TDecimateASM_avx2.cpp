@@ -0,0 +1,105 @@
+/*
+**                    TIVTC for AviSynth 2.6 interface
+**
+**   TIVTC includes a field matching filter (TFM) and a decimation
+**   filter (TDecimate) which can be used together to achieve an
+**   IVTC or for other uses. TIVTC currently supports 8 bit planar YUV and
+**   YUY2 colorspaces.
+**
+**   Copyright (C) 2004-2008 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// AVX2 kernels: this file is compiled with AVX2 enabled (*_avx2.cpp pattern)
+
+#include "TDecimateASM.h"
+#include <immintrin.h>
+
+#if !defined(__AVX2__) && (defined(GCC) || defined(CLANG))
+#error This source file will only work properly when compiled with AVX2 option. Set __AVX2__ or use -mavx2
+#endif
+
+// see calcBlockRow_fn_t
+// One 32 byte chunk holds 32/blkw horizontally adjacent blocks. The column
+// sums of the blkh lines are kept in 32 bit lanes, one lane for each 4 bytes,
+// and are only split into the blocks at the end of the chunk.
+template<bool SAD, int blkw, bool lumaonly>
+int calcBlockRow_AVX2(const uint8_t* ptr1, const uint8_t* ptr2,
+  int pitch1, int pitch2, int nblocks, int blkh, int* sums)
+{
+  constexpr int blocks_per_chunk = 32 / blkw;
+  constexpr int lanes_per_block = blkw / 4;
+  const int chunks = nblocks / blocks_per_chunk;
+
+  const __m256i luma = _mm256_set1_epi16(0x00FF);
+  const __m256i one = _mm256_set1_epi16(1);
+
+  for (int c = 0; c < chunks; ++c)
+  {
+    const uint8_t* p1 = ptr1 + c * 32;
+    const uint8_t* p2 = ptr2 + c * 32;
+    __m256i acc = _mm256_setzero_si256();
+    for (int y = 0; y < blkh; ++y)
+    {
+      __m256i src1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p1));
+      __m256i src2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p2));
+      if constexpr (lumaonly) {
+        src1 = _mm256_and_si256(src1, luma);
+        src2 = _mm256_and_si256(src2, luma);
+      }
+      if constexpr (SAD && blkw >= 8) {
+        // 64 bit lanes, the upper 32 bits stay zero
+        acc = _mm256_add_epi32(acc, _mm256_sad_epu8(src1, src2));
+      }
+      else {
+        const __m256i absdiff = _mm256_or_si256(_mm256_subs_epu8(src1, src2), _mm256_subs_epu8(src2, src1));
+        const __m256i even = _mm256_and_si256(absdiff, luma);
+        const __m256i odd = _mm256_srli_epi16(absdiff, 8);
+        if constexpr (SAD)
+          acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_add_epi16(even, odd), one));
+        else if constexpr (lumaonly)
+          acc = _mm256_add_epi32(acc, _mm256_madd_epi16(even, even));
+        else
+          acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_madd_epi16(even, even), _mm256_madd_epi16(odd, odd)));
+      }
+      p1 += pitch1;
+      p2 += pitch2;
+    }
+    alignas(32) int lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    for (int b = 0; b < blocks_per_chunk; ++b)
+    {
+      int sum = 0;
+      for (int i = 0; i < lanes_per_block; ++i)
+        sum += lanes[b * lanes_per_block + i];
+      sums[c * blocks_per_chunk + b] = sum;
+    }
+  }
+  return chunks * blocks_per_chunk;
+}
+
+template int calcBlockRow_AVX2<true, 4, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<true, 8, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<true, 16, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<true, 32, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<true, 8, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<true, 32, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<false, 4, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<false, 8, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<false, 16, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<false, 32, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<false, 8, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX2<false, 32, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
@@ -0,0 +1,102 @@
+/*
+**                    TIVTC for AviSynth 2.6 interface
+**
+**   TIVTC includes a field matching filter (TFM) and a decimation
+**   filter (TDecimate) which can be used together to achieve an
+**   IVTC or for other uses. TIVTC currently supports 8 bit planar YUV and
+**   YUY2 colorspaces.
+**
+**   Copyright (C) 2004-2008 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// AVX-512 kernels: this file is compiled with AVX512F and AVX512BW enabled (*_avx512.cpp pattern)
+
+#include "TDecimateASM.h"
+#include <immintrin.h>
+
+#if !defined(__AVX512BW__) && (defined(GCC) || defined(CLANG))
+#error This source file will only work properly when compiled with AVX512 option. Set __AVX512BW__ or use -mavx512f -mavx512bw
+#endif
+
+// see calcBlockRow_AVX2, the same with 64 byte chunks
+template<bool SAD, int blkw, bool lumaonly>
+int calcBlockRow_AVX512(const uint8_t* ptr1, const uint8_t* ptr2,
+  int pitch1, int pitch2, int nblocks, int blkh, int* sums)
+{
+  constexpr int blocks_per_chunk = 64 / blkw;
+  constexpr int lanes_per_block = blkw / 4;
+  const int chunks = nblocks / blocks_per_chunk;
+
+  const __m512i luma = _mm512_set1_epi16(0x00FF);
+  const __m512i one = _mm512_set1_epi16(1);
+
+  for (int c = 0; c < chunks; ++c)
+  {
+    const uint8_t* p1 = ptr1 + c * 64;
+    const uint8_t* p2 = ptr2 + c * 64;
+    __m512i acc = _mm512_setzero_si512();
+    for (int y = 0; y < blkh; ++y)
+    {
+      __m512i src1 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(p1));
+      __m512i src2 = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(p2));
+      if constexpr (lumaonly) {
+        src1 = _mm512_and_si512(src1, luma);
+        src2 = _mm512_and_si512(src2, luma);
+      }
+      if constexpr (SAD && blkw >= 8) {
+        // 64 bit lanes, the upper 32 bits stay zero
+        acc = _mm512_add_epi32(acc, _mm512_sad_epu8(src1, src2));
+      }
+      else {
+        const __m512i absdiff = _mm512_or_si512(_mm512_subs_epu8(src1, src2), _mm512_subs_epu8(src2, src1));
+        const __m512i even = _mm512_and_si512(absdiff, luma);
+        const __m512i odd = _mm512_srli_epi16(absdiff, 8);
+        if constexpr (SAD)
+          acc = _mm512_add_epi32(acc, _mm512_madd_epi16(_mm512_add_epi16(even, odd), one));
+        else if constexpr (lumaonly)
+          acc = _mm512_add_epi32(acc, _mm512_madd_epi16(even, even));
+        else
+          acc = _mm512_add_epi32(acc, _mm512_add_epi32(_mm512_madd_epi16(even, even), _mm512_madd_epi16(odd, odd)));
+      }
+      p1 += pitch1;
+      p2 += pitch2;
+    }
+    alignas(64) int lanes[16];
+    _mm512_store_si512(reinterpret_cast<__m512i*>(lanes), acc);
+    for (int b = 0; b < blocks_per_chunk; ++b)
+    {
+      int sum = 0;
+      for (int i = 0; i < lanes_per_block; ++i)
+        sum += lanes[b * lanes_per_block + i];
+      sums[c * blocks_per_chunk + b] = sum;
+    }
+  }
+  return chunks * blocks_per_chunk;
+}
+
+template int calcBlockRow_AVX512<true, 4, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<true, 8, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<true, 16, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<true, 32, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<true, 8, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<true, 32, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<false, 4, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<false, 8, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<false, 16, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<false, 32, false>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<false, 8, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
+template int calcBlockRow_AVX512<false, 32, true>(const uint8_t* ptr1, const uint8_t* ptr2, int pitch1, int pitch2, int nblocks, int blkh, int* sums);
@@ -27,10 +27,10 @@
 #include "TDecimateASM.h"
 
 // hbd ready
-void blurFrame(PVideoFrame &src, PVideoFrame &dst, int iterations,
-  bool bchroma, IScriptEnvironment *env, VideoInfo& vi_t, int cpuFlags)
+// tmp: work frame of the caller
+void blurFrame(PVideoFrame &src, PVideoFrame &dst, PVideoFrame &tmp, int iterations,
+  bool bchroma, VideoInfo& vi_t, int cpuFlags)
 {
-  PVideoFrame tmp = env->NewVideoFrame(vi_t);
   HorizontalBlur(src, tmp, bchroma, vi_t, cpuFlags);
   VerticalBlur(tmp, dst, bchroma, vi_t, cpuFlags);
   for (int i = 1; i < iterations; ++i)
@@ -25,6 +25,7 @@
 
 #include "TDecimate.h"
 #include <algorithm>
+#include <vector>
 #include "info.h"
 
 PVideoFrame TDecimate::GetFrameMode2(int n, IScriptEnvironment *env, const VideoInfo& vi)
@@ -32,48 +33,48 @@ PVideoFrame TDecimate::GetFrameMode2(int n, IScriptEnvironment *env, const Video
   int ret = -20;
   if (mode2_numCycles >= 0)
   {
-    int cycleF = -20;
-    for (int x = 0; x < mode2_numCycles; ++x)
+    const int cycleF = findCycleMode2(n);
+    if (cycleF >= 0 && mode2_decA[aLUT[cycleF * 5]] != -20)
     {
-      if (aLUT[x * 5 + 1] <= n && aLUT[x * 5 + 3] > n)
-      {
-        cycleF = x;
-        break;
-      }
+      // cycle was already marked, the decision only needs mode2_decA
+      ret = getNonDecMode2(n - aLUT[cycleF * 5 + 1], aLUT[cycleF * 5], aLUT[cycleF * 5 + 2]);
     }
-    if (cycleF > 0 && prev.frame != aLUT[(cycleF - 1) * 5])
+    else
     {
-      if (curr.frame == aLUT[(cycleF - 1) * 5]) prev = curr;
-      else
+      if (cycleF > 0 && prev.frame != aLUT[(cycleF - 1) * 5])
       {
-        prev.setFrame(aLUT[(cycleF - 1) * 5]);
-        getOvrCycle(prev, true);
-        calcMetricCycle(prev, env, vi, true, false);
-        addMetricCycle(prev);
+        if (curr.frame == aLUT[(cycleF - 1) * 5]) prev.swap(curr);
+        else
+        {
+          prev.setFrame(aLUT[(cycleF - 1) * 5]);
+          getOvrCycle(prev, true);
+          calcMetricCycle(prev, env, vi, true, false);
+          addMetricCycle(prev);
+        }
       }
-    }
-    else if (cycleF <= 0) prev.setFrame(-prev.length);
-    if (curr.frame != aLUT[cycleF * 5])
-    {
-      if (next.frame == aLUT[cycleF * 5]) curr = next;
-      else
+      else if (cycleF <= 0) prev.setFrame(-prev.length);
+      if (curr.frame != aLUT[cycleF * 5])
       {
-        curr.setFrame(aLUT[cycleF * 5]);
-        getOvrCycle(curr, true);
-        calcMetricCycle(curr, env, vi, true, false);
-        addMetricCycle(curr);
+        if (next.frame == aLUT[cycleF * 5]) curr.swap(next);
+        else
+        {
+          curr.setFrame(aLUT[cycleF * 5]);
+          getOvrCycle(curr, true);
+          calcMetricCycle(curr, env, vi, true, false);
+          addMetricCycle(curr);
+        }
       }
+      if (cycleF < mode2_numCycles - 1 && next.frame != aLUT[(cycleF + 1) * 5])
+      {
+        next.setFrame(aLUT[(cycleF + 1) * 5]);
+        getOvrCycle(next, true);
+        calcMetricCycle(next, env, vi, true, false);
+        addMetricCycle(next);
+      }
+      else if (cycleF >= mode2_numCycles - 1) next.setFrame(-next.length);
+      mode2MarkDecFrames(cycleF);
+      ret = getNonDecMode2(n - aLUT[cycleF * 5 + 1], aLUT[cycleF * 5], aLUT[cycleF * 5 + 2]);
     }
-    if (cycleF < mode2_numCycles - 1 && next.frame != aLUT[(cycleF + 1) * 5])
-    {
-      next.setFrame(aLUT[(cycleF + 1) * 5]);
-      getOvrCycle(next, true);
-      calcMetricCycle(next, env, vi, true, false);
-      addMetricCycle(next);
-    }
-    else if (cycleF >= mode2_numCycles - 1) next.setFrame(-next.length);
-    mode2MarkDecFrames(cycleF);
-    ret = getNonDecMode2(n - aLUT[cycleF * 5 + 1], aLUT[cycleF * 5], aLUT[cycleF * 5 + 2]);
   }
   else ret = aLUT[n];
   if (ret < 0)
@@ -106,6 +107,22 @@ PVideoFrame TDecimate::GetFrameMode2(int n, IScriptEnvironment *env, const Video
   return clip2->GetFrame(ret, env);
 }
 
+// Cycle holding output frame n. Output starts (aLUT[x * 5 + 1]) are ascending,
+// a cycle with everything dropped has the same start as the one after it.
+int TDecimate::findCycleMode2(int n)
+{
+  int lo = 0, hi = mode2_numCycles; // first cycle starting after n
+  while (lo < hi)
+  {
+    const int mid = (lo + hi) >> 1;
+    if (aLUT[mid * 5 + 1] <= n) lo = mid + 1;
+    else hi = mid;
+  }
+  const int x = lo - 1;
+  if (x < 0 || aLUT[x * 5 + 3] <= n) return -20;
+  return x;
+}
+
 int TDecimate::getNonDecMode2(int n, int start, int stop)
 {
   int count = -1, ret = -1;
@@ -323,8 +340,23 @@ void TDecimate::removeMinN(int m, int n, uint64_t *metricsT, int *orderT, int &o
   }
 }
 
+// Ascending, equal metrics keep their order.
 void TDecimate::sortMetrics(uint64_t *metrics, int *order, int length)
 {
+  if (length > 32)
+  {
+    std::vector<std::pair<uint64_t, int>> t(length);
+    for (int i = 0; i < length; ++i)
+      t[i] = std::make_pair(metrics[i], order[i]);
+    std::stable_sort(t.begin(), t.end(),
+      [](const std::pair<uint64_t, int>& a, const std::pair<uint64_t, int>& b) { return a.first < b.first; });
+    for (int i = 0; i < length; ++i)
+    {
+      metrics[i] = t[i].first;
+      order[i] = t[i].second;
+    }
+    return;
+  }
   for (int i = 1; i < length; ++i)
   {
     int j = i;
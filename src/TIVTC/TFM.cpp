@@ -28,6 +28,7 @@
 #include "TCommonASM.h"
 #include "avs/alignment.h"
 #include "info.h"
+#include "hintprop.h"
 
 PVideoFrame __stdcall TFM::GetFrame(int n, IScriptEnvironment* env)
 {
@@ -36,8 +37,8 @@ PVideoFrame __stdcall TFM::GetFrame(int n, IScriptEnvironment* env)
   PVideoFrame prv = child->GetFrame(n > 0 ? n - 1 : 0, env);
   PVideoFrame src = child->GetFrame(n, env);
   PVideoFrame nxt = child->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-  PVideoFrame dst = has_at_least_v8 ? env->NewVideoFrameP(vi, &src) : env->NewVideoFrame(vi);
-  PVideoFrame tmp = env->NewVideoFrame(vi);
+  // allocated on demand by createWeaveFrame, a c match is src itself
+  PVideoFrame dst, tmp;
   int dfrm = -20, tfrm = -20;
   int mmatch1, nmatch1, nmatch2, mmatch2, fmatch, tmatch;
   int combed = -1, tcombed = -1, xblocks = -20;
@@ -91,6 +92,8 @@ PVideoFrame __stdcall TFM::GetFrame(int n, IScriptEnvironment* env)
       }
     }
     fileOut(fmatch, combed, d2vfilm, n, mics[fmatch], mics);
+    analysisRecord(n, fmatch, combed, mics, -1, -1, -1, -1); // no field compare on overrides
+    if (display) env->MakeWritable(&dst);
     if (display) writeDisplay(dst, vi, n, fmatch, combed, true, blockN[fmatch], xblocks,
       d2vmatch, mics, prv, src, nxt, env);
     if (debug)
@@ -123,7 +126,7 @@ PVideoFrame __stdcall TFM::GetFrame(int n, IScriptEnvironment* env)
         OutputDebugString(buf);
       }
     }
-    if (usehints || PP >= 2) putHint(vi, dst, fmatch, combed, d2vfilm);
+    if (usehints || PP >= 2) putHint(vi, dst, fmatch, combed, d2vfilm, env);
     lastMatch.frame = n;
     lastMatch.match = fmatch;
     lastMatch.field = field;
@@ -150,8 +153,8 @@ d2vCJump:
       {
         fmatch = scndT;
         tcombed = 0;
-        copyFrame(dst, tmp, vi, env);
-        dfrm = fmatch;
+        std::swap(dst, tmp);
+        std::swap(dfrm, tfrm);
       }
       else
       {
@@ -160,8 +163,8 @@ d2vCJump:
         {
           fmatch = thrdT;
           tcombed = 0;
-          copyFrame(dst, tmp, vi, env);
-          dfrm = fmatch;
+          std::swap(dst, tmp);
+          std::swap(dfrm, tfrm);
         }
         else
         {
@@ -170,8 +173,8 @@ d2vCJump:
           {
             fmatch = frthT;
             tcombed = 0;
-            copyFrame(dst, tmp, vi, env);
-            dfrm = fmatch;
+            std::swap(dst, tmp);
+            std::swap(dfrm, tfrm);
           }
         }
       }
@@ -256,8 +259,8 @@ d2vCJump:
           {
             fmatch = tmatch;
             tcombed = 0;
-            copyFrame(dst, tmp, vi, env);
-            dfrm = fmatch;
+            std::swap(dst, tmp);
+            std::swap(dfrm, tfrm);
           }
         }
       }
@@ -277,8 +280,8 @@ d2vCJump:
           {
             fmatch = tmatch;
             tcombed = 0;
-            copyFrame(dst, tmp, vi, env);
-            dfrm = fmatch;
+            std::swap(dst, tmp);
+            std::swap(dfrm, tfrm);
           }
           else
             createWeaveFrame(dst, prv, src, nxt, env, fmatch, dfrm, vi);
@@ -428,6 +431,8 @@ d2vCJump:
   }
   d2vfilm = d2vduplicate(fmatch, combed, n);
   fileOut(fmatch, combed, d2vfilm, n, mics[fmatch], mics);
+  analysisRecord(n, fmatch, combed, mics, nmatch1, nmatch2, mmatch1, mmatch2);
+  if (display) env->MakeWritable(&dst);
   if (display) writeDisplay(dst, vi, n, fmatch, combed, false, blockN[fmatch], xblocks,
     d2vmatch, mics, prv, src, nxt, env);
   if (debug)
@@ -460,7 +465,7 @@ d2vCJump:
       OutputDebugString(buf);
     }
   }
-  if (usehints || PP >= 2) putHint(vi, dst, fmatch, combed, d2vfilm);
+  if (usehints || PP >= 2) putHint(vi, dst, fmatch, combed, d2vfilm, env);
   lastMatch.frame = n;
   lastMatch.match = fmatch;
   lastMatch.field = field;
@@ -743,6 +748,22 @@ void TFM::fileOut(int match, int combed, bool d2vfilm, int n, int MICount, int m
   }
 }
 
+void TFM::analysisRecord(int n, int match, int combed, const int mics[5], int norm1, int norm2, int mtn1, int mtn2)
+{
+  if (!analysisOut.enabled()) return;
+  AnalysisRecord rec = emptyAnalysisRecord(ANALYSIS_TFM, n);
+  rec.field = field;
+  rec.match = match;
+  rec.combed = combed;
+  for (int i = 0; i < 5; ++i)
+    rec.mics[i] = mics[i] < 0 ? -1 : mics[i]; // -20: not checked
+  rec.counts[0] = norm1;
+  rec.counts[1] = norm2;
+  rec.counts[2] = mtn1;
+  rec.counts[3] = mtn2;
+  analysisOut.write(rec);
+}
+
 
 bool TFM::checkCombed(PVideoFrame &src, int n, IScriptEnvironment *env, const VideoInfo &vi, int match,
   int *blockN, int &xblocksi, int *mics, bool ddebug, bool chroma, int cthresh)
@@ -786,6 +807,10 @@ int TFM::compareFields_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame &nxt
   uint64_t accumPm = 0, accumNm = 0;
   norm1 = norm2 = mtn1 = mtn2 = 0;
 
+  // SIMD row kernels, the C loops below finish the remaining pixels
+  compareFieldsRow_fn_t* compareFieldsRow_fn = get_compareFieldsRow_fn<0>(sizeof(pixel_t), cpuFlags);
+  uint64_t accum[6] = { 0 }; // Pc, Nc, Pm, Nm, (Pml, Nml)
+
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   for (int b = 0; b < stop; ++b)
   {
@@ -922,7 +947,16 @@ int TFM::compareFields_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame &nxt
     for (int y = 2; y < Height - 2; y += 2) {
       if ((y < y0a) || noBandExclusion || (y > y1a))  // exclusion area check
       {
-        for (int x = startx; x < stopx; x += incl)
+        int x = startx;
+        if (compareFieldsRow_fn) {
+          const CompareFieldsLines lines = { mapp, mapn,
+            reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+            reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+            reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+            nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, 0, 0 };
+          x = compareFieldsRow_fn(lines, startx, stopx, incl == 2, Const23, Const42, accum);
+        }
+        for (; x < stopx; x += incl)
         {
           int eax = (mapp[x] << 2) + mapn[x];
           if ((eax & 0xFF) == 0)
@@ -1073,6 +1107,11 @@ int TFM::compareFields_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame &nxt
 #endif
   }
 
+  accumPc += accum[0];
+  accumNc += accum[1];
+  accumPm += accum[2];
+  accumNm += accum[3];
+
   // High bit depth: I chose to scale back to 8 bit range.
   // Or else we should treat them as int64 and act upon them outside
   const double factor = 1.0 / (1 << (bits_per_pixel - 8));
@@ -1152,6 +1191,10 @@ int TFM::compareFieldsSlow_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
   uint64_t accumPml = 0, accumNml = 0; // plus compared to CompareFields
   norm1 = norm2 = mtn1 = mtn2 = 0;
 
+  // SIMD row kernels, the C loops below finish the remaining pixels
+  compareFieldsRow_fn_t* compareFieldsRow_fn = get_compareFieldsRow_fn<1>(sizeof(pixel_t), cpuFlags);
+  uint64_t accum[6] = { 0 }; // Pc, Nc, Pm, Nm, Pml, Nml
+
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   for (int b = 0; b < stop; ++b)
   {
@@ -1306,7 +1349,16 @@ int TFM::compareFieldsSlow_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
     for (int y = 2; y < Height - 2; y += 2) {
       if ((y < y0a) || noBandExclusion || (y > y1a)) // exclusion area check
       {
-        for (int x = startx; x < stopx; x += incl)
+        int x = startx;
+        if (compareFieldsRow_fn) {
+          const CompareFieldsLines lines = { mapp, mapn,
+            reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+            reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+            reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+            nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, 0, 0 };
+          x = compareFieldsRow_fn(lines, startx, stopx, incl == 2, Const23, Const42, accum);
+        }
+        for (; x < stopx; x += incl)
         {
           // diff from prev asm block (at buildDiffMapPlane2): <<3 instead of <<2
           int eax = (mapp[x] << 3) + mapn[x];
@@ -1483,6 +1535,13 @@ int TFM::compareFieldsSlow_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
 #endif
   }
 
+  accumPc += accum[0];
+  accumNc += accum[1];
+  accumPm += accum[2];
+  accumNm += accum[3];
+  accumPml += accum[4];
+  accumNml += accum[5];
+
   const int Const500 = 500 << (bits_per_pixel - 8);
   if (accumPm < Const500 && accumNm < Const500 && (accumPml >= Const500 || accumNml >= Const500) &&
     std::max(accumPml, accumNml) > 3 * std::min(accumPml, accumNml))
@@ -1551,6 +1610,10 @@ int TFM::compareFieldsSlow2_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
   uint64_t accumPm = 0, accumNm = 0;
   uint64_t accumPml = 0, accumNml = 0; // plus compared to CompareFields
   norm1 = norm2 = mtn1 = mtn2 = 0;
+
+  // SIMD row kernels, the C loops below finish the remaining pixels
+  compareFieldsRow_fn_t* compareFieldsRow_fn = get_compareFieldsRow_fn<2>(sizeof(pixel_t), cpuFlags);
+  uint64_t accum[6] = { 0 }; // Pc, Nc, Pm, Nm, Pml, Nml
   
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   for (int b = 0; b < stop; ++b)
@@ -1712,7 +1775,18 @@ int TFM::compareFieldsSlow2_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
       for (int y = 2; y < Height - 2; y += 2) {
         if ((y < y0a) || noBandExclusion || (y > y1a))
         {
-          for (int x = startx; x < stopx; x += incl)
+          int x = startx;
+          if (compareFieldsRow_fn) {
+            const CompareFieldsLines lines = { mapp, mapn,
+              reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+              reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+              reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+              reinterpret_cast<const uint8_t*>(prvppf), reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+              reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf),
+              reinterpret_cast<const uint8_t*>(nxtppf), reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf), 3, 0, 0 };
+            x = compareFieldsRow_fn(lines, startx, stopx, incl == 2, Const23, Const42, accum);
+          }
+          for (; x < stopx; x += incl)
           {
             int eax = (mapp[x] << 3) + mapn[x]; // diff from prev asm block (at buildDiffMapPlane2): <<3 instead of <<2
             if ((eax & 0xFF) == 0)
@@ -1798,7 +1872,18 @@ int TFM::compareFieldsSlow2_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
       for (int y = 2; y < Height - 2; y += 2) {
         if ((y < y0a) || noBandExclusion || (y > y1a))
         {
-          for (int x = startx; x < stopx; x += incl)
+          int x = startx;
+          if (compareFieldsRow_fn) {
+            const CompareFieldsLines lines = { mapp, mapn,
+              reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf),
+              reinterpret_cast<const uint8_t*>(curpf), reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+              reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf),
+              reinterpret_cast<const uint8_t*>(prvpf), reinterpret_cast<const uint8_t*>(prvnf), reinterpret_cast<const uint8_t*>(prvnnf),
+              reinterpret_cast<const uint8_t*>(curf), reinterpret_cast<const uint8_t*>(curnf),
+              reinterpret_cast<const uint8_t*>(nxtpf), reinterpret_cast<const uint8_t*>(nxtnf), reinterpret_cast<const uint8_t*>(nxtnnf), 0, 0, 0 };
+            x = compareFieldsRow_fn(lines, startx, stopx, incl == 2, Const23, Const42, accum);
+          }
+          for (; x < stopx; x += incl)
           {
             int eax = (mapp[x] << 3) + mapn[x]; // diff from prev asm block (at buildDiffMapPlane2): <<3 instead of <<2
             if ((eax & 0xFF) == 0)
@@ -2294,6 +2379,13 @@ int TFM::compareFieldsSlow2_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
 #endif
   }
 
+  accumPc += accum[0];
+  accumNc += accum[1];
+  accumPm += accum[2];
+  accumNm += accum[3];
+  accumPml += accum[4];
+  accumNml += accum[5];
+
   const int Const500 = 500 << (bits_per_pixel - 8);
   if (accumPm < Const500 && accumNm < Const500 && (accumPml >= Const500 || accumNml >= Const500) &&
     std::max(accumPml, accumNml) > 3 * std::min(accumPml, accumNml))
@@ -2453,78 +2545,111 @@ bool TFM::checkSceneChange_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
   int n, int bits_per_pixel)
 {
   if (sclast.frame == n + 1) return sclast.sc;
+
+  // neighbours are clamped the same way as in GetFrame
+  const int prvn = n > 0 ? n - 1 : 0;
+  const int nxtn = n < nfrms ? n + 1 : nfrms;
+  // a frame compared to itself has no difference, nothing to cache
+  SCPAIR* scp = prvn == n ? nullptr : &scCache[prvn & (SC_CACHE_SIZE - 1)];
+  SCPAIR* scn = nxtn == n ? nullptr : &scCache[n & (SC_CACHE_SIZE - 1)];
+  const bool needp = scp && (scp->frame != prvn || scp->field != field);
+  const bool needn = scn && (scn->frame != n || scn->field != field);
+
   uint64_t diffp = 0;
   uint64_t diffn = 0;
-  const uint8_t *prvp = prv->GetReadPtr(PLANAR_Y);
-  const uint8_t *srcp = src->GetReadPtr(PLANAR_Y);
-  const uint8_t *nxtp = nxt->GetReadPtr(PLANAR_Y);
-  const int height = src->GetHeight(PLANAR_Y) >> 1;
-  const int rowsize = src->GetRowSize(PLANAR_Y);
-  int width = rowsize / sizeof(pixel_t);
-  // this mod16 must be the same as in computing "diffmaxsc"
-  
-  // safe mod16 rounding for SSE2 in mind
-  if (vi.IsPlanar()) 
-    width = ((width >> 4) << 4); // mod16
-  else // YUY2
-    width = ((width >> 5) << 5); // mod32
+  if (needp || needn)
+  {
+    const uint8_t *prvp = prv->GetReadPtr(PLANAR_Y);
+    const uint8_t *srcp = src->GetReadPtr(PLANAR_Y);
+    const uint8_t *nxtp = nxt->GetReadPtr(PLANAR_Y);
+    const int height = src->GetHeight(PLANAR_Y) >> 1;
+    const int rowsize = src->GetRowSize(PLANAR_Y);
+    int width = rowsize / sizeof(pixel_t);
+    // this mod16 must be the same as in computing "diffmaxsc"
 
-  // every 2nd line
-  int prv_pitch = prv->GetPitch(PLANAR_Y) << 1;
-  int src_pitch = src->GetPitch(PLANAR_Y) << 1;
-  int nxt_pitch = nxt->GetPitch(PLANAR_Y) << 1;
-  prvp += (1 - field)*(prv_pitch >> 1);
-  srcp += (1 - field)*(src_pitch >> 1);
-  nxtp += (1 - field)*(nxt_pitch >> 1);
+    // safe mod16 rounding for SSE2 in mind
+    if (vi.IsPlanar())
+      width = ((width >> 4) << 4); // mod16
+    else // YUY2
+      width = ((width >> 5) << 5); // mod32
 
-  bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+    // every 2nd line
+    int prv_pitch = prv->GetPitch(PLANAR_Y) << 1;
+    int src_pitch = src->GetPitch(PLANAR_Y) << 1;
+    int nxt_pitch = nxt->GetPitch(PLANAR_Y) << 1;
+    prvp += (1 - field)*(prv_pitch >> 1);
+    srcp += (1 - field)*(src_pitch >> 1);
+    nxtp += (1 - field)*(nxt_pitch >> 1);
 
-  if (sclast.frame == n)
-  {
-    diffp = ((uint64_t)sclast.diff) << (bits_per_pixel - 8);
-    if (vi.IsPlanar())
-      if (sizeof(pixel_t) == 1 && use_sse2)
-        checkSceneChangePlanar_1_SSE2(srcp, nxtp, height, width, src_pitch, nxt_pitch, diffn);
+    bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+
+    if (needp && needn)
+    {
+      if (vi.IsPlanar())
+        if (sizeof(pixel_t) == 1 && use_sse2)
+          checkSceneChangePlanar_2_SSE2(prvp, srcp, nxtp, height, width, prv_pitch, src_pitch, nxt_pitch, diffp, diffn);
+        else
+          checkSceneChangePlanar_2_c<pixel_t>(
+            reinterpret_cast<const pixel_t*>(prvp),
+            reinterpret_cast<const pixel_t*>(srcp),
+            reinterpret_cast<const pixel_t*>(nxtp),
+            height, width,
+            prv_pitch / sizeof(pixel_t),
+            src_pitch / sizeof(pixel_t),
+            nxt_pitch / sizeof(pixel_t),
+            diffp, diffn);
       else
-        checkSceneChangePlanar_1_c<pixel_t>(
-          reinterpret_cast<const pixel_t*>(srcp),
-          reinterpret_cast<const pixel_t*>(nxtp),
-          height, width, 
-          src_pitch / sizeof(pixel_t), 
-          nxt_pitch / sizeof(pixel_t),
-          diffn);
+        if (use_sse2)
+          checkSceneChangeYUY2_2_SSE2(prvp, srcp, nxtp, height, width, prv_pitch, src_pitch, nxt_pitch, diffp, diffn);
+        else
+          checkSceneChangeYUY2_2_c(prvp, srcp, nxtp, height, width, prv_pitch, src_pitch, nxt_pitch, diffp, diffn);
+    }
     else
-      if (use_sse2)
-        checkSceneChangeYUY2_1_SSE2(srcp, nxtp, height, width, src_pitch, nxt_pitch, diffn);
+    {
+      // only one of the pairs is missing
+      const uint8_t* ap = needp ? prvp : srcp;
+      const uint8_t* bp = needp ? srcp : nxtp;
+      const int a_pitch = needp ? prv_pitch : src_pitch;
+      const int b_pitch = needp ? src_pitch : nxt_pitch;
+      uint64_t& diff = needp ? diffp : diffn;
+      if (vi.IsPlanar())
+        if (sizeof(pixel_t) == 1 && use_sse2)
+          checkSceneChangePlanar_1_SSE2(ap, bp, height, width, a_pitch, b_pitch, diff);
+        else
+          checkSceneChangePlanar_1_c<pixel_t>(
+            reinterpret_cast<const pixel_t*>(ap),
+            reinterpret_cast<const pixel_t*>(bp),
+            height, width,
+            a_pitch / sizeof(pixel_t),
+            b_pitch / sizeof(pixel_t),
+            diff);
       else
-        checkSceneChangeYUY2_1_c(srcp, nxtp, height, width, src_pitch, nxt_pitch, diffn);
+        if (use_sse2)
+          checkSceneChangeYUY2_1_SSE2(ap, bp, height, width, a_pitch, b_pitch, diff);
+        else
+          checkSceneChangeYUY2_1_c(ap, bp, height, width, a_pitch, b_pitch, diff);
+    }
+
+    // scale back to 8 bit world
+    diffn >>= (bits_per_pixel - 8);
+    diffp >>= (bits_per_pixel - 8);
   }
-  else
-  {
-    if (vi.IsPlanar())
-      if (sizeof(pixel_t) == 1 && use_sse2)
-        checkSceneChangePlanar_2_SSE2(prvp, srcp, nxtp, height, width, prv_pitch, src_pitch, nxt_pitch, diffp, diffn);
-      else
-        checkSceneChangePlanar_2_c<pixel_t>(
-          reinterpret_cast<const pixel_t*>(prvp), 
-          reinterpret_cast<const pixel_t*>(srcp),
-          reinterpret_cast<const pixel_t*>(nxtp),
-          height, width, 
-          prv_pitch / sizeof(pixel_t),
-          src_pitch / sizeof(pixel_t),
-          nxt_pitch / sizeof(pixel_t),
-          diffp, diffn);
-    else
-      if (use_sse2)
-        checkSceneChangeYUY2_2_SSE2(prvp, srcp, nxtp, height, width, prv_pitch, src_pitch, nxt_pitch, diffp, diffn);
-      else
-        checkSceneChangeYUY2_2_c(prvp, srcp, nxtp, height, width, prv_pitch, src_pitch, nxt_pitch, diffp, diffn);
+
+  if (needp) {
+    scp->frame = prvn;
+    scp->field = field;
+    scp->diff = (unsigned long)diffp;
   }
+  else if (scp)
+    diffp = scp->diff;
+  if (needn) {
+    scn->frame = n;
+    scn->field = field;
+    scn->diff = (unsigned long)diffn;
+  }
+  else if (scn)
+    diffn = scn->diff;
 
-  // scale back to 8 bit world
-  diffn >>= (bits_per_pixel - 8);
-  diffp >>= (bits_per_pixel - 8);
-  
   if (debug)
   {
     sprintf(buf, "TFM:  frame %d  - diffp = %u   diffn = %u  diffmaxsc = %u  %c\n", n, (unsigned int)diffp, (unsigned int)diffn, (unsigned int)diffmaxsc,
@@ -2532,7 +2657,6 @@ bool TFM::checkSceneChange_core(PVideoFrame &prv, PVideoFrame &src, PVideoFrame
     OutputDebugString(buf);
   }
   sclast.frame = n + 1;
-  sclast.diff = (unsigned long)diffn;
   sclast.sc = true;
   if (diffp > diffmaxsc || diffn > diffmaxsc) return true;
   sclast.sc = false;
@@ -2545,6 +2669,17 @@ void TFM::createWeaveFrame(PVideoFrame &dst, PVideoFrame &prv, PVideoFrame &src,
   if (cfrm == match)
     return;
 
+  if (match == 1)
+  {
+    // the c match is the current frame as is, no copy
+    dst = src;
+    cfrm = match;
+    return;
+  }
+  // dst may still reference src or the other buffer from a previous c match
+  if (!dst || !dst->IsWritable())
+    dst = has_at_least_v8 ? env->NewVideoFrameP(vi, &src) : env->NewVideoFrame(vi);
+
   const int np = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
   for (int b = 0; b < np; ++b)
@@ -2559,11 +2694,6 @@ void TFM::createWeaveFrame(PVideoFrame &dst, PVideoFrame &prv, PVideoFrame &src,
         prv->GetReadPtr(plane) + field*prv->GetPitch(plane), prv->GetPitch(plane) << 1,
         prv->GetRowSize(plane), prv->GetHeight(plane) >> 1);
     }
-    else if (match == 1)
-    {
-      env->BitBlt(dst->GetWritePtr(plane), dst->GetPitch(plane), src->GetReadPtr(plane),
-        src->GetPitch(plane), src->GetRowSize(plane), src->GetHeight(plane));
-    }
     else if (match == 2)
     {
       env->BitBlt(dst->GetWritePtr(plane) + (1 - field)*dst->GetPitch(plane), dst->GetPitch(plane) << 1,
@@ -2596,19 +2726,32 @@ void TFM::createWeaveFrame(PVideoFrame &dst, PVideoFrame &prv, PVideoFrame &src,
   cfrm = match;
 }
 
-void TFM::putHint(const VideoInfo& vi, PVideoFrame& dst, int match, int combed, bool d2vfilm)
+// A frame passed through by reference (c match) gets its own props by shareFrame
+// and the hint as frame property, otherwise it goes to the pixels as usual,
+// see hintprop.h
+void TFM::putHint(const VideoInfo& vi, PVideoFrame& dst, int match, int combed, bool d2vfilm, IScriptEnvironment *env)
 {
+  const unsigned int hint = vi.ComponentSize() == 1 ?
+    buildHint_core<uint8_t>(dst, match, combed, d2vfilm) :
+    buildHint_core<uint16_t>(dst, match, combed, d2vfilm);
+  if (has_at_least_v8 && !dst->IsWritable())
+  {
+    dst = shareFrame(dst, vi, env); // src passed through, props must not go to the upstream frame
+    setPropHint(dst, hint, env);
+    return;
+  }
+  env->MakeWritable(&dst);
+  if (has_at_least_v8) clearPropHint(dst, env);
   if (vi.ComponentSize() == 1)
-    putHint_core<uint8_t>(dst, match, combed, d2vfilm);
+    putHint_core<uint8_t>(dst, hint);
   else
-    putHint_core<uint16_t>(dst, match, combed, d2vfilm);
+    putHint_core<uint16_t>(dst, hint);
 }
 
 template<typename pixel_t>
-void TFM::putHint_core(PVideoFrame &dst, int match, int combed, bool d2vfilm)
+unsigned int TFM::buildHint_core(PVideoFrame &dst, int match, int combed, bool d2vfilm)
 {
-  pixel_t *p = reinterpret_cast<pixel_t *>(dst->GetWritePtr(PLANAR_Y));
-  pixel_t *srcp = p;
+  const pixel_t *srcp = reinterpret_cast<const pixel_t *>(dst->GetReadPtr(PLANAR_Y));
   unsigned int i, hint = 0;
   unsigned int hint2 = 0, magic_number = 0;
   if (match == 0) hint |= ISP;
@@ -2635,6 +2778,14 @@ void TFM::putHint_core(PVideoFrame &dst, int match, int combed, bool d2vfilm)
     hint2 &= 0xFF00;
     hint |= hint2 | 0x80;
   }
+  return hint;
+}
+
+template<typename pixel_t>
+void TFM::putHint_core(PVideoFrame &dst, unsigned int hint)
+{
+  pixel_t *p = reinterpret_cast<pixel_t *>(dst->GetWritePtr(PLANAR_Y));
+  unsigned int i;
   for (i = 0; i < 32; ++i)
   {
     *p &= ~1;
@@ -2697,7 +2848,7 @@ AVSValue __cdecl Create_TFM(AVSValue args, void* user_data, IScriptEnvironment*
     args[18].AsInt(16), args[19].AsInt(0), args[20].AsInt(0), args[23].AsString(""), args[24].AsInt(0),
     args[25].AsInt(4), args[26].AsFloat(12.0), args[27].AsInt(0), args[28].AsInt(1), args[29].AsString(""),
     args[30].AsBool(true), args[31].AsInt(0), args[32].AsBool(false), args[33].AsBool(true),
-    args[34].AsBool(true), args[35].AsInt(4), env);
+    args[34].AsBool(true), args[35].AsInt(4), args[36].AsBool(false), args[37].AsString(""), env);
   if (!args[4].IsInt() || args[4].AsInt() >= 2)
   {
     if (!args[4].IsInt() || args[4].AsInt() > 4)
@@ -2717,13 +2868,13 @@ TFM::TFM(PClip _child, int _order, int _field, int _mode, int _PP, const char* _
   int _slow, bool _mChroma, int _cNum, int _cthresh, int _MI, bool _chroma, int _blockx,
   int _blocky, int _y0, int _y1, const char* _d2v, int _ovrDefault, int _flags, double _scthresh,
   int _micout, int _micmatching, const char* _trimIn, bool _usehints, int _metric, bool _batch,
-  bool _ubsco, bool _mmsco, int _opt, IScriptEnvironment* env) : GenericVideoFilter(_child),
+  bool _ubsco, bool _mmsco, int _opt, bool _mcascade, const char* _analysis, IScriptEnvironment* env) : GenericVideoFilter(_child),
   order(_order), field(_field), mode(_mode), PP(_PP), ovr(_ovr), input(_input), output(_output),
   outputC(_outputC), debug(_debug), display(_display), slow(_slow), mChroma(_mChroma), cNum(_cNum),
   cthresh(_cthresh), MI(_MI), chroma(_chroma), blockx(_blockx), blocky(_blocky), y0(_y0),
   y1(_y1), d2v(_d2v), ovrDefault(_ovrDefault), flags(_flags), scthresh(_scthresh), micout(_micout),
   micmatching(_micmatching), trimIn(_trimIn), usehints(_usehints), metric(_metric),
-  batch(_batch), ubsco(_ubsco), mmsco(_mmsco), opt(_opt)
+  mcascade(_mcascade), batch(_batch), ubsco(_ubsco), mmsco(_mmsco), opt(_opt)
 {
   cArray = setArray = moutArray = moutArrayE = NULL;
   ovrArray = outArray = NULL;
@@ -2816,6 +2967,7 @@ TFM::TFM(PClip _child, int _order, int _field, int _mode, int _PP, const char* _
 
   sclast.frame = -20;
   sclast.sc = true;
+  scCache.assign(SC_CACHE_SIZE, SCPAIR{ -20, -1, 0 });
 
   if (mode == 1 || mode == 2 || mode == 3 || mode == 5 || mode == 6 || mode == 7 ||
     PP > 0 || micout > 0 || micmatching > 0)
@@ -3564,6 +3716,12 @@ emptyovr:
     }
     else env->ThrowError("TFM:  outputC file error (cannot create file)!");
   }
+  if (*_analysis && !analysisOut.open(_analysis))
+    env->ThrowError("TFM:  analysis file error (cannot create file)!");
+  // combing detection may stop at the first block above MI unless the actual
+  // MIC values are shown, written or compared against each other
+  earlyExitMI = !debug && !display && micout == 0 && micmatching == 0 && moutArray == NULL &&
+    !analysisOut.enabled();
   AVSValue tfmPassValue(PP);
   const char *varname = "TFMPPValue";
   env->SetVar(varname, tfmPassValue);
@@ -3572,6 +3730,10 @@ emptyovr:
 
 TFM::~TFM()
 {
+  if (!analysisOut.close())
+  {
+    OutputDebugString("TFM:  analysis file error (cannot write file)!\n");
+  }
   if (map) delete map;
   if (cmask) delete cmask;
   if (cArray != NULL) _aligned_free(cArray);
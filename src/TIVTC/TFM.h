@@ -25,12 +25,14 @@
 
 #include <stdio.h>
 #include <malloc.h>
+#include <vector>
 #include <xmmintrin.h>
 #include "Font.h"
 #include "calcCRC.h"
 #include "internal.h"
 #include "profUtil.h"
 #include "PlanarFrame.h"
+#include "analysisout.h"
 #define TFM_INCLUDED
 #ifndef TFMPP_INCLUDED
 #include "TFMPP.h"
@@ -69,7 +71,7 @@ template<int planarType>
 void FillCombedPlanarUpdateCmaskByUV(PlanarFrame* cmask);
 
 template<typename pixel_t>
-void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, PVideoFrame& src, PlanarFrame* cmask);
+void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, bool mcascade, PVideoFrame& src, PlanarFrame* cmask);
 
 struct MTRACK {
   int frame, match;
@@ -78,10 +80,20 @@ struct MTRACK {
 
 struct SCTRACK {
   int frame;
-  unsigned long diff;
   bool sc;
 };
 
+// field difference of 'frame' and 'frame + 1' for the scene change detection
+struct SCPAIR {
+  int frame;
+  int field;
+  unsigned long diff; // scaled to 8 bits
+};
+
+// Number of cached frame pairs, power of 2. Covers the out-of-order requests
+// of the prefetch window, so that each pair is compared only once.
+constexpr int SC_CACHE_SIZE = 64;
+
 class TFM : public GenericVideoFilter
 {
 private:
@@ -111,6 +123,7 @@ private:
   const char* trimIn;
   bool usehints;
   bool metric;
+  bool mcascade; // metric 1 behind a metric 0 style prefilter, same result
   bool batch, ubsco, mmsco;
   int opt;
 
@@ -135,8 +148,11 @@ private:
   int* moutArray;
   int* moutArrayE;
   
+  bool earlyExitMI; // MIC values are only compared against MI
+  AnalysisWriter analysisOut; // analysis="file": binary per-frame records
   MTRACK lastMatch;
   SCTRACK sclast;
+  std::vector<SCPAIR> scCache;
   char buf[4096];
 #ifdef _WIN32
   char outputFull[MAX_PATH + 1];
@@ -162,6 +178,7 @@ private:
     int Width, int bits_per_pixel, IScriptEnvironment *env);
 
   void fileOut(int match, int combed, bool d2vfilm, int n, int MICount, int mics[5]);
+  void analysisRecord(int n, int match, int combed, const int mics[5], int norm1, int norm2, int mtn1, int mtn2);
 
   int compareFields(PVideoFrame &prv, PVideoFrame &src, PVideoFrame &nxt, int match1,
     int match2, int &norm1, int &norm2, int &mtn1, int &mtn2, const VideoInfo &vi, int n, IScriptEnvironment *env);
@@ -190,7 +207,7 @@ private:
     int *blockN, int &xblocksi, int *mics, bool ddebug, bool chroma, int cthresh);
   template<typename pixel_t>
   bool checkCombedPlanar_core(PVideoFrame& src, int n, IScriptEnvironment* env, int match,
-    int* blockN, int& xblocksi, int* mics, bool ddebug, int bits_per_pixel);
+    int* blockN, int& xblocksi, int* mics, bool ddebug, int bits_per_pixel, bool streamMask, int cthresh);
   bool checkCombedYUY2(PVideoFrame &src, int n, IScriptEnvironment *env, int match,
     int *blockN, int &xblocksi, int *mics, bool ddebug, bool chroma,int cthresh);
   
@@ -198,9 +215,11 @@ private:
     int blockN, int xblocks, bool d2vmatch, int *mics, PVideoFrame &prv,
     PVideoFrame &src, PVideoFrame &nxt, IScriptEnvironment *env);
 
-  void putHint(const VideoInfo &vi, PVideoFrame& dst, int match, int combed, bool d2vfilm);
+  void putHint(const VideoInfo &vi, PVideoFrame& dst, int match, int combed, bool d2vfilm, IScriptEnvironment *env);
+  template<typename pixel_t>
+  unsigned int buildHint_core(PVideoFrame &dst, int match, int combed, bool d2vfilm);
   template<typename pixel_t>
-  void putHint_core(PVideoFrame &dst, int match, int combed, bool d2vfilm);
+  void putHint_core(PVideoFrame &dst, unsigned int hint);
 
   void parseD2V(IScriptEnvironment *env);
   int D2V_find_and_correct(int *array, bool &found, int &tff);
@@ -244,7 +263,7 @@ public:
     bool _mChroma, int _cNum, int _cthresh, int _MI, bool _chroma, int _blockx, int _blocky,
     int _y0, int _y1, const char* _d2v, int _ovrDefault, int _flags, double _scthresh, int _micout,
     int _micmatching, const char* _trimIn, bool _usehints, int _metric, bool _batch, bool _ubsco,
-    bool _mmsco, int _opt, IScriptEnvironment* env);
+    bool _mmsco, int _opt, bool _mcascade, const char* _analysis, IScriptEnvironment* env);
   ~TFM();
 
   int __stdcall SetCacheHints(int cachehints, int frame_range) override {
@@ -28,6 +28,7 @@
 #include "emmintrin.h"
 #include "smmintrin.h"
 #include "info.h"
+#include "hintprop.h"
 
 
 PVideoFrame __stdcall TFMPP::GetFrame(int n, IScriptEnvironment *env)
@@ -38,10 +39,18 @@ PVideoFrame __stdcall TFMPP::GetFrame(int n, IScriptEnvironment *env)
   int fieldSrc, field;
   unsigned int hint;
   PVideoFrame src = child->GetFrame(n, env);
-  bool res = getHint(vi, src, fieldSrc, combed, hint);
+  bool res = getHint(vi, src, fieldSrc, combed, hint, env);
   if (!combed)
   {
     if (usehints || !res) return src;
+    unsigned int prop_hint;
+    if (has_at_least_v8 && getPropHint(src, prop_hint, env))
+    {
+      // the pixels were never touched, dropping the property restores the frame
+      src = shareFrame(src, vi, env);
+      clearPropHint(src, env);
+      return src;
+    }
     env->MakeWritable(&src);
     destroyHint(vi, src, hint);
     return src;
@@ -53,10 +62,10 @@ PVideoFrame __stdcall TFMPP::GetFrame(int n, IScriptEnvironment *env)
     int use = 0;
     unsigned int hintt;
     PVideoFrame prv = child->GetFrame(n > 0 ? n - 1 : 0, env);
-    getHint(vi, prv, field, combed, hintt);
+    getHint(vi, prv, field, combed, hintt, env);
     if (!combed && field != -1 && n != 0) ++use;
     PVideoFrame nxt = child->GetFrame(n < nfrms ? n + 1 : nfrms, env);
-    getHint(vi, nxt, field, combed, hintt);
+    getHint(vi, nxt, field, combed, hintt, env);
     if (!combed && field != -1 && n != nfrms) use += 2;
     if (use > 0)
     {
@@ -142,6 +151,7 @@ PVideoFrame __stdcall TFMPP::GetFrame(int n, IScriptEnvironment *env)
     }
   }
   if (display) writeDisplay(dst, vi, n, fieldSrc);
+  if (has_at_least_v8) clearPropHint(dst, env); // the pixel hint below replaces it
   if (usehints) putHint(vi, dst, fieldSrc, hint);
   else destroyHint(vi, dst, hint);
   return dst;
@@ -486,6 +496,7 @@ void TFMPP::linkYUY2(PlanarFrame *mask)
 // TFMPP::denoisePlanar: PlanarFrame, 0xFF, TDeinterlace:PVideoFrame 0x3C
 void TFMPP::denoisePlanar(PlanarFrame *mask)
 {
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
   const int np = mask->NumComponents();
   for (int b = 0; b < np; ++b)
   {
@@ -497,7 +508,8 @@ void TFMPP::denoisePlanar(PlanarFrame *mask)
     const int Width = mask->GetWidth(b);
     for (int y = 1; y < Height - 1; ++y)
     {
-      for (int x = 1; x < Width - 1; ++x)
+      const int startx = use_sse2 ? denoisePlanarRow_SSE2(maskp, maskpp, maskpn, Width) : 1;
+      for (int x = startx; x < Width - 1; ++x)
       {
         if (maskp[x] == 0xFF)
         {
@@ -522,6 +534,7 @@ void TFMPP::denoisePlanar(PlanarFrame *mask)
 template<int planarType>
 void TFMPP::linkPlanar(PlanarFrame* mask)
 {
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
   uint8_t* maskpY = mask->GetPtr(0);
   uint8_t* maskpV = mask->GetPtr(2);
   uint8_t* maskpU = mask->GetPtr(1);
@@ -543,7 +556,8 @@ void TFMPP::linkPlanar(PlanarFrame* mask)
       maskpnnY += mask_pitchY * 2;
       maskpV += mask_pitchUV;
       maskpU += mask_pitchUV;
-      for (int x = 0; x < WidthUV; ++x)
+      const int startx = use_sse2 ? linkPlanarRow_SSE2<420>(maskpY, maskpnY, (y & 1) ? maskppY : maskpnnY, maskpU, maskpV, WidthUV) : 0;
+      for (int x = startx; x < WidthUV; ++x)
       {
         if ((((unsigned short*)maskpY)[x] == (unsigned short)0xFFFF) &&
           (((unsigned short*)maskpnY)[x] == (unsigned short)0xFFFF) &&
@@ -561,7 +575,8 @@ void TFMPP::linkPlanar(PlanarFrame* mask)
       maskpY += mask_pitchY;
       maskpV += mask_pitchUV;
       maskpU += mask_pitchUV;
-      for (int x = 0; x < WidthUV; ++x)
+      const int startx = use_sse2 ? linkPlanarRow_SSE2<planarType>(maskpY, nullptr, nullptr, maskpU, maskpV, WidthUV) : 0;
+      for (int x = startx; x < WidthUV; ++x)
       {
         if constexpr (planarType == 422) {
           if (((unsigned short*)maskpY)[x] == (unsigned short)0xFFFF) // horizontal subsampling
@@ -586,6 +601,72 @@ void TFMPP::linkPlanar(PlanarFrame* mask)
   }
 }
 
+// One row of denoisePlanar: a set pixel without any set neighbour is cleared.
+// In place is fine, a pixel that gets cleared has no set neighbour that could
+// depend on it. Returns the first x not processed.
+int denoisePlanarRow_SSE2(uint8_t* maskp, const uint8_t* maskpp, const uint8_t* maskpn, int width)
+{
+  const __m128i ff = _mm_set1_epi8(-1);
+  auto is_set = [&](const uint8_t* p) {
+    return _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), ff);
+  };
+  int x = 1;
+  for (; x + 17 <= width; x += 16)
+  {
+    __m128i neighbors = _mm_or_si128(_mm_or_si128(is_set(maskpp + x - 1), is_set(maskpp + x)),
+      _mm_or_si128(is_set(maskpp + x + 1), is_set(maskp + x - 1)));
+    neighbors = _mm_or_si128(neighbors, _mm_or_si128(_mm_or_si128(is_set(maskp + x + 1), is_set(maskpn + x - 1)),
+      _mm_or_si128(is_set(maskpn + x), is_set(maskpn + x + 1))));
+    const __m128i curr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskp + x));
+    const __m128i clear = _mm_andnot_si128(neighbors, _mm_cmpeq_epi8(curr, ff));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(maskp + x), _mm_andnot_si128(clear, curr));
+  }
+  return x;
+}
+
+// One chroma row of linkPlanar, 8 pixels at a time: U and V are set where all
+// luma mask pixels under them are 0xFF. For 420 maskpY3 is the extra luma row
+// (prev or nextnext), unused otherwise. Returns the first x not processed.
+template<int planarType>
+int linkPlanarRow_SSE2(const uint8_t* maskpY, const uint8_t* maskpnY, const uint8_t* maskpY3,
+  uint8_t* maskpU, uint8_t* maskpV, int widthUV)
+{
+  const __m128i ff = _mm_set1_epi8(-1);
+  int x = 0;
+  for (; x + 8 <= widthUV; x += 8)
+  {
+    __m128i link;
+    if constexpr (planarType == 420 || planarType == 422) {
+      __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskpY + x * 2));
+      if constexpr (planarType == 420) {
+        y = _mm_and_si128(y, _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskpnY + x * 2)));
+        y = _mm_and_si128(y, _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskpY3 + x * 2)));
+      }
+      const __m128i w = _mm_cmpeq_epi16(y, ff);
+      link = _mm_packs_epi16(w, w);
+    }
+    else if constexpr (planarType == 444) {
+      link = _mm_cmpeq_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskpY + x)), ff);
+    }
+    else if constexpr (planarType == 411) {
+      const __m128i d0 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(maskpY + x * 4)), ff);
+      const __m128i d1 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(maskpY + x * 4 + 16)), ff);
+      const __m128i w = _mm_packs_epi32(d0, d1);
+      link = _mm_packs_epi16(w, w);
+    }
+    const __m128i u = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskpU + x));
+    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskpV + x));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(maskpU + x), _mm_or_si128(u, link));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(maskpV + x), _mm_or_si128(v, link));
+  }
+  return x;
+}
+
+template int linkPlanarRow_SSE2<420>(const uint8_t* maskpY, const uint8_t* maskpnY, const uint8_t* maskpY3, uint8_t* maskpU, uint8_t* maskpV, int widthUV);
+template int linkPlanarRow_SSE2<422>(const uint8_t* maskpY, const uint8_t* maskpnY, const uint8_t* maskpY3, uint8_t* maskpU, uint8_t* maskpV, int widthUV);
+template int linkPlanarRow_SSE2<444>(const uint8_t* maskpY, const uint8_t* maskpnY, const uint8_t* maskpY3, uint8_t* maskpU, uint8_t* maskpV, int widthUV);
+template int linkPlanarRow_SSE2<411>(const uint8_t* maskpY, const uint8_t* maskpnY, const uint8_t* maskpY3, uint8_t* maskpU, uint8_t* maskpV, int widthUV);
+
 void TFMPP::BlendDeint(PVideoFrame& src, PlanarFrame* mask, PVideoFrame& dst, bool nomask,
   const VideoInfo& vi, IScriptEnvironment* env)
 {
@@ -634,9 +715,10 @@ void TFMPP::BlendDeint_core(PVideoFrame &src, PlanarFrame *mask, PVideoFrame &ds
     const int lines_to_process = height - 2;
     if (nomask)
     {
-      // fixme: hbd SIMD
       if (sizeof(pixel_t) == 1 && use_sse2)
         blendDeintMask_SSE2<false>((const uint8_t *)srcp, (uint8_t*)dstp, nullptr, src_pitch, dst_pitch, 0, width, lines_to_process);
+      else if (sizeof(pixel_t) == 2 && use_sse2)
+        blendDeintMask_uint16_SSE2<false>((const uint16_t*)srcp, (uint16_t*)dstp, nullptr, src_pitch, dst_pitch, 0, width, lines_to_process);
       else
         blendDeintMask_C<pixel_t, false>(srcp, dstp, nullptr, src_pitch, dst_pitch, 0, width, lines_to_process);
     }
@@ -645,6 +727,8 @@ void TFMPP::BlendDeint_core(PVideoFrame &src, PlanarFrame *mask, PVideoFrame &ds
       // with mask
       if (sizeof(pixel_t) == 1 && use_sse2)
         blendDeintMask_SSE2<true>((const uint8_t*)srcp, (uint8_t*)dstp, maskp, src_pitch, dst_pitch, msk_pitch, width, lines_to_process);
+      else if (sizeof(pixel_t) == 2 && use_sse2)
+        blendDeintMask_uint16_SSE2<true>((const uint16_t*)srcp, (uint16_t*)dstp, maskp, src_pitch, dst_pitch, msk_pitch, width, lines_to_process);
       else
         blendDeintMask_C<pixel_t, true>(srcp, dstp, maskp, src_pitch, dst_pitch, msk_pitch, width, lines_to_process);
     }
@@ -728,6 +812,60 @@ void blendDeintMask_C(const pixel_t* srcp, pixel_t* dstp,
   }
 }
 
+// 0xFFFF word lanes where the 8 mask bytes are 0xFF
+static AVS_FORCEINLINE __m128i mask_to_epi16(const uint8_t* maskp)
+{
+  const __m128i m = _mm_cmpeq_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskp)), _mm_set1_epi8(-1));
+  return _mm_unpacklo_epi8(m, m);
+}
+
+// unsigned 32 bit lanes (max 65535) to uint16 words without SSE4.1 packus_epi32
+static AVS_FORCEINLINE __m128i packus_epi32_SSE2(__m128i lo, __m128i hi)
+{
+  const __m128i bias32 = _mm_set1_epi32(32768);
+  const __m128i bias16 = _mm_set1_epi16(-32768);
+  return _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32)), bias16);
+}
+
+template<bool with_mask>
+void blendDeintMask_uint16_SSE2(const uint16_t* srcp, uint16_t* dstp,
+  const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
+  int width, int height)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i twos = _mm_set1_epi32(2);
+  while (height--) {
+    const uint16_t* srcpp = srcp - src_pitch;
+    const uint16_t* srcpn = srcp + src_pitch;
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+      const __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcpp + x));
+      const __m128i curr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcp + x));
+      const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcpn + x));
+      // (p + c*2 + n + 2) >> 2, does not fit in 16 bits
+      const __m128i sum_lo = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(prev, zero), _mm_unpacklo_epi16(next, zero)),
+        _mm_add_epi32(_mm_slli_epi32(_mm_unpacklo_epi16(curr, zero), 1), twos));
+      const __m128i sum_hi = _mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(prev, zero), _mm_unpackhi_epi16(next, zero)),
+        _mm_add_epi32(_mm_slli_epi32(_mm_unpackhi_epi16(curr, zero), 1), twos));
+      __m128i res = packus_epi32_SSE2(_mm_srli_epi32(sum_lo, 2), _mm_srli_epi32(sum_hi, 2));
+      if constexpr (with_mask)
+        res = _MM_BLENDV_EPI8(curr, res, mask_to_epi16(maskp + x)); // if mask then res else curr
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x), res);
+    }
+    for (; x < width; ++x)
+    {
+      if (!with_mask || maskp[x] == 0xFF)
+        dstp[x] = (srcpp[x] + (srcp[x] << 1) + srcpn[x] + 2) >> 2;
+      else
+        dstp[x] = srcp[x];
+    }
+    srcp += src_pitch;
+    dstp += dst_pitch;
+    if constexpr (with_mask)
+      maskp += msk_pitch;
+  }
+}
+
 void TFMPP::CubicDeint(PVideoFrame& src, PlanarFrame* mask, PVideoFrame& dst, bool nomask,
   int field, const VideoInfo& vi, IScriptEnvironment* env)
 {
@@ -802,6 +940,10 @@ void TFMPP::CubicDeint_core(PVideoFrame &src, PlanarFrame *mask, PVideoFrame &ds
         // false: no mask
         cubicDeintMask_SSE2<false>((const uint8_t *)srcp, (uint8_t*)dstp, nullptr, src_pitch, dst_pitch, 0, width, lines_to_process);
       }
+      else if (bits_per_pixel > 8 && use_sse2)
+      {
+        cubicDeintMask_uint16_SSE2<bits_per_pixel, false>((const uint16_t*)srcp, (uint16_t*)dstp, nullptr, src_pitch, dst_pitch, 0, width, lines_to_process);
+      }
       else
       {
         cubicDeintMask_C<pixel_t, bits_per_pixel, false>(srcp, dstp, nullptr, src_pitch, dst_pitch, 0, width, lines_to_process);
@@ -836,10 +978,13 @@ void TFMPP::CubicDeint_core(PVideoFrame &src, PlanarFrame *mask, PVideoFrame &ds
       const int lines_to_process = height / 2 - 3;
       if (bits_per_pixel == 8 && use_sse2)
       {
-        // fixme: hbd SIMD sse2 for 10+ bits
         // true: with_mask
         cubicDeintMask_SSE2<true>((const uint8_t*)srcp, (uint8_t*)dstp, maskp, src_pitch, dst_pitch, msk_pitch, width, lines_to_process);
       }
+      else if (bits_per_pixel > 8 && use_sse2)
+      {
+        cubicDeintMask_uint16_SSE2<bits_per_pixel, true>((const uint16_t*)srcp, (uint16_t*)dstp, maskp, src_pitch, dst_pitch, msk_pitch, width, lines_to_process);
+      }
       else
       {
         //for (int y = 4 - field; y < height - 3; y += 2)
@@ -967,6 +1112,102 @@ void cubicDeintMask_C(const pixel_t* srcp, pixel_t* dstp,
 }
 
 
+// cubicInt of 8 pixels, result in uint16 words
+template<typename pixel_t, int bits_per_pixel>
+static AVS_FORCEINLINE __m128i cubicInt8_SSE2(const pixel_t* srcppp, const pixel_t* srcpp,
+  const pixel_t* srcp, const pixel_t* srcpn)
+{
+  const __m128i zero = _mm_setzero_si128();
+  if constexpr (sizeof(pixel_t) == 1) {
+    auto load = [&](const pixel_t* p) {
+      return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+    };
+    const __m128i p_plus_c = _mm_add_epi16(load(srcpp), load(srcp));
+    const __m128i pp_plus_n = _mm_add_epi16(load(srcppp), load(srcpn));
+    // negative saturates to 0, same as the clamp
+    const __m128i sub = _mm_subs_epu16(_mm_mullo_epi16(p_plus_c, _mm_set1_epi16(19)), _mm_mullo_epi16(pp_plus_n, _mm_set1_epi16(3)));
+    const __m128i res = _mm_srli_epi16(_mm_add_epi16(sub, _mm_set1_epi16(16)), 5);
+    return _mm_min_epi16(res, _mm_set1_epi16(255));
+  }
+  else {
+    const __m128i pp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcppp));
+    const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcpp));
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcp));
+    const __m128i n = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcpn));
+    // 19 * a - 3 * b needs 32 bits, SSE2 has no mullo_epi32
+    auto cubic = [&](__m128i a, __m128i b) {
+      const __m128i a19 = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(a, 4), _mm_slli_epi32(a, 1)), a);
+      const __m128i b3 = _mm_add_epi32(_mm_slli_epi32(b, 1), b);
+      return _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(a19, b3), _mm_set1_epi32(16)), 5);
+    };
+    const __m128i res_lo = cubic(_mm_add_epi32(_mm_unpacklo_epi16(p, zero), _mm_unpacklo_epi16(c, zero)),
+      _mm_add_epi32(_mm_unpacklo_epi16(pp, zero), _mm_unpacklo_epi16(n, zero)));
+    const __m128i res_hi = cubic(_mm_add_epi32(_mm_unpackhi_epi16(p, zero), _mm_unpackhi_epi16(c, zero)),
+      _mm_add_epi32(_mm_unpackhi_epi16(pp, zero), _mm_unpackhi_epi16(n, zero)));
+    // biased signed pack saturates to 0..65535, then signed min on the biased values
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    const __m128i bias16 = _mm_set1_epi16(-32768);
+    __m128i res = _mm_packs_epi32(_mm_sub_epi32(res_lo, bias32), _mm_sub_epi32(res_hi, bias32));
+    if constexpr (bits_per_pixel < 16)
+      res = _mm_min_epi16(res, _mm_set1_epi16((short)(((1 << bits_per_pixel) - 1) - 32768)));
+    return _mm_add_epi16(res, bias16);
+  }
+}
+
+// One row of cubicInt, 8 pixels at a time. With maskp only the 0xFF
+// positions get the interpolation, the others are taken from keep.
+// Returns the first x not processed.
+template<typename pixel_t, int bits_per_pixel>
+static int cubicRow_SSE2(const pixel_t* srcppp, const pixel_t* srcpp, const pixel_t* srcp,
+  const pixel_t* srcpn, const pixel_t* keep, const uint8_t* maskp, pixel_t* dstp, int width)
+{
+  int x = 0;
+  for (; x + 8 <= width; x += 8)
+  {
+    __m128i res = cubicInt8_SSE2<pixel_t, bits_per_pixel>(srcppp + x, srcpp + x, srcp + x, srcpn + x);
+    if constexpr (sizeof(pixel_t) == 1) {
+      res = _mm_packus_epi16(res, res);
+      if (maskp) {
+        const __m128i m = _mm_cmpeq_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskp + x)), _mm_set1_epi8(-1));
+        res = _MM_BLENDV_EPI8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(keep + x)), res, m);
+      }
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dstp + x), res);
+    }
+    else {
+      if (maskp)
+        res = _MM_BLENDV_EPI8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keep + x)), res, mask_to_epi16(maskp + x));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x), res);
+    }
+  }
+  return x;
+}
+
+template<int bits_per_pixel, bool with_mask>
+void cubicDeintMask_uint16_SSE2(const uint16_t* srcp, uint16_t* dstp,
+  const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
+  int width, int height)
+{
+  while (height--) {
+    const uint16_t* srcppp = srcp - src_pitch * 2;
+    const uint16_t* srcpp = srcp - src_pitch;
+    const uint16_t* srcpn = srcp + src_pitch;
+    const uint16_t* srcr = srcp - (src_pitch >> 1); // came doubled
+    const int startx = cubicRow_SSE2<uint16_t, bits_per_pixel>(srcppp, srcpp, srcp, srcpn, srcr,
+      with_mask ? maskp : nullptr, dstp, width);
+    for (int x = startx; x < width; ++x)
+    {
+      if (!with_mask || maskp[x] == 0xFF)
+        dstp[x] = cubicInt<bits_per_pixel>(srcppp[x], srcpp[x], srcp[x], srcpn[x]);
+      else
+        dstp[x] = srcr[x];
+    }
+    srcp += src_pitch;
+    dstp += dst_pitch;
+    if constexpr (with_mask)
+      maskp += msk_pitch;
+  }
+}
+
 void TFMPP::destroyHint(const VideoInfo& vi, PVideoFrame& dst, unsigned int hint)
 {
   if (vi.ComponentSize() == 1)
@@ -1033,18 +1274,31 @@ void TFMPP::putHint_core(PVideoFrame &dst, int field, unsigned int hint)
   }
 }
 
-bool TFMPP::getHint(const VideoInfo& vi, PVideoFrame& src, int& field, bool& combed, unsigned int& hint)
+// frame property hint first (frames TFM passed through by reference), then pixels
+bool TFMPP::getHint(const VideoInfo& vi, PVideoFrame& src, int& field, bool& combed, unsigned int& hint, IScriptEnvironment *env)
 {
-  if (vi.ComponentSize() == 1)
-    return getHint_core<uint8_t>(src, field, combed, hint);
+  field = -1; combed = false; hint = 0;
+  bool res;
+  if (has_at_least_v8 && getPropHint(src, hint, env))
+    res = true;
+  else if (vi.ComponentSize() == 1)
+    res = getHint_core<uint8_t>(src, hint);
   else
-    return getHint_core<uint16_t>(src, field, combed, hint);
+    res = getHint_core<uint16_t>(src, hint);
+  if (!res) return false;
+  if (hint & 0xFFFF0000) return false;
+  if (hint&TOP_FIELD) field = 1;
+  else field = 0;
+  if (hint&COMBED) combed = true;
+  int value = hint & 0x07;
+  if (value == 5) { combed = true; field = 0; }
+  else if (value == 6) { combed = true; field = 1; }
+  return true;
 }
 
 template<typename pixel_t>
-bool TFMPP::getHint_core(PVideoFrame &src, int &field, bool &combed, unsigned int &hint)
+bool TFMPP::getHint_core(PVideoFrame &src, unsigned int &hint)
 {
-  field = -1; combed = false; hint = 0;
   const pixel_t *srcp = reinterpret_cast<const pixel_t *>(src->GetReadPtr(PLANAR_Y));
   unsigned int i, magic_number = 0;
   for (i = 0; i < 32; ++i)
@@ -1056,13 +1310,6 @@ bool TFMPP::getHint_core(PVideoFrame &src, int &field, bool &combed, unsigned in
   {
     hint |= ((*srcp++ & 1) << i);
   }
-  if (hint & 0xFFFF0000) return false;
-  if (hint&TOP_FIELD) field = 1;
-  else field = 0;
-  if (hint&COMBED) combed = true;
-  int value = hint & 0x07;
-  if (value == 5) { combed = true; field = 0; }
-  else if (value == 6) { combed = true; field = 1; }
   return true;
 }
 
@@ -1130,6 +1377,308 @@ void TFMPP::elaDeint(PVideoFrame& dst, PlanarFrame* mask, PVideoFrame& src, bool
     elaDeintYUY2(dst, mask, src, nomask, field);
 }
 
+// ELA interpolation of one luma pixel at least 4 pixels and 2 lines away from the edges
+template<typename pixel_t, int bits_per_pixel>
+static int elaInterpPlanar(const pixel_t* srcpppY, const pixel_t* srcppY, const pixel_t* srcpY,
+  const pixel_t* srcpnY, int x)
+{
+  constexpr int bitshift_to_8 = (bits_per_pixel - 8);
+
+  auto square = [](int i)
+  {
+    return i * i;
+  };
+
+  double dir1, dir2, dir, dirF;
+  int temp, temp1, temp2;
+
+  // stay in safe 32 bit int by using 8 bit normalized data
+  const int Iy1 = (-srcpY[x - 1] - srcpY[x] - srcpY[x] - srcpY[x + 1] + srcpppY[x - 1] + srcpppY[x] + srcpppY[x] + srcpppY[x + 1]) >> bitshift_to_8;
+  const int Iy2 = (-srcpnY[x - 1] - srcpnY[x] - srcpnY[x] - srcpnY[x + 1] + srcppY[x - 1] + srcppY[x] + srcppY[x] + srcppY[x + 1]) >> bitshift_to_8;
+  const int Ix1 = (srcpppY[x + 1] + srcppY[x + 1] + srcppY[x + 1] + srcpY[x + 1] - srcpppY[x - 1] - srcppY[x - 1] - srcppY[x - 1] - srcpY[x - 1]) >> bitshift_to_8;
+  const int Ix2 = (srcppY[x + 1] + srcpY[x + 1] + srcpY[x + 1] + srcpnY[x + 1] - srcppY[x - 1] - srcpY[x - 1] - srcpY[x - 1] - srcpnY[x - 1]) >> bitshift_to_8;
+  const int edgeS1 = Ix1 * Ix1 + Iy1 * Iy1;
+  const int edgeS2 = Ix2 * Ix2 + Iy2 * Iy2;
+  if (edgeS1 < 1600 && edgeS2 < 1600)
+  {
+    return (srcppY[x] + srcpY[x] + 1) >> 1;
+  }
+  constexpr int Const10 = 10 << bitshift_to_8;
+  if (abs(srcppY[x] - srcpY[x]) < Const10 && (edgeS1 < 1600 || edgeS2 < 1600))
+  {
+    return (srcppY[x] + srcpY[x] + 1) >> 1;
+  }
+  // stay in safe 32 bit int by using 8 bit normalized data
+  const int sum = (srcppY[x - 1] + srcppY[x] + srcppY[x + 1] + srcpY[x - 1] + srcpY[x] + srcpY[x + 1]) >> bitshift_to_8;
+  const int sumsq =
+    square(srcppY[x - 1] >> bitshift_to_8) +
+    square(srcppY[x] >> bitshift_to_8) +
+    square(srcppY[x + 1] >> bitshift_to_8) +
+    square(srcpY[x - 1] >> bitshift_to_8) +
+    square(srcpY[x] >> bitshift_to_8) +
+    square(srcpY[x + 1] >> bitshift_to_8);
+  if (6 * sumsq - square(sum) < 432)
+  {
+    return (srcppY[x] + srcpY[x] + 1) >> 1;
+  }
+  if (Ix1 == 0) dir1 = 3.1415926;
+  else
+  {
+    dir1 = atan(Iy1 / (Ix1*2.0f)) + 1.5707963;
+    if (Iy1 >= 0) { if (Ix1 < 0) dir1 += 3.1415927; }
+    else { if (Ix1 >= 0) dir1 += 3.1415927; }
+    if (dir1 >= 3.1415927) dir1 -= 3.1415927;
+  }
+  if (Ix2 == 0) dir2 = 3.1415926;
+  else
+  {
+    dir2 = atan(Iy2 / (Ix2*2.0f)) + 1.5707963;
+    if (Iy2 >= 0) { if (Ix2 < 0) dir2 += 3.1415927; }
+    else { if (Ix2 >= 0) dir2 += 3.1415927; }
+    if (dir2 >= 3.1415927) dir2 -= 3.1415927;
+  }
+  if (fabs(dir1 - dir2) < 0.5)
+  {
+    if (edgeS1 >= 3600 && edgeS2 >= 3600) dir = (dir1 + dir2) * 0.5;
+    else dir = edgeS1 >= edgeS2 ? dir1 : dir2;
+  }
+  else
+  {
+    if (edgeS1 >= 5000 && edgeS2 >= 5000)
+    {
+      // stay in safe 32 bit int by using 8 bit normalized data
+      const int Iye = (-srcpY[x - 1] - srcpY[x] - srcpY[x] - srcpY[x + 1] + srcppY[x - 1] + srcppY[x] + srcppY[x] + srcppY[x + 1]) >> bitshift_to_8;
+      if ((Iy1*Iye > 0) && (Iy2*Iye < 0)) dir = dir1;
+      else if ((Iy1*Iye < 0) && (Iy2*Iye > 0)) dir = dir2;
+      else
+      {
+        if (abs(Iye - Iy1) <= abs(Iye - Iy2)) dir = dir1;
+        else dir = dir2;
+      }
+    }
+    else dir = edgeS1 >= edgeS2 ? dir1 : dir2;
+  }
+  dirF = 0.5f / tan(dir);
+  if (dirF >= 0.0f)
+  {
+    if (dirF >= 0.5f)
+    {
+      if (dirF >= 1.0f)
+      {
+        if (dirF >= 1.5f)
+        {
+          if (dirF >= 2.0f)
+          {
+            if (dirF <= 2.50f)
+            {
+              temp1 = srcppY[x + 4];
+              temp2 = srcpY[x - 4];
+              temp = (srcppY[x + 4] + srcpY[x - 4] + 1) >> 1;
+            }
+            else
+            {
+              temp1 = temp2 = srcpY[x];
+              temp = cubicInt<bits_per_pixel>(srcpppY[x], srcppY[x], srcpY[x], srcpnY[x]);
+            }
+          }
+          else
+          {
+            temp1 = (int)((dirF - 1.5f)*(srcppY[x + 4]) + (2.0f - dirF)*(srcppY[x + 3]) + 0.5f);
+            temp2 = (int)((dirF - 1.5f)*(srcpY[x - 4]) + (2.0f - dirF)*(srcpY[x - 3]) + 0.5f);
+            temp = (int)((dirF - 1.5f)*(srcppY[x + 4] + srcpY[x - 4]) + (2.0f - dirF)*(srcppY[x + 3] + srcpY[x - 3]) + 0.5f);
+          }
+        }
+        else
+        {
+          temp1 = (int)((dirF - 1.0f)*(srcppY[x + 3]) + (1.5f - dirF)*(srcppY[x + 2]) + 0.5f);
+          temp2 = (int)((dirF - 1.0f)*(srcpY[x - 3]) + (1.5f - dirF)*(srcpY[x - 2]) + 0.5f);
+          temp = (int)((dirF - 1.0f)*(srcppY[x + 3] + srcpY[x - 3]) + (1.5f - dirF)*(srcppY[x + 2] + srcpY[x - 2]) + 0.5f);
+        }
+      }
+      else
+      {
+        temp1 = (int)((dirF - 0.5f)*(srcppY[x + 2]) + (1.0f - dirF)*(srcppY[x + 1]) + 0.5f);
+        temp2 = (int)((dirF - 0.5f)*(srcpY[x - 2]) + (1.0f - dirF)*(srcpY[x - 1]) + 0.5f);
+        temp = (int)((dirF - 0.5f)*(srcppY[x + 2] + srcpY[x - 2]) + (1.0f - dirF)*(srcppY[x + 1] + srcpY[x - 1]) + 0.5f);
+      }
+    }
+    else
+    {
+      temp1 = (int)(dirF*(srcppY[x + 1]) + (0.5f - dirF)*(srcppY[x]) + 0.5f);
+      temp2 = (int)(dirF*(srcpY[x - 1]) + (0.5f - dirF)*(srcpY[x]) + 0.5f);
+      temp = (int)(dirF*(srcppY[x + 1] + srcpY[x - 1]) + (0.5f - dirF)*(srcppY[x] + srcpY[x]) + 0.5f);
+    }
+  }
+  else
+  {
+    if (dirF <= -0.5f)
+    {
+      if (dirF <= -1.0f)
+      {
+        if (dirF <= -1.5f)
+        {
+          if (dirF <= -2.0f)
+          {
+            if (dirF >= -2.50f)
+            {
+              temp1 = srcppY[x - 4];
+              temp2 = srcpY[x + 4];
+              temp = (srcppY[x - 4] + srcpY[x + 4] + 1) >> 1;
+            }
+            else
+            {
+              temp1 = temp2 = srcpY[x];
+              temp = cubicInt<bits_per_pixel>(srcpppY[x], srcppY[x], srcpY[x], srcpnY[x]);
+            }
+          }
+          else
+          {
+            temp1 = (int)((-dirF - 1.5f)*(srcppY[x - 4]) + (2.0f + dirF)*(srcppY[x - 3]) + 0.5f);
+            temp2 = (int)((-dirF - 1.5f)*(srcpY[x + 4]) + (2.0f + dirF)*(srcpY[x + 3]) + 0.5f);
+            temp = (int)((-dirF - 1.5f)*(srcppY[x - 4] + srcpY[x + 4]) + (2.0f + dirF)*(srcppY[x - 3] + srcpY[x + 3]) + 0.5f);
+          }
+        }
+        else
+        {
+          temp1 = (int)((-dirF - 1.0f)*(srcppY[x - 3]) + (1.5f + dirF)*(srcppY[x - 2]) + 0.5f);
+          temp2 = (int)((-dirF - 1.0f)*(srcpY[x + 3]) + (1.5f + dirF)*(srcpY[x + 2]) + 0.5f);
+          temp = (int)((-dirF - 1.0f)*(srcppY[x - 3] + srcpY[x + 3]) + (1.5f + dirF)*(srcppY[x - 2] + srcpY[x + 2]) + 0.5f);
+        }
+      }
+      else
+      {
+        temp1 = (int)((-dirF - 0.5f)*(srcppY[x - 2]) + (1.0f + dirF)*(srcppY[x - 1]) + 0.5f);
+        temp2 = (int)((-dirF - 0.5f)*(srcpY[x + 2]) + (1.0f + dirF)*(srcpY[x + 1]) + 0.5f);
+        temp = (int)((-dirF - 0.5f)*(srcppY[x - 2] + srcpY[x + 2]) + (1.0f + dirF)*(srcppY[x - 1] + srcpY[x + 1]) + 0.5f);
+      }
+    }
+    else
+    {
+      temp1 = (int)((-dirF)*(srcppY[x - 1]) + (0.5f + dirF)*(srcppY[x]) + 0.5f);
+      temp2 = (int)((-dirF)*(srcpY[x + 1]) + (0.5f + dirF)*(srcpY[x]) + 0.5f);
+      temp = (int)((-dirF)*(srcppY[x - 1] + srcpY[x + 1]) + (0.5f + dirF)*(srcppY[x] + srcpY[x]) + 0.5f);
+    }
+  }
+
+  constexpr int Const20 = 20 << bitshift_to_8;
+  constexpr int Const25 = 25 << bitshift_to_8;
+  constexpr int Const60 = 60 << bitshift_to_8;
+
+  const int minN = std::min(srcppY[x], srcpY[x]) - Const25;
+  const int maxN = std::max(srcppY[x], srcpY[x]) + Const25;
+  if (abs(temp1 - temp2) > Const20 || abs(srcppY[x] + srcpY[x] - temp - temp) > Const60 || temp < minN || temp > maxN)
+  {
+    temp = cubicInt<bits_per_pixel>(srcpppY[x], srcppY[x], srcpY[x], srcpnY[x]);
+  }
+  else {
+    // clamp to valid. cubicint clamps O.K.
+    constexpr int max_pixel_value = (1 << bits_per_pixel) - 1;
+    if (temp > max_pixel_value) temp = max_pixel_value;
+    else if (temp < 0) temp = 0;
+  }
+  return temp;
+}
+
+template<typename pixel_t>
+static AVS_FORCEINLINE void ela_load8_epi32(const pixel_t* p, __m128i& lo, __m128i& hi)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i w;
+  if constexpr (sizeof(pixel_t) == 1)
+    w = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+  else
+    w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  lo = _mm_unpacklo_epi16(w, zero);
+  hi = _mm_unpackhi_epi16(w, zero);
+}
+
+// v*v for 0 <= v < 32768 (the upper word is zero)
+static AVS_FORCEINLINE __m128i ela_square_epi32(__m128i v)
+{
+  return _mm_madd_epi16(v, v);
+}
+
+static AVS_FORCEINLINE __m128i ela_abs_epi32(__m128i v)
+{
+  const __m128i sign = _mm_srai_epi32(v, 31);
+  return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+
+// The early outs of elaInterpPlanar for 4 pixels: weak edges, small vertical
+// difference next to a weak edge, or low variance. All lanes -1 where the
+// plain vertical average is the result.
+template<typename pixel_t, int bits_per_pixel>
+static AVS_FORCEINLINE __m128i ela_flat4_SSE2(const __m128i (&ppp)[3], const __m128i (&pp)[3],
+  const __m128i (&p)[3], const __m128i (&pn)[3])
+{
+  constexpr int bitshift_to_8 = (bits_per_pixel - 8);
+  constexpr int Const10 = 10 << bitshift_to_8;
+  // [0]: x-1, [1]: x, [2]: x+1
+  auto hsum = [](const __m128i (&r)[3]) { return _mm_add_epi32(_mm_add_epi32(r[0], r[2]), _mm_slli_epi32(r[1], 1)); };
+  auto hdiff = [](const __m128i (&r)[3]) { return _mm_sub_epi32(r[2], r[0]); };
+  const __m128i Iy1 = _mm_srai_epi32(_mm_sub_epi32(hsum(ppp), hsum(p)), bitshift_to_8);
+  const __m128i Iy2 = _mm_srai_epi32(_mm_sub_epi32(hsum(pp), hsum(pn)), bitshift_to_8);
+  const __m128i Ix1 = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(hdiff(ppp), hdiff(p)), _mm_slli_epi32(hdiff(pp), 1)), bitshift_to_8);
+  const __m128i Ix2 = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(hdiff(pp), hdiff(pn)), _mm_slli_epi32(hdiff(p), 1)), bitshift_to_8);
+  const __m128i edgeS1 = _mm_add_epi32(ela_square_epi32(ela_abs_epi32(Ix1)), ela_square_epi32(ela_abs_epi32(Iy1)));
+  const __m128i edgeS2 = _mm_add_epi32(ela_square_epi32(ela_abs_epi32(Ix2)), ela_square_epi32(ela_abs_epi32(Iy2)));
+  const __m128i weak1 = _mm_cmplt_epi32(edgeS1, _mm_set1_epi32(1600));
+  const __m128i weak2 = _mm_cmplt_epi32(edgeS2, _mm_set1_epi32(1600));
+  const __m128i smalldiff = _mm_cmplt_epi32(ela_abs_epi32(_mm_sub_epi32(pp[1], p[1])), _mm_set1_epi32(Const10));
+  __m128i flat = _mm_or_si128(_mm_and_si128(weak1, weak2), _mm_and_si128(smalldiff, _mm_or_si128(weak1, weak2)));
+
+  const __m128i sum = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(_mm_add_epi32(pp[0], pp[1]), _mm_add_epi32(pp[2], p[0])),
+    _mm_add_epi32(p[1], p[2])), bitshift_to_8);
+  __m128i sumsq = _mm_setzero_si128();
+  for (int i = 0; i < 3; ++i)
+  {
+    sumsq = _mm_add_epi32(sumsq, ela_square_epi32(_mm_srli_epi32(pp[i], bitshift_to_8)));
+    sumsq = _mm_add_epi32(sumsq, ela_square_epi32(_mm_srli_epi32(p[i], bitshift_to_8)));
+  }
+  const __m128i sumsq6 = _mm_add_epi32(_mm_slli_epi32(sumsq, 2), _mm_slli_epi32(sumsq, 1));
+  const __m128i variance = _mm_sub_epi32(sumsq6, ela_square_epi32(sum));
+  return _mm_or_si128(flat, _mm_cmplt_epi32(variance, _mm_set1_epi32(432)));
+}
+
+// ELA luma for the 8 pixels from the row pointers (x > 3, inside the
+// border). The flat ones are written here, the bits of the returned value
+// tell which masked pixels need the directional search of elaInterpPlanar.
+// maskp == nullptr: no mask
+template<typename pixel_t, int bits_per_pixel>
+static int elaFlatPixels_SSE2(const pixel_t* srcpppY, const pixel_t* srcppY, const pixel_t* srcpY,
+  const pixel_t* srcpnY, const uint8_t* maskp, pixel_t* dstpY)
+{
+  __m128i ppp_lo[3], ppp_hi[3], pp_lo[3], pp_hi[3], p_lo[3], p_hi[3], pn_lo[3], pn_hi[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    ela_load8_epi32(srcpppY + i - 1, ppp_lo[i], ppp_hi[i]);
+    ela_load8_epi32(srcppY + i - 1, pp_lo[i], pp_hi[i]);
+    ela_load8_epi32(srcpY + i - 1, p_lo[i], p_hi[i]);
+    ela_load8_epi32(srcpnY + i - 1, pn_lo[i], pn_hi[i]);
+  }
+  const __m128i flat_lo = ela_flat4_SSE2<pixel_t, bits_per_pixel>(ppp_lo, pp_lo, p_lo, pn_lo);
+  const __m128i flat_hi = ela_flat4_SSE2<pixel_t, bits_per_pixel>(ppp_hi, pp_hi, p_hi, pn_hi);
+  const __m128i flat_w = _mm_packs_epi32(flat_lo, flat_hi);
+  const __m128i flat_b = _mm_packs_epi16(flat_w, flat_w);
+  const __m128i masked_b = maskp ?
+    _mm_cmpeq_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskp)), _mm_set1_epi8(-1)) : _mm_set1_epi8(-1);
+
+  if constexpr (sizeof(pixel_t) == 1) {
+    const __m128i avg = _mm_avg_epu8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(srcppY)),
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(srcpY)));
+    const __m128i dst = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(dstpY));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dstpY), _MM_BLENDV_EPI8(dst, avg, _mm_and_si128(flat_b, masked_b)));
+  }
+  else {
+    const __m128i avg = _mm_avg_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(srcppY)),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcpY)));
+    const __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpY));
+    const __m128i masked_w = _mm_unpacklo_epi8(masked_b, masked_b);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dstpY), _MM_BLENDV_EPI8(dst, avg, _mm_and_si128(flat_w, masked_w)));
+  }
+  return _mm_movemask_epi8(_mm_andnot_si128(flat_b, masked_b)) & 0xFF;
+}
+
 // totally different from TDeinterlace ELADeintPlanar
 template<typename pixel_t, int bits_per_pixel>
 void TFMPP::elaDeintPlanar(PVideoFrame &dst, PlanarFrame *mask, PVideoFrame &src, bool nomask, int field, const VideoInfo &vi)
@@ -1186,217 +1735,30 @@ void TFMPP::elaDeintPlanar(PVideoFrame &dst, PlanarFrame *mask, PVideoFrame &src
   int startxuv = 0;
   int x, y;
   int stopxuv = WidthUV;
-  int Iy1, Iy2, Iye;
-  int Ix1, Ix2;
-  int edgeS1, edgeS2;
-  int sum, sumsq;
-  int temp, temp1, temp2;
-  int minN, maxN;
-  double dir1, dir2, dir, dirF;
-
-  constexpr int bitshift_to_8 = (bits_per_pixel - 8);
-
-  auto square = [](int i)
-  {
-    return i * i;
-  };
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
 
   for (y = 2 - field; y < HeightY - 1; y += 2)
   {
+    const bool ela_row = y > 2 && y < HeightY - 3;
     for (x = 0; x < stopx; ++x)
     {
+      if (use_sse2 && ela_row && x > 3 && x + 8 <= WidthY - 4)
+      {
+        const int dirpixels = elaFlatPixels_SSE2<pixel_t, bits_per_pixel>(srcpppY + x, srcppY + x, srcpY + x, srcpnY + x,
+          nomask ? nullptr : maskpY + x, dstpY + x);
+        for (int i = 0; i < 8; ++i)
+        {
+          if (dirpixels & (1 << i))
+            dstpY[x + i] = elaInterpPlanar<pixel_t, bits_per_pixel>(srcpppY, srcppY, srcpY, srcpnY, x + i);
+        }
+        x += 7;
+        continue;
+      }
       if (nomask || maskpY[x] == 0xFF)
       {
-        if (y > 2 && y < HeightY - 3 && x>3 && x < WidthY - 4)
+        if (ela_row && x>3 && x < WidthY - 4)
         {
-          // stay in safe 32 bit int by using 8 bit normalized data
-          Iy1 = (-srcpY[x - 1] - srcpY[x] - srcpY[x] - srcpY[x + 1] + srcpppY[x - 1] + srcpppY[x] + srcpppY[x] + srcpppY[x + 1]) >> bitshift_to_8;
-          Iy2 = (-srcpnY[x - 1] - srcpnY[x] - srcpnY[x] - srcpnY[x + 1] + srcppY[x - 1] + srcppY[x] + srcppY[x] + srcppY[x + 1]) >> bitshift_to_8;
-          Ix1 = (srcpppY[x + 1] + srcppY[x + 1] + srcppY[x + 1] + srcpY[x + 1] - srcpppY[x - 1] - srcppY[x - 1] - srcppY[x - 1] - srcpY[x - 1]) >> bitshift_to_8;
-          Ix2 = (srcppY[x + 1] + srcpY[x + 1] + srcpY[x + 1] + srcpnY[x + 1] - srcppY[x - 1] - srcpY[x - 1] - srcpY[x - 1] - srcpnY[x - 1]) >> bitshift_to_8;
-          edgeS1 = Ix1 * Ix1 + Iy1 * Iy1;
-          edgeS2 = Ix2 * Ix2 + Iy2 * Iy2;
-          if (edgeS1 < 1600 && edgeS2 < 1600)
-          {
-            dstpY[x] = (srcppY[x] + srcpY[x] + 1) >> 1;
-            continue;
-          }
-          constexpr int Const10 = 10 << bitshift_to_8;
-          if (abs(srcppY[x] - srcpY[x]) < Const10 && (edgeS1 < 1600 || edgeS2 < 1600))
-          {
-            dstpY[x] = (srcppY[x] + srcpY[x] + 1) >> 1;
-            continue;
-          }
-          // stay in safe 32 bit int by using 8 bit normalized data
-          sum = (srcppY[x - 1] + srcppY[x] + srcppY[x + 1] + srcpY[x - 1] + srcpY[x] + srcpY[x + 1]) >> bitshift_to_8;
-          sumsq =
-            square(srcppY[x - 1] >> bitshift_to_8) +
-            square(srcppY[x] >> bitshift_to_8) +
-            square(srcppY[x + 1] >> bitshift_to_8) +
-            square(srcpY[x - 1] >> bitshift_to_8) +
-            square(srcpY[x] >> bitshift_to_8) +
-            square(srcpY[x + 1] >> bitshift_to_8);
-          if (6 * sumsq - square(sum) < 432)
-          {
-            dstpY[x] = (srcppY[x] + srcpY[x] + 1) >> 1;
-            continue;
-          }
-          if (Ix1 == 0) dir1 = 3.1415926;
-          else
-          {
-            dir1 = atan(Iy1 / (Ix1*2.0f)) + 1.5707963;
-            if (Iy1 >= 0) { if (Ix1 < 0) dir1 += 3.1415927; }
-            else { if (Ix1 >= 0) dir1 += 3.1415927; }
-            if (dir1 >= 3.1415927) dir1 -= 3.1415927;
-          }
-          if (Ix2 == 0) dir2 = 3.1415926;
-          else
-          {
-            dir2 = atan(Iy2 / (Ix2*2.0f)) + 1.5707963;
-            if (Iy2 >= 0) { if (Ix2 < 0) dir2 += 3.1415927; }
-            else { if (Ix2 >= 0) dir2 += 3.1415927; }
-            if (dir2 >= 3.1415927) dir2 -= 3.1415927;
-          }
-          if (fabs(dir1 - dir2) < 0.5)
-          {
-            if (edgeS1 >= 3600 && edgeS2 >= 3600) dir = (dir1 + dir2) * 0.5;
-            else dir = edgeS1 >= edgeS2 ? dir1 : dir2;
-          }
-          else
-          {
-            if (edgeS1 >= 5000 && edgeS2 >= 5000)
-            {
-              // stay in safe 32 bit int by using 8 bit normalized data
-              Iye = (-srcpY[x - 1] - srcpY[x] - srcpY[x] - srcpY[x + 1] + srcppY[x - 1] + srcppY[x] + srcppY[x] + srcppY[x + 1]) >> bitshift_to_8;
-              if ((Iy1*Iye > 0) && (Iy2*Iye < 0)) dir = dir1;
-              else if ((Iy1*Iye < 0) && (Iy2*Iye > 0)) dir = dir2;
-              else
-              {
-                if (abs(Iye - Iy1) <= abs(Iye - Iy2)) dir = dir1;
-                else dir = dir2;
-              }
-            }
-            else dir = edgeS1 >= edgeS2 ? dir1 : dir2;
-          }
-          dirF = 0.5f / tan(dir);
-          if (dirF >= 0.0f)
-          {
-            if (dirF >= 0.5f)
-            {
-              if (dirF >= 1.0f)
-              {
-                if (dirF >= 1.5f)
-                {
-                  if (dirF >= 2.0f)
-                  {
-                    if (dirF <= 2.50f)
-                    {
-                      temp1 = srcppY[x + 4];
-                      temp2 = srcpY[x - 4];
-                      temp = (srcppY[x + 4] + srcpY[x - 4] + 1) >> 1;
-                    }
-                    else
-                    {
-                      temp1 = temp2 = srcpY[x];
-                      temp = cubicInt<bits_per_pixel>(srcpppY[x], srcppY[x], srcpY[x], srcpnY[x]);
-                    }
-                  }
-                  else
-                  {
-                    temp1 = (int)((dirF - 1.5f)*(srcppY[x + 4]) + (2.0f - dirF)*(srcppY[x + 3]) + 0.5f);
-                    temp2 = (int)((dirF - 1.5f)*(srcpY[x - 4]) + (2.0f - dirF)*(srcpY[x - 3]) + 0.5f);
-                    temp = (int)((dirF - 1.5f)*(srcppY[x + 4] + srcpY[x - 4]) + (2.0f - dirF)*(srcppY[x + 3] + srcpY[x - 3]) + 0.5f);
-                  }
-                }
-                else
-                {
-                  temp1 = (int)((dirF - 1.0f)*(srcppY[x + 3]) + (1.5f - dirF)*(srcppY[x + 2]) + 0.5f);
-                  temp2 = (int)((dirF - 1.0f)*(srcpY[x - 3]) + (1.5f - dirF)*(srcpY[x - 2]) + 0.5f);
-                  temp = (int)((dirF - 1.0f)*(srcppY[x + 3] + srcpY[x - 3]) + (1.5f - dirF)*(srcppY[x + 2] + srcpY[x - 2]) + 0.5f);
-                }
-              }
-              else
-              {
-                temp1 = (int)((dirF - 0.5f)*(srcppY[x + 2]) + (1.0f - dirF)*(srcppY[x + 1]) + 0.5f);
-                temp2 = (int)((dirF - 0.5f)*(srcpY[x - 2]) + (1.0f - dirF)*(srcpY[x - 1]) + 0.5f);
-                temp = (int)((dirF - 0.5f)*(srcppY[x + 2] + srcpY[x - 2]) + (1.0f - dirF)*(srcppY[x + 1] + srcpY[x - 1]) + 0.5f);
-              }
-            }
-            else
-            {
-              temp1 = (int)(dirF*(srcppY[x + 1]) + (0.5f - dirF)*(srcppY[x]) + 0.5f);
-              temp2 = (int)(dirF*(srcpY[x - 1]) + (0.5f - dirF)*(srcpY[x]) + 0.5f);
-              temp = (int)(dirF*(srcppY[x + 1] + srcpY[x - 1]) + (0.5f - dirF)*(srcppY[x] + srcpY[x]) + 0.5f);
-            }
-          }
-          else
-          {
-            if (dirF <= -0.5f)
-            {
-              if (dirF <= -1.0f)
-              {
-                if (dirF <= -1.5f)
-                {
-                  if (dirF <= -2.0f)
-                  {
-                    if (dirF >= -2.50f)
-                    {
-                      temp1 = srcppY[x - 4];
-                      temp2 = srcpY[x + 4];
-                      temp = (srcppY[x - 4] + srcpY[x + 4] + 1) >> 1;
-                    }
-                    else
-                    {
-                      temp1 = temp2 = srcpY[x];
-                      temp = cubicInt<bits_per_pixel>(srcpppY[x], srcppY[x], srcpY[x], srcpnY[x]);
-                    }
-                  }
-                  else
-                  {
-                    temp1 = (int)((-dirF - 1.5f)*(srcppY[x - 4]) + (2.0f + dirF)*(srcppY[x - 3]) + 0.5f);
-                    temp2 = (int)((-dirF - 1.5f)*(srcpY[x + 4]) + (2.0f + dirF)*(srcpY[x + 3]) + 0.5f);
-                    temp = (int)((-dirF - 1.5f)*(srcppY[x - 4] + srcpY[x + 4]) + (2.0f + dirF)*(srcppY[x - 3] + srcpY[x + 3]) + 0.5f);
-                  }
-                }
-                else
-                {
-                  temp1 = (int)((-dirF - 1.0f)*(srcppY[x - 3]) + (1.5f + dirF)*(srcppY[x - 2]) + 0.5f);
-                  temp2 = (int)((-dirF - 1.0f)*(srcpY[x + 3]) + (1.5f + dirF)*(srcpY[x + 2]) + 0.5f);
-                  temp = (int)((-dirF - 1.0f)*(srcppY[x - 3] + srcpY[x + 3]) + (1.5f + dirF)*(srcppY[x - 2] + srcpY[x + 2]) + 0.5f);
-                }
-              }
-              else
-              {
-                temp1 = (int)((-dirF - 0.5f)*(srcppY[x - 2]) + (1.0f + dirF)*(srcppY[x - 1]) + 0.5f);
-                temp2 = (int)((-dirF - 0.5f)*(srcpY[x + 2]) + (1.0f + dirF)*(srcpY[x + 1]) + 0.5f);
-                temp = (int)((-dirF - 0.5f)*(srcppY[x - 2] + srcpY[x + 2]) + (1.0f + dirF)*(srcppY[x - 1] + srcpY[x + 1]) + 0.5f);
-              }
-            }
-            else
-            {
-              temp1 = (int)((-dirF)*(srcppY[x - 1]) + (0.5f + dirF)*(srcppY[x]) + 0.5f);
-              temp2 = (int)((-dirF)*(srcpY[x + 1]) + (0.5f + dirF)*(srcpY[x]) + 0.5f);
-              temp = (int)((-dirF)*(srcppY[x - 1] + srcpY[x + 1]) + (0.5f + dirF)*(srcppY[x] + srcpY[x]) + 0.5f);
-            }
-          }
-
-          constexpr int Const20 = 20 << bitshift_to_8;
-          constexpr int Const25 = 25 << bitshift_to_8;
-          constexpr int Const60 = 60 << bitshift_to_8;
-
-          minN = std::min(srcppY[x], srcpY[x]) - Const25;
-          maxN = std::max(srcppY[x], srcpY[x]) + Const25;
-          if (abs(temp1 - temp2) > Const20 || abs(srcppY[x] + srcpY[x] - temp - temp) > Const60 || temp < minN || temp > maxN)
-          {
-            temp = cubicInt<bits_per_pixel>(srcpppY[x], srcppY[x], srcpY[x], srcpnY[x]);
-          }
-          else {
-            // clamp to valid. cubicint clamps O.K.
-            constexpr int max_pixel_value = (1 << bits_per_pixel) - 1;
-            if (temp > max_pixel_value) temp = max_pixel_value;
-            else if (temp < 0) temp = 0;
-          }
-          dstpY[x] = temp;
+          dstpY[x] = elaInterpPlanar<pixel_t, bits_per_pixel>(srcpppY, srcppY, srcpY, srcpnY, x);
         }
         else
         {
@@ -1414,7 +1776,14 @@ void TFMPP::elaDeintPlanar(PVideoFrame &dst, PlanarFrame *mask, PVideoFrame &src
   }
   for (y = 2 - field; y < HeightUV - 1; y += 2)
   {
-    for (x = startxuv; x < stopxuv; ++x)
+    int xuv = startxuv;
+    if (use_sse2 && y >= 3 && y <= HeightUV - 4)
+    {
+      // not masked: dst is kept
+      cubicRow_SSE2<pixel_t, bits_per_pixel>(srcpppV, srcppV, srcpV, srcpnV, dstpV, nomask ? nullptr : maskpV, dstpV, stopxuv);
+      xuv = cubicRow_SSE2<pixel_t, bits_per_pixel>(srcpppU, srcppU, srcpU, srcpnU, dstpU, nomask ? nullptr : maskpU, dstpU, stopxuv);
+    }
+    for (x = xuv; x < stopxuv; ++x)
     {
       if (nomask || maskpV[x] == 0xFF)
       {
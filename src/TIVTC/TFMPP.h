@@ -60,6 +60,11 @@ void blendDeintMask_C(const pixel_t* srcp, pixel_t* dstp,
   const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
   int width, int height);
 
+template<bool with_mask>
+void blendDeintMask_uint16_SSE2(const uint16_t* srcp, uint16_t* dstp,
+  const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
+  int width, int height);
+
 template<bool with_mask>
 void cubicDeintMask_SSE2(const uint8_t* srcp, uint8_t* dstp,
   const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
@@ -70,6 +75,17 @@ void cubicDeintMask_C(const pixel_t* srcp, pixel_t* dstp,
   const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
   int width, int height);
 
+template<int bits_per_pixel, bool with_mask>
+void cubicDeintMask_uint16_SSE2(const uint16_t* srcp, uint16_t* dstp,
+  const uint8_t* maskp, int src_pitch, int dst_pitch, int msk_pitch,
+  int width, int height);
+
+int denoisePlanarRow_SSE2(uint8_t* maskp, const uint8_t* maskpp, const uint8_t* maskpn, int width);
+
+template<int planarType>
+int linkPlanarRow_SSE2(const uint8_t* maskpY, const uint8_t* maskpnY, const uint8_t* maskpY3,
+  uint8_t* maskpU, uint8_t* maskpV, int widthUV);
+
 class TFMPP : public GenericVideoFilter
 {
 private:
@@ -104,9 +120,9 @@ private:
   void putHint(const VideoInfo& vi, PVideoFrame& dst, int field, unsigned int hint);
   template<typename pixel_t>
   void putHint_core(PVideoFrame &dst, int field, unsigned int hint);
-  bool getHint(const VideoInfo &vi, PVideoFrame& src, int& field, bool& combed, unsigned int& hint);
+  bool getHint(const VideoInfo &vi, PVideoFrame& src, int& field, bool& combed, unsigned int& hint, IScriptEnvironment *env);
   template<typename pixel_t>
-  bool getHint_core(PVideoFrame& src, int& field, bool& combed, unsigned int& hint);
+  bool getHint_core(PVideoFrame& src, unsigned int& hint);
 
   void getSetOvr(int n);
 
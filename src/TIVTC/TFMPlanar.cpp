@@ -51,12 +51,10 @@ template void FillCombedPlanarUpdateCmaskByUV<444>(PlanarFrame* cmask);
 //FIXME: once to make it common with TDeInterlace::CheckedCombedPlanar
 //similar, but cmask is real PVideoFrame there
 template<typename pixel_t>
-void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, PVideoFrame& src, PlanarFrame* cmask)
+void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, bool mcascade, PVideoFrame& src, PlanarFrame* cmask)
 {
   const int bits_per_pixel = vi.BitsPerComponent();
 
-  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
-  const bool use_sse4 = (cpuFlags & CPUF_SSE4_1) ? true : false;
   // cthresh: Area combing threshold used for combed frame detection.
   // This essentially controls how "strong" or "visible" combing must be to be detected.
   // Good values are from 6 to 12. If you know your source has a lot of combed frames set 
@@ -65,8 +63,6 @@ void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma
 
   const int scaled_cthresh = cthresh << (bits_per_pixel - 8);
 
-  const int cthresh6 = scaled_cthresh * 6;
-
   const int np = vi.IsYUY2() || vi.IsY() ? 1 : 3;
   const int stop = chroma ? np : 1;
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
@@ -81,138 +77,10 @@ void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma
     const int Width = src->GetRowSize(plane) / sizeof(pixel_t);
     const int Height = src->GetHeight(plane);
 
-    const pixel_t* srcpp = srcp - src_pitch;
-    const pixel_t* srcppp = srcpp - src_pitch;
-    const pixel_t* srcpn = srcp + src_pitch;
-    const pixel_t* srcpnn = srcpn + src_pitch;
-
     uint8_t* cmkp = cmask->GetPtr(b);
     const int cmk_pitch = cmask->GetPitch(b);
 
-    if (scaled_cthresh < 0) {
-      memset(cmkp, 255, Height * cmk_pitch); // mask. Always 8 bits 
-      continue;
-    }
-    memset(cmkp, 0, Height * cmk_pitch);
-
-    if (metric == 0)
-    {
-      // top 1 
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpn[x];
-        if (sFirst > scaled_cthresh || sFirst < -scaled_cthresh)
-        {
-          if (abs(srcpnn[x] + (srcp[x] << 2) + srcpnn[x] - (3 * (srcpn[x] + srcpn[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-      srcppp += src_pitch;
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      srcpnn += src_pitch;
-      cmkp += cmk_pitch;
-      // top #2
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpp[x];
-        const int sSecond = srcp[x] - srcpn[x];
-        if ((sFirst > scaled_cthresh && sSecond > scaled_cthresh) || (sFirst < -scaled_cthresh && sSecond < -scaled_cthresh))
-        {
-          if (abs(srcpnn[x] + (srcp[x] << 2) + srcpnn[x] - (3 * (srcpp[x] + srcpn[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-      srcppp += src_pitch;
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      srcpnn += src_pitch;
-      cmkp += cmk_pitch;
-      // middle Height - 4
-      const int lines_to_process = Height - 4;
-      if (use_sse2 && sizeof(pixel_t) == 1)
-        check_combing_SSE2((const uint8_t*)srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, scaled_cthresh);
-      else if (use_sse4 && sizeof(pixel_t) == 2)
-        check_combing_uint16_SSE4((const uint16_t*)srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, scaled_cthresh);
-      else
-        check_combing_c<pixel_t, false>(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, scaled_cthresh);
-      srcppp += src_pitch * lines_to_process;
-      srcpp += src_pitch * lines_to_process;
-      srcp += src_pitch * lines_to_process;
-      srcpn += src_pitch * lines_to_process;
-      srcpnn += src_pitch * lines_to_process;
-      cmkp += cmk_pitch * lines_to_process;
-      // bottom #-2
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpp[x];
-        const int sSecond = srcp[x] - srcpn[x];
-        if ((sFirst > scaled_cthresh && sSecond > scaled_cthresh) || (sFirst < -scaled_cthresh && sSecond < -scaled_cthresh))
-        {
-          if (abs(srcppp[x] + (srcp[x] << 2) + srcppp[x] - (3 * (srcpp[x] + srcpn[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-      srcppp += src_pitch;
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      srcpnn += src_pitch;
-      cmkp += cmk_pitch;
-      // bottom #-1
-      for (int x = 0; x < Width; ++x)
-      {
-        const int sFirst = srcp[x] - srcpp[x];
-        if (sFirst > scaled_cthresh || sFirst < -scaled_cthresh)
-        {
-          if (abs(srcppp[x] + (srcp[x] << 2) + srcppp[x] - (3 * (srcpp[x] + srcpp[x]))) > cthresh6)
-            cmkp[x] = 0xFF;
-        }
-      }
-    }
-    else
-    {
-      // metric == 1: squared
-      typedef typename std::conditional<sizeof(pixel_t) == 1, int, int64_t> ::type safeint_t;
-      const safeint_t cthreshsq = (safeint_t)scaled_cthresh * scaled_cthresh;
-      // top #1
-      for (int x = 0; x < Width; ++x)
-      {
-        if ((safeint_t)(srcp[x] - srcpn[x]) * (srcp[x] - srcpn[x]) > cthreshsq)
-          cmkp[x] = 0xFF;
-      }
-      srcpp += src_pitch;
-      srcp += src_pitch;
-      srcpn += src_pitch;
-      cmkp += cmk_pitch;
-      // middle Height - 2
-      const int lines_to_process = Height - 2;
-      if (use_sse2)
-      {
-        if constexpr (sizeof(pixel_t) == 1)
-          check_combing_SSE2_Metric1(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-        else
-          check_combing_c_Metric1<pixel_t, false, safeint_t>(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-        // fixme: write SIMD? later. int64 inside.
-        // check_combing_uint16_SSE2_Metric1(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-      }
-      else
-      {
-        check_combing_c_Metric1<pixel_t, false, safeint_t>(srcp, cmkp, Width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
-      }
-      srcpp += src_pitch * lines_to_process;
-      srcp += src_pitch * lines_to_process;
-      srcpn += src_pitch * lines_to_process;
-      cmkp += cmk_pitch * lines_to_process;
-      // Bottom
-      for (int x = 0; x < Width; ++x)
-      {
-        if ((safeint_t)(srcp[x] - srcpp[x]) * (srcp[x] - srcpp[x]) > cthreshsq)
-          cmkp[x] = 0xFF;
-      }
-    }
+    buildCombMask<pixel_t>(srcp, src_pitch, cmkp, cmk_pitch, Width, Height, 0, Height, scaled_cthresh, metric, mcascade, cpuFlags);
   }
 
   // next block is for mask, no hbd needed
@@ -228,8 +96,8 @@ void checkCombedPlanarAnalyze_core(const VideoInfo& vi, int cthresh, bool chroma
 }
 
 // instantiate
-template void checkCombedPlanarAnalyze_core<uint8_t>(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, PVideoFrame& src, PlanarFrame* cmask);
-template void checkCombedPlanarAnalyze_core<uint16_t>(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, PVideoFrame& src, PlanarFrame* cmask);
+template void checkCombedPlanarAnalyze_core<uint8_t>(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, bool mcascade, PVideoFrame& src, PlanarFrame* cmask);
+template void checkCombedPlanarAnalyze_core<uint16_t>(const VideoInfo& vi, int cthresh, bool chroma, int cpuFlags, int metric, bool mcascade, PVideoFrame& src, PlanarFrame* cmask);
 
 
 bool TFM::checkCombedPlanar(const VideoInfo& vi, PVideoFrame& src, int n, IScriptEnvironment* env, int match,
@@ -257,26 +125,26 @@ bool TFM::checkCombedPlanar(const VideoInfo& vi, PVideoFrame& src, int n, IScrip
   }
 
   const int bits_per_pixel = vi.BitsPerComponent();
+  // without chroma the luma mask can be built band by band as the yes/no scan proceeds
+  const bool streamMask = earlyExitMI && (!chroma || vi.IsY());
   if (vi.ComponentSize() == 1) {
-    checkCombedPlanarAnalyze_core<uint8_t>(vi, cthresh, chroma, cpuFlags, metric, src, cmask);
-    return checkCombedPlanar_core<uint8_t>(src, n, env, match, blockN, xblocksi, mics, ddebug, bits_per_pixel);
+    if (!streamMask)
+      checkCombedPlanarAnalyze_core<uint8_t>(vi, cthresh, chroma, cpuFlags, metric, mcascade, src, cmask);
+    return checkCombedPlanar_core<uint8_t>(src, n, env, match, blockN, xblocksi, mics, ddebug, bits_per_pixel, streamMask, cthresh);
   }
   else {
-    checkCombedPlanarAnalyze_core<uint16_t>(vi, cthresh, chroma, cpuFlags, metric, src, cmask);
-    return checkCombedPlanar_core<uint16_t>(src, n, env, match, blockN, xblocksi, mics, ddebug, bits_per_pixel);
+    if (!streamMask)
+      checkCombedPlanarAnalyze_core<uint16_t>(vi, cthresh, chroma, cpuFlags, metric, mcascade, src, cmask);
+    return checkCombedPlanar_core<uint16_t>(src, n, env, match, blockN, xblocksi, mics, ddebug, bits_per_pixel, streamMask, cthresh);
   }
 }
 
 template<typename pixel_t>
 bool TFM::checkCombedPlanar_core(PVideoFrame &src, int n, IScriptEnvironment *env, int match,
-  int *blockN, int &xblocksi, int *mics, bool ddebug, int bits_per_pixel)
+  int *blockN, int &xblocksi, int *mics, bool ddebug, int bits_per_pixel, bool streamMask, int cthresh)
 {
-  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
-
   const int cmk_pitch = cmask->GetPitch(0);
-  const uint8_t *cmkp = cmask->GetPtr(0) + cmk_pitch;
-  const uint8_t *cmkpp = cmkp - cmk_pitch;
-  const uint8_t *cmkpn = cmkp + cmk_pitch;
+  uint8_t *cmkp = cmask->GetPtr(0);
   const int Width = cmask->GetWidth(0);
   const int Height = cmask->GetHeight(0);
   const int xblocks = ((Width + xhalf) >> xshift) + 1;
@@ -286,130 +154,17 @@ bool TFM::checkCombedPlanar_core(PVideoFrame &src, int n, IScriptEnvironment *en
   const int arraysize = (xblocks*yblocks) << 2;
   memset(cArray, 0, arraysize * sizeof(int));
 
-  int Heighta = (Height >> (yshift - 1)) << (yshift - 1);
-  if (Heighta == Height) Heighta = Height - yhalf;
-  const int Widtha = (Width >> (xshift - 1)) << (xshift - 1);
-  const bool use_sse2_sum = (use_sse2 && xhalf == 8 && yhalf == 8) ? true : false; // 8x8: no alignment
-  for (int y = 1; y < yhalf; ++y)
-  {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    for (int x = 0; x < Width; ++x)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-  }
-  for (int y = yhalf; y < Heighta; y += yhalf)
-  {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    if (use_sse2_sum)
-    {
-      for (int x = 0; x < Widtha; x += xhalf)
-      {
-        int sum = 0;
-        compute_sum_8xN_sse2<8>(cmkpp + x, cmk_pitch, sum);
-        if (sum)
-        {
-          const int box1 = (x >> xshift) << 2;
-          const int box2 = ((x + xhalf) >> xshift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    else
-    {
-      for (int x = 0; x < Widtha; x += xhalf)
-      {
-        const uint8_t *cmkppT = cmkpp;
-        const uint8_t *cmkpT = cmkp;
-        const uint8_t *cmkpnT = cmkpn;
-        int sum = 0;
-        for (int u = 0; u < yhalf; ++u)
-        {
-          for (int v = 0; v < xhalf; ++v)
-          {
-            if (cmkppT[x + v] == 0xFF && cmkpT[x + v] == 0xFF &&
-              cmkpnT[x + v] == 0xFF) ++sum;
-          }
-          cmkppT += cmk_pitch;
-          cmkpT += cmk_pitch;
-          cmkpnT += cmk_pitch;
-        }
-        if (sum)
-        {
-          const int box1 = (x >> xshift) << 2;
-          const int box2 = ((x + xhalf) >> xshift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    // rest
-    for (int x = Widtha; x < Width; ++x)
-    {
-      const uint8_t *cmkppT = cmkpp;
-      const uint8_t *cmkpT = cmkp;
-      const uint8_t *cmkpnT = cmkpn;
-      int sum = 0;
-      for (int u = 0; u < yhalf; ++u)
-      {
-        if (cmkppT[x] == 0xFF && cmkpT[x] == 0xFF &&
-          cmkpnT[x] == 0xFF) ++sum;
-        cmkppT += cmk_pitch;
-        cmkpT += cmk_pitch;
-        cmkpnT += cmk_pitch;
-      }
-      if (sum)
-      {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        cArray[temp1 + box1 + 0] += sum;
-        cArray[temp1 + box2 + 1] += sum;
-        cArray[temp2 + box1 + 2] += sum;
-        cArray[temp2 + box2 + 3] += sum;
-      }
-    }
-    cmkpp += cmk_pitch*yhalf;
-    cmkp += cmk_pitch*yhalf;
-    cmkpn += cmk_pitch*yhalf;
-  }
-  for (int y = Heighta; y < Height - 1; ++y)
+  if (earlyExitMI)
   {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    for (int x = 0; x < Width; ++x)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
+    // only mics[match] > MI matters, the count of a combed frame is a lower bound
+    const pixel_t *srcp = reinterpret_cast<const pixel_t *>(src->GetReadPtr(PLANAR_Y));
+    const int src_pitch = src->GetPitch(PLANAR_Y) / sizeof(pixel_t);
+    checkCombedBlocksMI<pixel_t>(srcp, src_pitch, cmkp, cmk_pitch, Width, Height, cthresh << (bits_per_pixel - 8),
+      metric, mcascade, streamMask, xhalf, xshift, yhalf, yshift, cArray, MI, false, cpuFlags);
   }
+  else
+    accumulateCombedBlocks(cmkp, cmk_pitch, Width, Height, xhalf, xshift, yhalf, yshift, cArray, false, cpuFlags);
+
   for (int x = 0; x < arraysize; ++x)
   {
     if (cArray[x] > mics[match])
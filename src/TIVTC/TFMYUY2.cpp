@@ -201,7 +201,14 @@ bool TFM::checkCombedYUY2(PVideoFrame &src, int n, IScriptEnvironment *env, int
       // height-2: no top, no bottom
       // no "inc" here (chroma: inc=1 lumaonly: inc=2)
       // SSE2 is separated instead
-      if (chroma)
+      if (mcascade)
+      {
+        if (chroma)
+          check_combing_SSE2_Metric1_Cascade(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthresh);
+        else
+          check_combing_SSE2_Luma_Metric1_Cascade(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthresh);
+      }
+      else if (chroma)
         check_combing_SSE2_Metric1(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthreshsq);
       else
         check_combing_SSE2_Luma_Metric1(srcp, cmkw, Width, Height - 2, src_pitch, cmk_pitch, cthreshsq);
@@ -259,135 +266,17 @@ cjump:
       cmkpn += cmk_pitch;
     }
   }
-  const uint8_t *cmkp = cmask->GetPtr() + cmk_pitch;
-  const uint8_t *cmkpp = cmkp - cmk_pitch;
-  const uint8_t *cmkpn = cmkp + cmk_pitch;
+  // only the luma bytes of the mask are counted, combed chroma has been moved to them above
   memset(cArray, 0, arraysize * sizeof(int));
-  int Heighta = (Height >> (yshift - 1)) << (yshift - 1);
-  if (Heighta == Height) Heighta = Height - yhalf;
-  const int Widtha = (Width >> (xshift - 1)) << (xshift - 1); // whole blocks
-  const bool use_sse2_sum = (use_sse2 && xhalf == 16 && yhalf == 8) ? true : false;
-  for (int y = 1; y < yhalf; ++y)
-  {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    for (int x = 0; x < Width; x += 2)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
-  }
-  for (int y = yhalf; y < Heighta; y += yhalf)
-  {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    if (use_sse2_sum)
-    {
-      // aligned
-      for (int x = 0; x < Widtha; x += xhalf)
-      {
-        int sum = 0;
-        compute_sum_16x8_sse2_luma(cmkpp + x, cmk_pitch, sum);
-        if (sum)
-        {
-          const int box1 = (x >> xshift) << 2;
-          const int box2 = ((x + xhalf) >> xshift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    else
-    {
-      for (int x = 0; x < Widtha; x += xhalf)
-      {
-        const uint8_t *cmkppT = cmkpp;
-        const uint8_t *cmkpT = cmkp;
-        const uint8_t *cmkpnT = cmkpn;
-        int sum = 0;
-        for (int u = 0; u < yhalf; ++u)
-        {
-          for (int v = 0; v < xhalf; v += 2)
-          {
-            if (cmkppT[x + v] == 0xFF && cmkpT[x + v] == 0xFF &&
-              cmkpnT[x + v] == 0xFF) ++sum;
-          }
-          cmkppT += cmk_pitch;
-          cmkpT += cmk_pitch;
-          cmkpnT += cmk_pitch;
-        }
-        if (sum)
-        {
-          const int box1 = (x >> xshift) << 2;
-          const int box2 = ((x + xhalf) >> xshift) << 2;
-          cArray[temp1 + box1 + 0] += sum;
-          cArray[temp1 + box2 + 1] += sum;
-          cArray[temp2 + box1 + 2] += sum;
-          cArray[temp2 + box2 + 3] += sum;
-        }
-      }
-    }
-    // rest, after the aligned (whole-block) part
-    for (int x = Widtha; x < Width; x += 2)
-    {
-      const uint8_t *cmkppT = cmkpp;
-      const uint8_t *cmkpT = cmkp;
-      const uint8_t *cmkpnT = cmkpn;
-      int sum = 0;
-      for (int u = 0; u < yhalf; ++u)
-      {
-        if (cmkppT[x] == 0xFF && cmkpT[x] == 0xFF &&
-          cmkpnT[x] == 0xFF) ++sum;
-        cmkppT += cmk_pitch;
-        cmkpT += cmk_pitch;
-        cmkpnT += cmk_pitch;
-      }
-      if (sum)
-      {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        cArray[temp1 + box1 + 0] += sum;
-        cArray[temp1 + box2 + 1] += sum;
-        cArray[temp2 + box1 + 2] += sum;
-        cArray[temp2 + box2 + 3] += sum;
-      }
-    }
-    cmkpp += cmk_pitch*yhalf;
-    cmkp += cmk_pitch*yhalf;
-    cmkpn += cmk_pitch*yhalf;
-  }
-  for (int y = Heighta; y < Height - 1; ++y)
+  if (earlyExitMI)
   {
-    const int temp1 = (y >> yshift)*xblocks4;
-    const int temp2 = ((y + yhalf) >> yshift)*xblocks4;
-    for (int x = 0; x < Width; x += 2)
-    {
-      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
-      {
-        const int box1 = (x >> xshift) << 2;
-        const int box2 = ((x + xhalf) >> xshift) << 2;
-        ++cArray[temp1 + box1 + 0];
-        ++cArray[temp1 + box2 + 1];
-        ++cArray[temp2 + box1 + 2];
-        ++cArray[temp2 + box2 + 3];
-      }
-    }
-    cmkpp += cmk_pitch;
-    cmkp += cmk_pitch;
-    cmkpn += cmk_pitch;
+    // only mics[match] > MI matters, the count of a combed frame is a lower bound
+    checkCombedBlocksMI<uint8_t>(nullptr, 0, cmask->GetPtr(), cmk_pitch, Width, Height, cthresh,
+      metric, mcascade, false, xhalf, xshift, yhalf, yshift, cArray, MI, true, cpuFlags);
   }
+  else
+    accumulateCombedBlocks(cmask->GetPtr(), cmk_pitch, Width, Height, xhalf, xshift, yhalf, yshift, cArray, true, cpuFlags);
+
   for (int x = 0; x < arraysize; ++x)
   {
     if (cArray[x] > mics[match])
@@ -420,6 +309,6 @@ void TFM::buildDiffMapPlaneYUY2(const uint8_t *prvp, const uint8_t *nxtp,
   int Width, int tpitch, IScriptEnvironment *env)
 {
   buildABSDiffMask<uint8_t>(prvp - prv_pitch, nxtp - nxt_pitch, prv_pitch, nxt_pitch, tpitch, Width, Height >> 1, env);
-  AnalyzeDiffMask_YUY2(dstp, dst_pitch, tbuffer, tpitch, Width, Height, mChroma);
+  AnalyzeDiffMask_YUY2(dstp, dst_pitch, tbuffer, tpitch, Width, Height, mChroma, cpuFlags);
 }
 
@@ -23,6 +23,7 @@
 #include "emmintrin.h"
 #include "smmintrin.h" // SSE4
 #include <algorithm>
+#include <cstring>
 
 void absDiff_SSE2(const uint8_t *srcp1, const uint8_t *srcp2,
   uint8_t *dstp, int src1_pitch, int src2_pitch, int dst_pitch, int width,
@@ -264,7 +265,7 @@ void do_buildABSDiffMask2(const uint8_t* prvp, const uint8_t* nxtp, uint8_t* dst
   if ((cpuFlags & CPUF_SSE2) && width >= 8) // yes, width and not row_size
   {
     int mod8Width = width / 8 * 8;
-    if constexpr(sizeof(pixel_t) == 8)
+    if constexpr(sizeof(pixel_t) == 1)
       buildABSDiffMask2_uint8_SSE2(prvp, nxtp, dstp, prv_pitch, nxt_pitch, dst_pitch, mod8Width, height);
     else
       buildABSDiffMask2_uint16_SSE2(prvp, nxtp, dstp, prv_pitch, nxt_pitch, dst_pitch, mod8Width, height, bits_per_pixel);
@@ -454,7 +455,7 @@ template void AnalyzeDiffMask_Planar<uint16_t, 14>(uint8_t* dstp, int dst_pitch,
 template void AnalyzeDiffMask_Planar<uint16_t, 16>(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer8, int tpitch, int Width, int Height);
 
 // TDeint and TFM version
-void AnalyzeDiffMask_YUY2(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer, int tpitch, int Width, int Height, bool mChroma)
+void AnalyzeDiffMask_YUY2(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer, int tpitch, int Width, int Height, bool mChroma, int cpuFlags)
 {
   // YUY2 we won't touch it if it works. No hbd here
   const uint8_t* dppp = tbuffer - tpitch;
@@ -464,41 +465,42 @@ void AnalyzeDiffMask_YUY2(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer, int tp
   const uint8_t* dpnn = tbuffer + tpitch * 3;
   // reconstructed from inline 700+ lines asm by pinterf
 
-  if (mChroma) // TFM YUY2's mChroma bool parameter
-  {
-    for (int y = 2; y < Height - 2; y += 2) {
-      // small difference from planar: x starts from 2 instead of 1; ends at width-2 instead of width-1
-      // [YUYV]YUYVYUYVYUYV...YUYV[YUYV]
-      for (int x = 4; x < Width - 4; x += 1)
-      {
-        AnalyzeOnePixel<uint8_t, 8, 2>(dstp, dppp, dpp, dp, dpn, dpnn, x, y, Width, Height);
-        // skip to chroma
-        x++;
-        AnalyzeOnePixel<uint8_t, 8, 4>(dstp, dppp, dpp, dp, dpn, dpnn, x, y, Width, Height);
+  // Most of a diff map is quiet: a pixel with dp <= 3 is left untouched by AnalyzeOnePixel,
+  // so with SSE2 whole 16 byte runs of such pixels are skipped without visiting them.
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) != 0;
+  // chroma bytes of a luma-only map are not filled, they don't count
+  const int ignored_lanes = mChroma ? 0 : 0xAAAA;
+  const auto Const3 = _mm_set1_epi8(3);
+  const auto zero = _mm_setzero_si128();
+  const int inc = mChroma ? 1 : 2;
 
+  for (int y = 2; y < Height - 2; y += 2) {
+    // small difference from planar: x starts from 2 instead of 1; ends at width-2 instead of width-1
+    // [YUYV]YUYVYUYVYUYV...YUYV[YUYV]
+    for (int xstart = 4; xstart < Width - 4; xstart += 16)
+    {
+      const int xend = std::min(xstart + 16, Width - 4);
+      if (use_sse2 && xend == xstart + 16) {
+        auto src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dp + xstart));
+        auto quiet = _mm_cmpeq_epi8(_mm_subs_epu8(src, Const3), zero);
+        if ((_mm_movemask_epi8(quiet) | ignored_lanes) == 0xFFFF)
+          continue;
       }
-      dppp += tpitch;
-      dpp += tpitch;
-      dp += tpitch;
-      dpn += tpitch;
-      dpnn += tpitch;
-      dstp += dst_pitch;
-    }
-  }
-  else {
-    // no YUY2 chroma, LumaOnly
-    for (int y = 2; y < Height - 2; y += 2) {
-      for (int x = 4; x < Width - 4; x += 2)
+      // xstart is even: luma and chroma (mChroma, TFM YUY2's bool parameter) alternate
+      for (int x = xstart; x < xend; x += inc)
       {
-        AnalyzeOnePixel<uint8_t, 8, 2>(dstp, dppp, dpp, dp, dpn, dpnn, x, y, Width, Height);
+        if (x & 1)
+          AnalyzeOnePixel<uint8_t, 8, 4>(dstp, dppp, dpp, dp, dpn, dpnn, x, y, Width, Height);
+        else
+          AnalyzeOnePixel<uint8_t, 8, 2>(dstp, dppp, dpp, dp, dpn, dpnn, x, y, Width, Height);
       }
-      dppp += tpitch;
-      dpp += tpitch;
-      dp += tpitch;
-      dpn += tpitch;
-      dpnn += tpitch;
-      dstp += dst_pitch;
     }
+    dppp += tpitch;
+    dpp += tpitch;
+    dp += tpitch;
+    dpn += tpitch;
+    dpnn += tpitch;
+    dstp += dst_pitch;
   }
 }
 
@@ -685,9 +687,9 @@ void buildABSDiffMask2_uint16_SSE2(const uint8_t* prvp, const uint8_t* nxtp,
         auto cmp19_hi = _MM_CMPLE_EPU16(Compare19plus1, diff_hi); // FFFF where 20 <= diff (19 < diff)
         auto cmp3_hi = _MM_CMPLE_EPU16(Compare3plus1, diff_hi); // FFFF where 4 <= diff (3 < diff)
 
-        // make bytes from wordBools
-        auto cmp251 = _mm_packus_epi16(cmp3_lo, cmp3_hi);
-        auto cmp235 = _mm_packus_epi16(cmp19_lo, cmp19_hi);
+        // make bytes from wordBools, signed saturation keeps 0xFFFF (-1) as 0xFF
+        auto cmp251 = _mm_packs_epi16(cmp3_lo, cmp3_hi);
+        auto cmp235 = _mm_packs_epi16(cmp19_lo, cmp19_hi);
 
         // target is byte buffer!
         auto tmp1 = _mm_and_si128(cmp251, onesMask);
@@ -725,8 +727,8 @@ void buildABSDiffMask2_uint16_SSE2(const uint8_t* prvp, const uint8_t* nxtp,
         auto cmp3_hi = _MM_CMPLE_EPU16(Compare3plus1, diff_hi); // FFFF where 4 <= diff (3 < diff)
 
         // make bytes from wordBools
-        auto cmp251 = _mm_packus_epi16(cmp3_lo, cmp3_hi);
-        auto cmp235 = _mm_packus_epi16(cmp19_lo, cmp19_hi);
+        auto cmp251 = _mm_packs_epi16(cmp3_lo, cmp3_hi);
+        auto cmp235 = _mm_packs_epi16(cmp19_lo, cmp19_hi);
 
         // target is byte buffer!
         auto tmp1 = _mm_and_si128(cmp251, onesMask);
@@ -745,8 +747,8 @@ void buildABSDiffMask2_uint16_SSE2(const uint8_t* prvp, const uint8_t* nxtp,
       auto cmp3_lo = _MM_CMPLE_EPU16(Compare3plus1, diff_lo); // FFFF where 4 <= diff (3 < diff)
 
       // make bytes from wordBools
-      auto cmp251 = _mm_packus_epi16(cmp3_lo, cmp3_lo); // 8 bytes valid only
-      auto cmp235 = _mm_packus_epi16(cmp19_lo, cmp19_lo);
+      auto cmp251 = _mm_packs_epi16(cmp3_lo, cmp3_lo); // 8 bytes valid only
+      auto cmp235 = _mm_packs_epi16(cmp19_lo, cmp19_lo);
 
       // target is byte buffer!
       auto tmp1 = _mm_and_si128(cmp251, onesMask);
@@ -1147,106 +1149,452 @@ void check_combing_SSE2_Luma_Metric1(const uint8_t *srcp, uint8_t *dstp,
   }
 }
 
-template<int blockSizeY>
-void compute_sum_8xN_sse2(const uint8_t *srcp, int pitch, int &sum)
+// Exact metric 1 mask of 16 pixels: (prev - curr) * (next - curr) > cthreshsq
+static AVS_FORCEINLINE __m128i metric1_mask_16px(__m128i prev, __m128i curr, __m128i next, __m128i thresh)
 {
-  // sums masks
-  // if (cmkppT[x + v] == 0xFF && cmkpT[x + v] == 0xFF && cmkpnT[x + v] == 0xFF) sum++;
-  // scrp is prev
-  auto onesMask = _mm_set1_epi8(1);
-  auto all_ff = _mm_set1_epi8(-1);
-  auto prev = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(srcp));
-  auto curr = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(srcp + pitch));
-  auto summa = _mm_setzero_si128();
-  srcp += pitch * 2; // points to next
-  // unroll 2
-  for (int i = 0; i < blockSizeY / 2; i++) { // 4x2=8
-    /*
-    p  #
-    c  # #
-    n  # #
-    nn   #
-    */
-    auto next = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(srcp));
-    auto nextnext = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(srcp + pitch));
-
-    auto anded_common = _mm_and_si128(curr, next);
-    auto with_prev = _mm_and_si128(prev, anded_common);
-    auto with_nextnext = _mm_and_si128(anded_common, nextnext);
-
-    // these were missing from the original assembler code (== 0xFF)
-    with_prev = _mm_cmpeq_epi8(with_prev, all_ff);
-    with_nextnext = _mm_cmpeq_epi8(with_nextnext, all_ff);
-
-    with_prev = _mm_and_si128(with_prev, onesMask);
-    with_nextnext = _mm_and_si128(with_nextnext, onesMask);
-
-    prev = next;
-    curr = nextnext;
-
-    summa = _mm_adds_epu8(summa, with_prev);
-    summa = _mm_adds_epu8(summa, with_nextnext);
-    srcp += pitch * 2;
-  }
-  // now we have to sum up lower 8 bytes
-  // in sse2, we use sad
   auto zero = _mm_setzero_si128();
-  auto tmpsum = _mm_sad_epu8(summa, zero);  // sum(lo 8 bytes)(needed) / sum(hi 8 bytes)(not needed)
-  sum = _mm_cvtsi128_si32(tmpsum);
+  auto lumaMask = _mm_set1_epi16(0x00FF);
+  auto diff_prev_curr_lo = _mm_sub_epi16(_mm_unpacklo_epi8(prev, zero), _mm_unpacklo_epi8(curr, zero));
+  auto diff_next_curr_lo = _mm_sub_epi16(_mm_unpacklo_epi8(next, zero), _mm_unpacklo_epi8(curr, zero));
+  auto diff_prev_curr_hi = _mm_sub_epi16(_mm_unpackhi_epi8(prev, zero), _mm_unpackhi_epi8(curr, zero));
+  auto diff_next_curr_hi = _mm_sub_epi16(_mm_unpackhi_epi8(next, zero), _mm_unpackhi_epi8(curr, zero));
+
+  auto res_lo_lo = _mm_madd_epi16(_mm_unpacklo_epi16(diff_prev_curr_lo, zero), _mm_unpacklo_epi16(diff_next_curr_lo, zero));
+  auto res_lo_hi = _mm_madd_epi16(_mm_unpackhi_epi16(diff_prev_curr_lo, zero), _mm_unpackhi_epi16(diff_next_curr_lo, zero));
+  auto res_hi_lo = _mm_madd_epi16(_mm_unpacklo_epi16(diff_prev_curr_hi, zero), _mm_unpacklo_epi16(diff_next_curr_hi, zero));
+  auto res_hi_hi = _mm_madd_epi16(_mm_unpackhi_epi16(diff_prev_curr_hi, zero), _mm_unpackhi_epi16(diff_next_curr_hi, zero));
+
+  auto cmp_lo = _mm_packs_epi32(_mm_cmpgt_epi32(res_lo_lo, thresh), _mm_cmpgt_epi32(res_lo_hi, thresh));
+  auto cmp_hi = _mm_packs_epi32(_mm_cmpgt_epi32(res_hi_lo, thresh), _mm_cmpgt_epi32(res_hi_hi, thresh));
+  return _mm_packus_epi16(_mm_and_si128(cmp_lo, lumaMask), _mm_and_si128(cmp_hi, lumaMask));
 }
 
-// instantiate for 8x8
-template void compute_sum_8xN_sse2<8>(const uint8_t* srcp, int pitch, int& sum);
+// Metric 1 with a metric 0 style prefilter (mcascade). (curr - prev) * (curr - next) > cthresh^2
+// needs both differences with the same sign, the larger one above cthresh and, as neither
+// exceeds 255, the smaller one above cthresh^2 / 255. 16 pixel groups where no pixel passes
+// this triple compare are cleared without evaluating the products, the mask is identical.
+template<bool with_luma_mask>
+static void check_combing_SSE2_Metric1_Cascade_generic(const uint8_t* srcp, uint8_t* dstp,
+  int width, int height, int src_pitch, int dst_pitch, int cthresh)
+{
+  const int cthreshsq = cthresh * cthresh;
+  auto thresh = _mm_set1_epi32(cthreshsq);
+  auto thresh_hi = _mm_set1_epi8((char)std::min(cthresh, 255));
+  auto thresh_lo = _mm_set1_epi8((char)std::min(cthreshsq / 255, 255));
+  auto zero = _mm_setzero_si128();
+  // chroma of a luma-only mask is never set
+  const int ignored_lanes = with_luma_mask ? 0xAAAA : 0;
 
-// YUY2 luma only case
-void compute_sum_16x8_sse2_luma(const uint8_t *srcp, int pitch, int &sum)
+  while (height--) {
+    for (int x = 0; x < width; x += 16) {
+      auto next = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp + src_pitch + x));
+      auto curr = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp + x));
+      auto prev = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp - src_pitch + x));
+
+      auto diff_curr_prev = _mm_subs_epu8(curr, prev);
+      auto diff_curr_next = _mm_subs_epu8(curr, next);
+      auto diff_prev_curr = _mm_subs_epu8(prev, curr);
+      auto diff_next_curr = _mm_subs_epu8(next, curr);
+      // 0xFF where the pixel cannot be combed upwards / downwards
+      auto up_fail = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_subs_epu8(_mm_min_epu8(diff_curr_prev, diff_curr_next), thresh_lo), zero),
+        _mm_cmpeq_epi8(_mm_subs_epu8(_mm_max_epu8(diff_curr_prev, diff_curr_next), thresh_hi), zero));
+      auto down_fail = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_subs_epu8(_mm_min_epu8(diff_prev_curr, diff_next_curr), thresh_lo), zero),
+        _mm_cmpeq_epi8(_mm_subs_epu8(_mm_max_epu8(diff_prev_curr, diff_next_curr), thresh_hi), zero));
+      if ((_mm_movemask_epi8(_mm_and_si128(up_fail, down_fail)) | ignored_lanes) == 0xFFFF) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dstp + x), zero);
+        continue;
+      }
+      auto res = metric1_mask_16px(prev, curr, next, thresh);
+      if (with_luma_mask)
+        res = _mm_and_si128(res, _mm_set1_epi16(0x00FF));
+      _mm_store_si128(reinterpret_cast<__m128i*>(dstp + x), res);
+    }
+    srcp += src_pitch;
+    dstp += dst_pitch;
+  }
+}
+
+void check_combing_SSE2_Metric1_Cascade(const uint8_t* srcp, uint8_t* dstp,
+  int width, int height, int src_pitch, int dst_pitch, int cthresh)
+{
+  check_combing_SSE2_Metric1_Cascade_generic<false>(srcp, dstp, width, height, src_pitch, dst_pitch, cthresh);
+}
+
+void check_combing_SSE2_Luma_Metric1_Cascade(const uint8_t* srcp, uint8_t* dstp,
+  int width, int height, int src_pitch, int dst_pitch, int cthresh)
+{
+  check_combing_SSE2_Metric1_Cascade_generic<true>(srcp, dstp, width, height, src_pitch, dst_pitch, cthresh);
+}
+
+// Adds the combed pixel count of half block column hb to the four overlapping blocks
+// containing it. Same as box1 = (x >> xshift) << 2, box2 = ((x + xhalf) >> xshift) << 2.
+static AVS_FORCEINLINE void addHalfBlockSum(int* cArray, int temp1, int temp2, int hb, int sum)
+{
+  const int box1 = (hb >> 1) << 2;
+  const int box2 = ((hb + 1) >> 1) << 2;
+  cArray[temp1 + box1 + 0] += sum;
+  cArray[temp1 + box2 + 1] += sum;
+  cArray[temp2 + box1 + 2] += sum;
+  cArray[temp2 + box2 + 3] += sum;
+}
+
+// vertical count of combed pixels for 16 columns over 'rows' lines, max 32 lines
+// lanes: 0xFF for the bytes to be counted
+static AVS_FORCEINLINE __m128i count_combed_16xN_sse2(const uint8_t* cmkp, int pitch, int rows, __m128i lanes)
 {
-  // sums masks
-  // if (cmkppT[x + v] == 0xFF && cmkpT[x + v] == 0xFF && cmkpnT[x + v] == 0xFF) sum++;
-  // scrp is prev
-  auto onesMask = _mm_set1_epi16(0x0001); // ones where luma
   auto all_ff = _mm_set1_epi8(-1);
-  auto prev = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp));
-  auto curr = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp + pitch));
-  auto summa = _mm_setzero_si128();
-  srcp += pitch * 2; // points to next
-  for (int i = 0; i < 4; i++) { // 4x2=8
-    /*
-    p  #
-    c  # #
-    n  # #
-    nn   #
-    */
-    auto next = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp));
-    auto nextnext = _mm_load_si128(reinterpret_cast<const __m128i*>(srcp + pitch));
-
-    auto anded_common = _mm_and_si128(curr, next);
-    auto with_prev = _mm_and_si128(prev, anded_common);
-    auto with_nextnext = _mm_and_si128(anded_common, nextnext);
-
-    // these were missing from the original assembler code (== 0xFF)
-    with_prev = _mm_cmpeq_epi8(with_prev, all_ff);
-    with_nextnext = _mm_cmpeq_epi8(with_nextnext, all_ff);
-
-    with_prev = _mm_and_si128(with_prev, onesMask);
-    with_nextnext = _mm_and_si128(with_nextnext, onesMask);
-
-    prev = next;
-    curr = nextnext;
-
-    summa = _mm_adds_epu8(summa, with_prev);
-    summa = _mm_adds_epu8(summa, with_nextnext);
-    srcp += pitch * 2;
+  auto prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cmkp - pitch));
+  auto curr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cmkp));
+  auto count = _mm_setzero_si128();
+  for (int u = 0; u < rows; ++u)
+  {
+    auto next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cmkp + pitch));
+    auto anded = _mm_and_si128(_mm_and_si128(prev, curr), next);
+    count = _mm_sub_epi8(count, _mm_and_si128(_mm_cmpeq_epi8(anded, all_ff), lanes)); // +1 where all three are 0xFF
+    prev = curr;
+    curr = next;
+    cmkp += pitch;
   }
+  return count;
+}
 
-  // now we have to sum up lower and upper 8 bytes
-  // in sse2, we use sad
+// Combed pixels of mask lines [y, yend), which must lie in one half block row
+static int accumulateCombedBand_SSE2(const uint8_t* cmkp, int cmk_pitch, int width, int y, int yend,
+  int xhalf, int xshift, int yhalf, int yshift, int* cArray, bool YUY2_LumaOnly)
+{
+  const int xblocks4 = (((width + xhalf) >> xshift) + 1) << 2;
+  const int xhshift = xshift - 1;
+  const int width16 = width & ~15;
+  const int rows = yend - y;
+  const int temp1 = (y >> yshift) * xblocks4;
+  const int temp2 = ((y + yhalf) >> yshift) * xblocks4;
   auto zero = _mm_setzero_si128();
-  auto tmpsum = _mm_sad_epu8(summa, zero);  // sum(lo 8 bytes) / sum(hi 8 bytes)
-  tmpsum = _mm_add_epi32(tmpsum, _mm_srli_si128(tmpsum, 8)); // lo + hi
-  sum = _mm_cvtsi128_si32(tmpsum);
+  auto lo8_mask = _mm_set1_epi16(0x00FF);
+  auto lo16_mask = _mm_set1_epi32(0x0000FFFF);
+  auto lanes = YUY2_LumaOnly ? lo8_mask : _mm_set1_epi8(-1);
+  const int inc = YUY2_LumaOnly ? 2 : 1;
+  int total = 0;
+  cmkp += cmk_pitch * y;
+  for (int x = 0; x < width16; x += 16)
+  {
+    auto count = count_combed_16xN_sse2(cmkp + x, cmk_pitch, rows, lanes);
+    auto sad = _mm_sad_epu8(count, zero);
+    const int sum_lo = _mm_cvtsi128_si32(sad);
+    const int sum_hi = _mm_cvtsi128_si32(_mm_srli_si128(sad, 8));
+    if (sum_lo + sum_hi == 0)
+      continue;
+    total += sum_lo + sum_hi;
+    if (xhalf >= 16)
+      addHalfBlockSum(cArray, temp1, temp2, x >> xhshift, sum_lo + sum_hi);
+    else if (xhalf == 8)
+    {
+      if (sum_lo) addHalfBlockSum(cArray, temp1, temp2, x >> 3, sum_lo);
+      if (sum_hi) addHalfBlockSum(cArray, temp1, temp2, (x >> 3) + 1, sum_hi);
+    }
+    else
+    {
+      // horizontal pair sums in 16 bit words, quad sums in 32 bit dwords
+      auto sum2 = _mm_add_epi16(_mm_and_si128(count, lo8_mask), _mm_srli_epi16(count, 8));
+      alignas(16) int sums[8];
+      int n;
+      if (xhalf == 4)
+      {
+        auto sum4 = _mm_add_epi32(_mm_and_si128(sum2, lo16_mask), _mm_srli_epi32(sum2, 16));
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum4);
+        n = 4;
+      }
+      else
+      {
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), _mm_unpacklo_epi16(sum2, zero));
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums + 4), _mm_unpackhi_epi16(sum2, zero));
+        n = 8;
+      }
+      const int hb = x >> xhshift;
+      for (int i = 0; i < n; ++i)
+      {
+        if (sums[i]) addHalfBlockSum(cArray, temp1, temp2, hb + i, sums[i]);
+      }
+    }
+  }
+  // rest on the right
+  for (int x = width16; x < width; x += inc)
+  {
+    const uint8_t* cmkpT = cmkp + x;
+    int sum = 0;
+    for (int u = 0; u < rows; ++u)
+    {
+      if (cmkpT[-cmk_pitch] == 0xFF && cmkpT[0] == 0xFF && cmkpT[cmk_pitch] == 0xFF)
+        ++sum;
+      cmkpT += cmk_pitch;
+    }
+    if (sum)
+    {
+      total += sum;
+      addHalfBlockSum(cArray, temp1, temp2, x >> xhshift, sum);
+    }
+  }
+  return total;
+}
+
+static int accumulateCombedBand_c(const uint8_t* cmkp, int cmk_pitch, int width, int y, int yend,
+  int xhalf, int xshift, int yhalf, int yshift, int* cArray, bool YUY2_LumaOnly)
+{
+  const int xblocks4 = (((width + xhalf) >> xshift) + 1) << 2;
+  const int inc = YUY2_LumaOnly ? 2 : 1;
+  cmkp += cmk_pitch * y;
+  const uint8_t* cmkpp = cmkp - cmk_pitch;
+  const uint8_t* cmkpn = cmkp + cmk_pitch;
+  int total = 0;
+  for (; y < yend; ++y)
+  {
+    const int temp1 = (y >> yshift) * xblocks4;
+    const int temp2 = ((y + yhalf) >> yshift) * xblocks4;
+    for (int x = 0; x < width; x += inc)
+    {
+      if (cmkpp[x] == 0xFF && cmkp[x] == 0xFF && cmkpn[x] == 0xFF)
+      {
+        const int box1 = (x >> xshift) << 2;
+        const int box2 = ((x + xhalf) >> xshift) << 2;
+        ++cArray[temp1 + box1 + 0];
+        ++cArray[temp1 + box2 + 1];
+        ++cArray[temp2 + box1 + 2];
+        ++cArray[temp2 + box2 + 3];
+        ++total;
+      }
+    }
+    cmkpp += cmk_pitch;
+    cmkp += cmk_pitch;
+    cmkpn += cmk_pitch;
+  }
+  return total;
+}
+
+static AVS_FORCEINLINE int accumulateCombedBand(const uint8_t* cmkp, int cmk_pitch, int width, int y, int yend,
+  int xhalf, int xshift, int yhalf, int yshift, int* cArray, bool YUY2_LumaOnly, bool use_sse2)
+{
+  // byte counters hold up to 32 lines
+  if (use_sse2)
+    return accumulateCombedBand_SSE2(cmkp, cmk_pitch, width, y, yend, xhalf, xshift, yhalf, yshift, cArray, YUY2_LumaOnly);
+  return accumulateCombedBand_c(cmkp, cmk_pitch, width, y, yend, xhalf, xshift, yhalf, yshift, cArray, YUY2_LumaOnly);
+}
+
+int accumulateCombedBlocks(const uint8_t* cmkp, int cmk_pitch, int width, int height,
+  int xhalf, int xshift, int yhalf, int yshift, int* cArray, bool YUY2_LumaOnly, int cpuFlags)
+{
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) && xhalf <= 32 && yhalf <= 32;
+  const int yhshift = yshift - 1;
+  int total = 0;
+  for (int y = 1; y < height - 1; )
+  {
+    // lines of one half block row, they share the same block rows
+    const int yend = std::min(((y >> yhshift) + 1) << yhshift, height - 1);
+    total += accumulateCombedBand(cmkp, cmk_pitch, width, y, yend, xhalf, xshift, yhalf, yshift, cArray, YUY2_LumaOnly, use_sse2);
+    y = yend;
+  }
+  return total;
+}
+
+template<typename pixel_t>
+void buildCombMask(const pixel_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int y0, int y1, int cthresh, int metric, bool mcascade, int cpuFlags)
+{
+  uint8_t* cmkpy0 = cmkp + cmk_pitch * y0;
+  if (cthresh < 0) {
+    memset(cmkpy0, 255, (y1 - y0) * cmk_pitch); // mask. Always 8 bits
+    return;
+  }
+  memset(cmkpy0, 0, (y1 - y0) * cmk_pitch);
+
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+  const bool use_sse4 = (cpuFlags & CPUF_SSE4_1) ? true : false;
+
+  if (metric == 0)
+  {
+    const int cthresh6 = cthresh * 6;
+    // lines 0, 1, height-2 and height-1 have their own formula, for tiny planes
+    // more than one of them can apply, the middle lines are done by the SIMD workers
+    const int mid0 = 2;
+    const int mid1 = std::max(mid0, height - 2);
+    for (int y = y0; y < y1; )
+    {
+      const pixel_t* srcp_y = srcp + src_pitch * y;
+      uint8_t* cmkp_y = cmkp + cmk_pitch * y;
+      if (y >= mid0 && y < mid1)
+      {
+        const int lines_to_process = std::min(y1, mid1) - y;
+        if (use_sse2 && sizeof(pixel_t) == 1)
+          check_combing_SSE2((const uint8_t*)srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthresh);
+        else if (use_sse4 && sizeof(pixel_t) == 2)
+          check_combing_uint16_SSE4((const uint16_t*)srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthresh);
+        else
+          check_combing_c<pixel_t, false>(srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthresh);
+        y += lines_to_process;
+        continue;
+      }
+      const pixel_t* srcppp = srcp_y - src_pitch * 2;
+      const pixel_t* srcpp = srcp_y - src_pitch;
+      const pixel_t* srcpn = srcp_y + src_pitch;
+      const pixel_t* srcpnn = srcp_y + src_pitch * 2;
+      if (y == 0)
+      {
+        // top #1
+        for (int x = 0; x < width; ++x)
+        {
+          const int sFirst = srcp_y[x] - srcpn[x];
+          if (sFirst > cthresh || sFirst < -cthresh)
+          {
+            if (abs(srcpnn[x] + (srcp_y[x] << 2) + srcpnn[x] - (3 * (srcpn[x] + srcpn[x]))) > cthresh6)
+              cmkp_y[x] = 0xFF;
+          }
+        }
+      }
+      if (y == 1)
+      {
+        // top #2
+        for (int x = 0; x < width; ++x)
+        {
+          const int sFirst = srcp_y[x] - srcpp[x];
+          const int sSecond = srcp_y[x] - srcpn[x];
+          if ((sFirst > cthresh && sSecond > cthresh) || (sFirst < -cthresh && sSecond < -cthresh))
+          {
+            if (abs(srcpnn[x] + (srcp_y[x] << 2) + srcpnn[x] - (3 * (srcpp[x] + srcpn[x]))) > cthresh6)
+              cmkp_y[x] = 0xFF;
+          }
+        }
+      }
+      if (y == height - 2)
+      {
+        // bottom #-2
+        for (int x = 0; x < width; ++x)
+        {
+          const int sFirst = srcp_y[x] - srcpp[x];
+          const int sSecond = srcp_y[x] - srcpn[x];
+          if ((sFirst > cthresh && sSecond > cthresh) || (sFirst < -cthresh && sSecond < -cthresh))
+          {
+            if (abs(srcppp[x] + (srcp_y[x] << 2) + srcppp[x] - (3 * (srcpp[x] + srcpn[x]))) > cthresh6)
+              cmkp_y[x] = 0xFF;
+          }
+        }
+      }
+      if (y == height - 1)
+      {
+        // bottom #-1
+        for (int x = 0; x < width; ++x)
+        {
+          const int sFirst = srcp_y[x] - srcpp[x];
+          if (sFirst > cthresh || sFirst < -cthresh)
+          {
+            if (abs(srcppp[x] + (srcp_y[x] << 2) + srcppp[x] - (3 * (srcpp[x] + srcpp[x]))) > cthresh6)
+              cmkp_y[x] = 0xFF;
+          }
+        }
+      }
+      ++y;
+    }
+  }
+  else
+  {
+    // metric == 1: squared
+    typedef typename std::conditional<sizeof(pixel_t) == 1, int, int64_t> ::type safeint_t;
+    const safeint_t cthreshsq = (safeint_t)cthresh * cthresh;
+    const int mid0 = 1;
+    const int mid1 = std::max(mid0, height - 1);
+    for (int y = y0; y < y1; )
+    {
+      const pixel_t* srcp_y = srcp + src_pitch * y;
+      uint8_t* cmkp_y = cmkp + cmk_pitch * y;
+      if (y >= mid0 && y < mid1)
+      {
+        const int lines_to_process = std::min(y1, mid1) - y;
+        if constexpr (sizeof(pixel_t) == 1) {
+          if (use_sse2 && mcascade)
+            check_combing_SSE2_Metric1_Cascade(srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthresh);
+          else if (use_sse2)
+            check_combing_SSE2_Metric1(srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
+          else
+            check_combing_c_Metric1<pixel_t, false, safeint_t>(srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
+        }
+        else {
+          // fixme: hbd SIMD? int64 inside.
+          check_combing_c_Metric1<pixel_t, false, safeint_t>(srcp_y, cmkp_y, width, lines_to_process, src_pitch, cmk_pitch, cthreshsq);
+        }
+        y += lines_to_process;
+        continue;
+      }
+      const pixel_t* srcpp = srcp_y - src_pitch;
+      const pixel_t* srcpn = srcp_y + src_pitch;
+      if (y == 0)
+      {
+        // top
+        for (int x = 0; x < width; ++x)
+        {
+          if ((safeint_t)(srcp_y[x] - srcpn[x]) * (srcp_y[x] - srcpn[x]) > cthreshsq)
+            cmkp_y[x] = 0xFF;
+        }
+      }
+      if (y == height - 1)
+      {
+        // bottom
+        for (int x = 0; x < width; ++x)
+        {
+          if ((safeint_t)(srcp_y[x] - srcpp[x]) * (srcp_y[x] - srcpp[x]) > cthreshsq)
+            cmkp_y[x] = 0xFF;
+        }
+      }
+      ++y;
+    }
+  }
+}
+
+template void buildCombMask<uint8_t>(const uint8_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int y0, int y1, int cthresh, int metric, bool mcascade, int cpuFlags);
+template void buildCombMask<uint16_t>(const uint16_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int y0, int y1, int cthresh, int metric, bool mcascade, int cpuFlags);
+
+template<typename pixel_t>
+bool checkCombedBlocksMI(const pixel_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int cthresh, int metric, bool mcascade, bool buildMask, int xhalf, int xshift, int yhalf, int yshift,
+  int* cArray, int MI, bool YUY2_LumaOnly, int cpuFlags)
+{
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) && xhalf <= 32 && yhalf <= 32;
+  const int xblocks4 = (((width + xhalf) >> xshift) + 1) << 2;
+  const int yhshift = yshift - 1;
+  int built = buildMask ? 0 : height;
+  for (int y = 1; y < height - 1; )
+  {
+    const int yend = std::min(((y >> yhshift) + 1) << yhshift, height - 1);
+    // the band reads mask lines y-1..yend
+    const int need = std::min(yend + 1, height);
+    if (built < need)
+    {
+      buildCombMask<pixel_t>(srcp, src_pitch, cmkp, cmk_pitch, width, height, built, need, cthresh, metric, mcascade, cpuFlags);
+      built = need;
+    }
+    if (accumulateCombedBand(cmkp, cmk_pitch, width, y, yend, xhalf, xshift, yhalf, yshift, cArray, YUY2_LumaOnly, use_sse2))
+    {
+      // only the two block rows of this band have changed
+      const int* c1 = cArray + (y >> yshift) * xblocks4;
+      const int* c2 = cArray + ((y + yhalf) >> yshift) * xblocks4;
+      for (int x = 0; x < xblocks4; ++x)
+      {
+        if (c1[x] > MI || c2[x] > MI)
+          return true;
+      }
+    }
+    y = yend;
+  }
+  return false;
 }
 
+template bool checkCombedBlocksMI<uint8_t>(const uint8_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int cthresh, int metric, bool mcascade, bool buildMask, int xhalf, int xshift, int yhalf, int yshift,
+  int* cArray, int MI, bool YUY2_LumaOnly, int cpuFlags);
+template bool checkCombedBlocksMI<uint16_t>(const uint16_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int cthresh, int metric, bool mcascade, bool buildMask, int xhalf, int xshift, int yhalf, int yshift,
+  int* cArray, int MI, bool YUY2_LumaOnly, int cpuFlags);
+
 void copyFrame(PVideoFrame& dst, PVideoFrame& src, const VideoInfo& vi, IScriptEnvironment* env)
 {
   const int planes[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
@@ -1375,3 +1723,480 @@ template void do_FillCombedPlanarUpdateCmaskByUV<411>(uint8_t* cmkp, uint8_t* cm
 template void do_FillCombedPlanarUpdateCmaskByUV<420>(uint8_t* cmkp, uint8_t* cmkpU, uint8_t* cmkpV, int Width, int Height, ptrdiff_t cmk_pitch, ptrdiff_t cmk_pitchUV);
 template void do_FillCombedPlanarUpdateCmaskByUV<422>(uint8_t* cmkp, uint8_t* cmkpU, uint8_t* cmkpV, int Width, int Height, ptrdiff_t cmk_pitch, ptrdiff_t cmk_pitchUV);
 template void do_FillCombedPlanarUpdateCmaskByUV<444>(uint8_t* cmkp, uint8_t* cmkpU, uint8_t* cmkpV, int Width, int Height, ptrdiff_t cmk_pitch, ptrdiff_t cmk_pitchUV);
+
+
+// compareFields helpers
+
+// lane is set where (eax & m) != 0, restricted to the active lanes
+static AVS_FORCEINLINE __m128i cf_test_epi16(__m128i eax, int m, __m128i lanes)
+{
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(eax, _mm_set1_epi16(m)), zero), lanes);
+}
+
+static AVS_FORCEINLINE __m128i cf_absdiff_epi16(__m128i a, __m128i b)
+{
+  const __m128i diff = _mm_sub_epi16(a, b);
+  return _mm_max_epi16(diff, _mm_sub_epi16(_mm_setzero_si128(), diff));
+}
+
+static AVS_FORCEINLINE void cf_accum_epi16(__m128i& acc, __m128i diff, __m128i cond)
+{
+  acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_and_si128(diff, cond), _mm_set1_epi16(1)));
+}
+
+static AVS_FORCEINLINE __m128i cf_load8_epi16(const uint8_t* p, int x)
+{
+  return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + x)), _mm_setzero_si128());
+}
+
+// 3*(a+b)
+static AVS_FORCEINLINE __m128i cf_mul3_sum_epi16(__m128i a, __m128i b)
+{
+  const __m128i sum = _mm_add_epi16(a, b);
+  return _mm_add_epi16(sum, _mm_add_epi16(sum, sum));
+}
+
+// a+4*b+c
+static AVS_FORCEINLINE __m128i cf_121_sum_epi16(__m128i a, __m128i b, __m128i c)
+{
+  return _mm_add_epi16(_mm_add_epi16(a, c), _mm_slli_epi16(b, 2));
+}
+
+// sum of the four unsigned 32 bit lanes
+static AVS_FORCEINLINE uint64_t cf_hsum_epu32(__m128i v)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = _mm_add_epi64(_mm_unpacklo_epi32(v, zero), _mm_unpackhi_epi32(v, zero));
+  sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
+  uint64_t result;
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&result), sum);
+  return result;
+}
+
+// see the C loops in TFM::compareFields_core, compareFieldsSlow_core and compareFieldsSlow2_core
+// and TDeinterlace::subtractFields
+template<int variant>
+int compareFieldsRow_SSE2(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum)
+{
+  constexpr int mapshift = variant == 0 ? 2 : 3;
+  constexpr int maskC = variant == 0 ? 0xFF : 9;
+  constexpr int maskM = variant == 0 ? 10 : 18;
+  constexpr int maskML = 36;
+
+  const __m128i lanes = lumaOnly ? _mm_set1_epi32(0x0000FFFF) : _mm_set1_epi16(-1);
+  const __m128i c23 = _mm_set1_epi16(Const23);
+  const __m128i c42 = _mm_set1_epi16(Const42);
+  const __m128i mc3 = _mm_set1_epi16(l.mapConst3);
+  const __m128i mc19 = _mm_set1_epi16(l.mapConst19);
+  const __m128i map2shift = _mm_cvtsi32_si128(l.map2shift);
+
+  __m128i sumPc = _mm_setzero_si128();
+  __m128i sumNc = _mm_setzero_si128();
+  __m128i sumPm = _mm_setzero_si128();
+  __m128i sumNm = _mm_setzero_si128();
+  __m128i sumPml = _mm_setzero_si128();
+  __m128i sumNml = _mm_setzero_si128();
+
+  int x = startx;
+  for (; x + 8 <= stopx; x += 8)
+  {
+    const __m128i prvpf = cf_load8_epi16(l.prvpf, x);
+    const __m128i prvnf = cf_load8_epi16(l.prvnf, x);
+    const __m128i nxtpf = cf_load8_epi16(l.nxtpf, x);
+    const __m128i nxtnf = cf_load8_epi16(l.nxtnf, x);
+
+    __m128i eax, condC, condM;
+    if constexpr (variant == 3) {
+      // map flags on the fly: the map is 1 where |prv - nxt| > Const3, 3 where > Const19
+      const __m128i dp = cf_absdiff_epi16(prvpf, nxtpf);
+      const __m128i dn = cf_absdiff_epi16(prvnf, nxtnf);
+      condC = _mm_and_si128(_mm_or_si128(_mm_cmpgt_epi16(dp, mc3), _mm_cmpgt_epi16(dn, mc3)), lanes);
+      condM = _mm_and_si128(_mm_or_si128(_mm_cmpgt_epi16(dp, mc19), _mm_cmpgt_epi16(dn, mc19)), lanes);
+    }
+    else {
+      eax = _mm_add_epi16(_mm_slli_epi16(cf_load8_epi16(l.mapp, x), mapshift), cf_load8_epi16(l.mapn, x));
+      condC = cf_test_epi16(eax, maskC, lanes);
+      condM = cf_test_epi16(eax, maskM, lanes);
+    }
+
+    const __m128i a_curr = cf_121_sum_epi16(cf_load8_epi16(l.curpf, x), cf_load8_epi16(l.curf, x), cf_load8_epi16(l.curnf, x));
+    const __m128i a_prev = cf_mul3_sum_epi16(prvpf, prvnf);
+    const __m128i a_next = cf_mul3_sum_epi16(nxtpf, nxtnf);
+
+    const __m128i diff_p_c = cf_absdiff_epi16(a_prev, a_curr);
+    const __m128i diff_n_c = cf_absdiff_epi16(a_next, a_curr);
+    const __m128i p42 = _mm_cmpgt_epi16(diff_p_c, c42);
+    const __m128i n42 = _mm_cmpgt_epi16(diff_n_c, c42);
+
+    cf_accum_epi16(sumPc, diff_p_c, _mm_and_si128(_mm_cmpgt_epi16(diff_p_c, c23), condC));
+    cf_accum_epi16(sumNc, diff_n_c, _mm_and_si128(_mm_cmpgt_epi16(diff_n_c, c23), condC));
+    cf_accum_epi16(sumPm, diff_p_c, _mm_and_si128(p42, condM));
+    cf_accum_epi16(sumNm, diff_n_c, _mm_and_si128(n42, condM));
+    if constexpr (variant == 1 || variant == 2) {
+      const __m128i condML = cf_test_epi16(eax, maskML, lanes);
+      cf_accum_epi16(sumPml, diff_p_c, _mm_and_si128(p42, condML));
+      cf_accum_epi16(sumNml, diff_n_c, _mm_and_si128(n42, condML));
+    }
+    if constexpr (variant == 2) {
+      // opposite parity: same conditions on the other three bits of the map
+      const __m128i eax2 = _mm_srl_epi16(eax, map2shift);
+      const __m128i cond1 = cf_test_epi16(eax2, 1, lanes);
+      const __m128i cond2 = cf_test_epi16(eax2, 2, lanes);
+      const __m128i cond4 = cf_test_epi16(eax2, 4, lanes);
+
+      const __m128i a_curr2 = cf_mul3_sum_epi16(cf_load8_epi16(l.cur2a, x), cf_load8_epi16(l.cur2b, x));
+      const __m128i a_prev2 = cf_121_sum_epi16(cf_load8_epi16(l.prv2a, x), cf_load8_epi16(l.prv2b, x), cf_load8_epi16(l.prv2c, x));
+      const __m128i a_next2 = cf_121_sum_epi16(cf_load8_epi16(l.nxt2a, x), cf_load8_epi16(l.nxt2b, x), cf_load8_epi16(l.nxt2c, x));
+
+      const __m128i diff_p_c2 = cf_absdiff_epi16(a_prev2, a_curr2);
+      const __m128i diff_n_c2 = cf_absdiff_epi16(a_next2, a_curr2);
+      const __m128i p42_2 = _mm_cmpgt_epi16(diff_p_c2, c42);
+      const __m128i n42_2 = _mm_cmpgt_epi16(diff_n_c2, c42);
+
+      cf_accum_epi16(sumPc, diff_p_c2, _mm_and_si128(_mm_cmpgt_epi16(diff_p_c2, c23), cond1));
+      cf_accum_epi16(sumNc, diff_n_c2, _mm_and_si128(_mm_cmpgt_epi16(diff_n_c2, c23), cond1));
+      cf_accum_epi16(sumPm, diff_p_c2, _mm_and_si128(p42_2, cond2));
+      cf_accum_epi16(sumNm, diff_n_c2, _mm_and_si128(n42_2, cond2));
+      cf_accum_epi16(sumPml, diff_p_c2, _mm_and_si128(p42_2, cond4));
+      cf_accum_epi16(sumNml, diff_n_c2, _mm_and_si128(n42_2, cond4));
+    }
+  }
+
+  accum[0] += cf_hsum_epu32(sumPc);
+  accum[1] += cf_hsum_epu32(sumNc);
+  accum[2] += cf_hsum_epu32(sumPm);
+  accum[3] += cf_hsum_epu32(sumNm);
+  if constexpr (variant == 1 || variant == 2) {
+    accum[4] += cf_hsum_epu32(sumPml);
+    accum[5] += cf_hsum_epu32(sumNml);
+  }
+  return x;
+}
+
+
+// uint16_t versions: sums of up to six 16 bit pixels need 32 bit lanes
+
+#if defined(GCC) || defined(CLANG)
+__attribute__((__target__("sse4.1")))
+#endif
+static AVS_FORCEINLINE __m128i cf_test_epi32(__m128i eax, int m)
+{
+  return _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(eax, _mm_set1_epi32(m)), _mm_setzero_si128()), _mm_set1_epi32(-1));
+}
+
+#if defined(GCC) || defined(CLANG)
+__attribute__((__target__("sse4.1")))
+#endif
+static AVS_FORCEINLINE void cf_accum_epi32(__m128i& acc, __m128i diff, __m128i cond)
+{
+  acc = _mm_add_epi32(acc, _mm_and_si128(diff, cond));
+}
+
+#if defined(GCC) || defined(CLANG)
+__attribute__((__target__("sse4.1")))
+#endif
+static AVS_FORCEINLINE __m128i cf_load4_epi32(const uint8_t* p, int x)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(reinterpret_cast<const uint16_t*>(p) + x)));
+}
+
+#if defined(GCC) || defined(CLANG)
+__attribute__((__target__("sse4.1")))
+#endif
+static AVS_FORCEINLINE __m128i cf_loadmap4_epi32(const uint8_t* p, int x)
+{
+  int m;
+  memcpy(&m, p + x, sizeof(m));
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(m));
+}
+
+template<int variant>
+#if defined(GCC) || defined(CLANG)
+__attribute__((__target__("sse4.1")))
+#endif
+int compareFieldsRow_uint16_SSE4(const CompareFieldsLines& l, int startx, int stopx,
+  bool /*lumaOnly*/, int Const23, int Const42, uint64_t* accum)
+{
+  // no YUY2 in high bit depth: lumaOnly is n/a
+  constexpr int mapshift = variant == 0 ? 2 : 3;
+  constexpr int maskC = variant == 0 ? 0xFF : 9;
+  constexpr int maskM = variant == 0 ? 10 : 18;
+  constexpr int maskML = 36;
+
+  const __m128i c23 = _mm_set1_epi32(Const23);
+  const __m128i c42 = _mm_set1_epi32(Const42);
+  const __m128i mc3 = _mm_set1_epi32(l.mapConst3);
+  const __m128i mc19 = _mm_set1_epi32(l.mapConst19);
+  const __m128i map2shift = _mm_cvtsi32_si128(l.map2shift);
+
+  __m128i sumPc = _mm_setzero_si128();
+  __m128i sumNc = _mm_setzero_si128();
+  __m128i sumPm = _mm_setzero_si128();
+  __m128i sumNm = _mm_setzero_si128();
+  __m128i sumPml = _mm_setzero_si128();
+  __m128i sumNml = _mm_setzero_si128();
+
+  int x = startx;
+  for (; x + 4 <= stopx; x += 4)
+  {
+    const __m128i prvpf = cf_load4_epi32(l.prvpf, x);
+    const __m128i prvnf = cf_load4_epi32(l.prvnf, x);
+    const __m128i nxtpf = cf_load4_epi32(l.nxtpf, x);
+    const __m128i nxtnf = cf_load4_epi32(l.nxtnf, x);
+
+    __m128i eax, condC, condM;
+    if constexpr (variant == 3) {
+      const __m128i dp = _mm_abs_epi32(_mm_sub_epi32(prvpf, nxtpf));
+      const __m128i dn = _mm_abs_epi32(_mm_sub_epi32(prvnf, nxtnf));
+      condC = _mm_or_si128(_mm_cmpgt_epi32(dp, mc3), _mm_cmpgt_epi32(dn, mc3));
+      condM = _mm_or_si128(_mm_cmpgt_epi32(dp, mc19), _mm_cmpgt_epi32(dn, mc19));
+    }
+    else {
+      eax = _mm_add_epi32(_mm_slli_epi32(cf_loadmap4_epi32(l.mapp, x), mapshift), cf_loadmap4_epi32(l.mapn, x));
+      condC = cf_test_epi32(eax, maskC);
+      condM = cf_test_epi32(eax, maskM);
+    }
+
+    const __m128i a_curr = _mm_add_epi32(_mm_add_epi32(cf_load4_epi32(l.curpf, x), cf_load4_epi32(l.curnf, x)), _mm_slli_epi32(cf_load4_epi32(l.curf, x), 2));
+    const __m128i prv = _mm_add_epi32(prvpf, prvnf);
+    const __m128i nxt = _mm_add_epi32(nxtpf, nxtnf);
+    const __m128i a_prev = _mm_add_epi32(prv, _mm_add_epi32(prv, prv));
+    const __m128i a_next = _mm_add_epi32(nxt, _mm_add_epi32(nxt, nxt));
+
+    const __m128i diff_p_c = _mm_abs_epi32(_mm_sub_epi32(a_prev, a_curr));
+    const __m128i diff_n_c = _mm_abs_epi32(_mm_sub_epi32(a_next, a_curr));
+    const __m128i p42 = _mm_cmpgt_epi32(diff_p_c, c42);
+    const __m128i n42 = _mm_cmpgt_epi32(diff_n_c, c42);
+
+    cf_accum_epi32(sumPc, diff_p_c, _mm_and_si128(_mm_cmpgt_epi32(diff_p_c, c23), condC));
+    cf_accum_epi32(sumNc, diff_n_c, _mm_and_si128(_mm_cmpgt_epi32(diff_n_c, c23), condC));
+    cf_accum_epi32(sumPm, diff_p_c, _mm_and_si128(p42, condM));
+    cf_accum_epi32(sumNm, diff_n_c, _mm_and_si128(n42, condM));
+    if constexpr (variant == 1 || variant == 2) {
+      const __m128i condML = cf_test_epi32(eax, maskML);
+      cf_accum_epi32(sumPml, diff_p_c, _mm_and_si128(p42, condML));
+      cf_accum_epi32(sumNml, diff_n_c, _mm_and_si128(n42, condML));
+    }
+    if constexpr (variant == 2) {
+      const __m128i eax2 = _mm_srl_epi32(eax, map2shift);
+      const __m128i cond1 = cf_test_epi32(eax2, 1);
+      const __m128i cond2 = cf_test_epi32(eax2, 2);
+      const __m128i cond4 = cf_test_epi32(eax2, 4);
+
+      const __m128i cur2 = _mm_add_epi32(cf_load4_epi32(l.cur2a, x), cf_load4_epi32(l.cur2b, x));
+      const __m128i a_curr2 = _mm_add_epi32(cur2, _mm_add_epi32(cur2, cur2));
+      const __m128i a_prev2 = _mm_add_epi32(_mm_add_epi32(cf_load4_epi32(l.prv2a, x), cf_load4_epi32(l.prv2c, x)), _mm_slli_epi32(cf_load4_epi32(l.prv2b, x), 2));
+      const __m128i a_next2 = _mm_add_epi32(_mm_add_epi32(cf_load4_epi32(l.nxt2a, x), cf_load4_epi32(l.nxt2c, x)), _mm_slli_epi32(cf_load4_epi32(l.nxt2b, x), 2));
+
+      const __m128i diff_p_c2 = _mm_abs_epi32(_mm_sub_epi32(a_prev2, a_curr2));
+      const __m128i diff_n_c2 = _mm_abs_epi32(_mm_sub_epi32(a_next2, a_curr2));
+      const __m128i p42_2 = _mm_cmpgt_epi32(diff_p_c2, c42);
+      const __m128i n42_2 = _mm_cmpgt_epi32(diff_n_c2, c42);
+
+      cf_accum_epi32(sumPc, diff_p_c2, _mm_and_si128(_mm_cmpgt_epi32(diff_p_c2, c23), cond1));
+      cf_accum_epi32(sumNc, diff_n_c2, _mm_and_si128(_mm_cmpgt_epi32(diff_n_c2, c23), cond1));
+      cf_accum_epi32(sumPm, diff_p_c2, _mm_and_si128(p42_2, cond2));
+      cf_accum_epi32(sumNm, diff_n_c2, _mm_and_si128(n42_2, cond2));
+      cf_accum_epi32(sumPml, diff_p_c2, _mm_and_si128(p42_2, cond4));
+      cf_accum_epi32(sumNml, diff_n_c2, _mm_and_si128(n42_2, cond4));
+    }
+  }
+
+  // 32 bit lanes are safe for one line: (width/4) * 6 * 65535 * 2
+  accum[0] += cf_hsum_epu32(sumPc);
+  accum[1] += cf_hsum_epu32(sumNc);
+  accum[2] += cf_hsum_epu32(sumPm);
+  accum[3] += cf_hsum_epu32(sumNm);
+  if constexpr (variant == 1 || variant == 2) {
+    accum[4] += cf_hsum_epu32(sumPml);
+    accum[5] += cf_hsum_epu32(sumNml);
+  }
+  return x;
+}
+
+template<int variant>
+compareFieldsRow_fn_t* get_compareFieldsRow_fn(int pixelsize, int cpuFlags)
+{
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+  const bool use_sse4 = (cpuFlags & CPUF_SSE4_1) ? true : false;
+  const bool use_avx2 = (cpuFlags & CPUF_AVX2) ? true : false;
+
+  if (pixelsize == 1) {
+    if (use_avx2)
+      return compareFieldsRow_AVX2<variant>;
+    if (use_sse2)
+      return compareFieldsRow_SSE2<variant>;
+  }
+  else {
+    if (use_avx2)
+      return compareFieldsRow_uint16_AVX2<variant>;
+    if (use_sse4)
+      return compareFieldsRow_uint16_SSE4<variant>;
+  }
+  return nullptr; // C only
+}
+
+template compareFieldsRow_fn_t* get_compareFieldsRow_fn<0>(int pixelsize, int cpuFlags);
+template compareFieldsRow_fn_t* get_compareFieldsRow_fn<1>(int pixelsize, int cpuFlags);
+template compareFieldsRow_fn_t* get_compareFieldsRow_fn<2>(int pixelsize, int cpuFlags);
+template compareFieldsRow_fn_t* get_compareFieldsRow_fn<3>(int pixelsize, int cpuFlags);
+
+// TDeint AP post check, spike test of one interpolated row.
+// dstp: row y, dstpp/dstpn: rows y-1/y+1, dstpa/dstpb: rows y-3/y+3 (mirrored at the frame edges).
+// Pixels already at 60 in maskw are reset to 10, the others are set to 60 when they
+// stick out of both vertical neighbours by more than AP, 10 otherwise. Returns the number set to 60.
+template<typename pixel_t>
+int apPostCheckRow_c(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int startx, int stopx, int AP, int AP6)
+{
+  const pixel_t* p = reinterpret_cast<const pixel_t*>(dstp);
+  const pixel_t* pp = reinterpret_cast<const pixel_t*>(dstpp);
+  const pixel_t* pn = reinterpret_cast<const pixel_t*>(dstpn);
+  const pixel_t* pa = reinterpret_cast<const pixel_t*>(dstpa);
+  const pixel_t* pb = reinterpret_cast<const pixel_t*>(dstpb);
+  int count = 0;
+  for (int x = startx; x < stopx; ++x)
+  {
+    if (maskw[x] == 60) { maskw[x] = 10; continue; }
+    maskw[x] = 10;
+    const int sFirst = p[x] - pp[x];
+    const int sSecond = p[x] - pn[x];
+    if ((sFirst > AP && sSecond > AP) || (sFirst < -AP && sSecond < -AP))
+    {
+      if (abs(pa[x] + (p[x] << 2) + pb[x] - (3 * (pp[x] + pn[x]))) > AP6)
+      {
+        maskw[x] = 60;
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+static AVS_FORCEINLINE int ap_bitcount(unsigned int m)
+{
+  int c = 0;
+  for (; m; m &= m - 1) ++c;
+  return c;
+}
+
+// spike lanes of 8 pixels, 16 bit lanes (8 bit input)
+static AVS_FORCEINLINE __m128i ap_spike_epi16(__m128i p, __m128i pp, __m128i pn, __m128i pa, __m128i pb,
+  __m128i AP, __m128i minusAP, __m128i AP6)
+{
+  auto sFirst = _mm_sub_epi16(p, pp);
+  auto sSecond = _mm_sub_epi16(p, pn);
+  auto above = _mm_and_si128(_mm_cmpgt_epi16(sFirst, AP), _mm_cmpgt_epi16(sSecond, AP));
+  auto below = _mm_and_si128(_mm_cmplt_epi16(sFirst, minusAP), _mm_cmplt_epi16(sSecond, minusAP));
+  auto pp_pn = _mm_add_epi16(pp, pn);
+  auto e = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(pa, pb), _mm_slli_epi16(p, 2)),
+    _mm_add_epi16(pp_pn, _mm_add_epi16(pp_pn, pp_pn)));
+  auto abs_e = _mm_max_epi16(e, _mm_sub_epi16(_mm_setzero_si128(), e));
+  return _mm_and_si128(_mm_or_si128(above, below), _mm_cmpgt_epi16(abs_e, AP6));
+}
+
+// spike lanes of 4 pixels, 32 bit lanes (16 bit input)
+static AVS_FORCEINLINE __m128i ap_spike_epi32(__m128i p, __m128i pp, __m128i pn, __m128i pa, __m128i pb,
+  __m128i AP, __m128i minusAP, __m128i AP6)
+{
+  auto sFirst = _mm_sub_epi32(p, pp);
+  auto sSecond = _mm_sub_epi32(p, pn);
+  auto above = _mm_and_si128(_mm_cmpgt_epi32(sFirst, AP), _mm_cmpgt_epi32(sSecond, AP));
+  auto below = _mm_and_si128(_mm_cmplt_epi32(sFirst, minusAP), _mm_cmplt_epi32(sSecond, minusAP));
+  auto pp_pn = _mm_add_epi32(pp, pn);
+  auto e = _mm_sub_epi32(_mm_add_epi32(_mm_add_epi32(pa, pb), _mm_slli_epi32(p, 2)),
+    _mm_add_epi32(pp_pn, _mm_add_epi32(pp_pn, pp_pn)));
+  auto sign = _mm_srai_epi32(e, 31);
+  auto abs_e = _mm_sub_epi32(_mm_xor_si128(e, sign), sign);
+  return _mm_and_si128(_mm_or_si128(above, below), _mm_cmpgt_epi32(abs_e, AP6));
+}
+
+// new mask bytes from the byte spike flags, see apPostCheckRow_c
+static AVS_FORCEINLINE __m128i ap_update_mask(__m128i mask, __m128i spike, int& count, int bits)
+{
+  auto hit = _mm_andnot_si128(_mm_cmpeq_epi8(mask, _mm_set1_epi8(60)), spike);
+  count += ap_bitcount(_mm_movemask_epi8(hit) & bits);
+  return _mm_add_epi8(_mm_set1_epi8(10), _mm_and_si128(hit, _mm_set1_epi8(50)));
+}
+
+// width: 16 (8 bit) or 8 (16 bit) pixels granularity
+template<typename pixel_t>
+int apPostCheckRow_SSE2(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6)
+{
+  int count = 0;
+  const auto zero = _mm_setzero_si128();
+  if constexpr (sizeof(pixel_t) == 1) {
+    const auto vAP = _mm_set1_epi16(AP);
+    const auto vminusAP = _mm_set1_epi16(-AP);
+    const auto vAP6 = _mm_set1_epi16(AP6);
+    for (int x = 0; x < width; x += 16)
+    {
+      auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstp + x));
+      auto pp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpp + x));
+      auto pn = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpn + x));
+      auto pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpa + x));
+      auto pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpb + x));
+      auto spike_lo = ap_spike_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(pp, zero), _mm_unpacklo_epi8(pn, zero),
+        _mm_unpacklo_epi8(pa, zero), _mm_unpacklo_epi8(pb, zero), vAP, vminusAP, vAP6);
+      auto spike_hi = ap_spike_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(pp, zero), _mm_unpackhi_epi8(pn, zero),
+        _mm_unpackhi_epi8(pa, zero), _mm_unpackhi_epi8(pb, zero), vAP, vminusAP, vAP6);
+      auto spike = _mm_packs_epi16(spike_lo, spike_hi);
+      auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskw + x));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(maskw + x), ap_update_mask(mask, spike, count, 0xFFFF));
+    }
+  }
+  else {
+    const auto vAP = _mm_set1_epi32(AP);
+    const auto vminusAP = _mm_set1_epi32(-AP);
+    const auto vAP6 = _mm_set1_epi32(AP6);
+    for (int x = 0; x < width; x += 8)
+    {
+      auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstp + x * 2));
+      auto pp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpp + x * 2));
+      auto pn = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpn + x * 2));
+      auto pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpa + x * 2));
+      auto pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpb + x * 2));
+      auto spike_lo = ap_spike_epi32(_mm_unpacklo_epi16(p, zero), _mm_unpacklo_epi16(pp, zero), _mm_unpacklo_epi16(pn, zero),
+        _mm_unpacklo_epi16(pa, zero), _mm_unpacklo_epi16(pb, zero), vAP, vminusAP, vAP6);
+      auto spike_hi = ap_spike_epi32(_mm_unpackhi_epi16(p, zero), _mm_unpackhi_epi16(pp, zero), _mm_unpackhi_epi16(pn, zero),
+        _mm_unpackhi_epi16(pa, zero), _mm_unpackhi_epi16(pb, zero), vAP, vminusAP, vAP6);
+      auto spike = _mm_packs_epi16(_mm_packs_epi32(spike_lo, spike_hi), zero);
+      auto mask = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(maskw + x));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(maskw + x), ap_update_mask(mask, spike, count, 0xFF));
+    }
+  }
+  return count;
+}
+
+template<typename pixel_t>
+int dispatch_apPostCheckRow(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6, int cpuFlags)
+{
+  const bool use_sse2 = (cpuFlags & CPUF_SSE2) ? true : false;
+  const bool use_avx2 = (cpuFlags & CPUF_AVX2) ? true : false;
+
+  // larger thresholds can never be exceeded, clamp them so that the lanes do not overflow
+  const int maxval = sizeof(pixel_t) == 1 ? 255 : 65535;
+  AP = std::min(AP, maxval);
+  AP6 = std::min(AP6, maxval * 6);
+
+  int x = 0;
+  int count = 0;
+  if (use_avx2) {
+    x = width & (sizeof(pixel_t) == 1 ? ~31 : ~15);
+    count = apPostCheckRow_AVX2<pixel_t>(dstp, dstpp, dstpn, dstpa, dstpb, maskw, x, AP, AP6);
+  }
+  else if (use_sse2) {
+    x = width & (sizeof(pixel_t) == 1 ? ~15 : ~7);
+    count = apPostCheckRow_SSE2<pixel_t>(dstp, dstpp, dstpn, dstpa, dstpb, maskw, x, AP, AP6);
+  }
+  return count + apPostCheckRow_c<pixel_t>(dstp, dstpp, dstpn, dstpa, dstpb, maskw, x, width, AP, AP6);
+}
+
+template int dispatch_apPostCheckRow<uint8_t>(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6, int cpuFlags);
+template int dispatch_apPostCheckRow<uint16_t>(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6, int cpuFlags);
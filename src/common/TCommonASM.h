@@ -71,6 +71,13 @@ void check_combing_SSE2_Metric1(const uint8_t *srcp, uint8_t *dstp,
 void check_combing_SSE2_Luma_Metric1(const uint8_t *srcp, uint8_t *dstp,
   int width, int height, int src_pitch, int dst_pitch, int cthreshsq);
 
+// Same masks as the two above with a cheap prefilter, cthresh is not squared here
+void check_combing_SSE2_Metric1_Cascade(const uint8_t* srcp, uint8_t* dstp,
+  int width, int height, int src_pitch, int dst_pitch, int cthresh);
+
+void check_combing_SSE2_Luma_Metric1_Cascade(const uint8_t* srcp, uint8_t* dstp,
+  int width, int height, int src_pitch, int dst_pitch, int cthresh);
+
 template<typename pixel_t>
 void buildABSDiffMask_SSE2(const uint8_t *prvp, const uint8_t *nxtp,
   uint8_t *dstp, int prv_pitch, int nxt_pitch, int dst_pitch, int width, int height);
@@ -85,7 +92,7 @@ void do_buildABSDiffMask(const uint8_t* prvp, const uint8_t* nxtp, uint8_t* tbuf
 
 template<typename pixel_t, int bits_per_pixel>
 void AnalyzeDiffMask_Planar(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer, int tpitch, int Width, int Height);
-void AnalyzeDiffMask_YUY2(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer, int tpitch, int Width, int Height, bool mChroma);
+void AnalyzeDiffMask_YUY2(uint8_t* dstp, int dst_pitch, uint8_t* tbuffer, int tpitch, int Width, int Height, bool mChroma, int cpuFlags);
 
 
 void buildABSDiffMask2_uint8_SSE2(const uint8_t *prvp, const uint8_t *nxtp,
@@ -102,11 +109,28 @@ template<typename pixel_t>
 void do_buildABSDiffMask2(const uint8_t* prvp, const uint8_t* nxtp, uint8_t* dstp,
   int prv_pitch, int nxt_pitch, int dst_pitch, int width, int height, bool YUY2_LumaOnly, int cpuFlags, int bits_per_pixel);
 
+// Counts the combed pixels of a combing mask (0xFF on the line above, the line itself and
+// the line below) on lines 1..height-2 and adds them to the four overlapping blocks of
+// cArray, which must be cleared by the caller. cmkp points to line 0. Returns the total count.
+// YUY2_LumaOnly: the mask is a YUY2 row of width bytes, only the luma (even) bytes are counted.
+int accumulateCombedBlocks(const uint8_t* cmkp, int cmk_pitch, int width, int height,
+  int xhalf, int xshift, int yhalf, int yshift, int* cArray, bool YUY2_LumaOnly, int cpuFlags);
 
-template<int blockSizeY>
-void compute_sum_8xN_sse2(const uint8_t *srcp, int pitch, int &sum);
-
-void compute_sum_16x8_sse2_luma(const uint8_t *srcp, int pitch, int &sum);
+// Builds lines [y0, y1) of the combing mask of one plane. cthresh is already scaled to
+// the bit depth. mcascade: metric 1 on 8 bit SSE2 goes through the prefiltered kernel.
+template<typename pixel_t>
+void buildCombMask(const pixel_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int y0, int y1, int cthresh, int metric, bool mcascade, int cpuFlags);
+
+// For callers which only need to know whether any block count exceeds MI.
+// Works in half block row bands and stops after the band in which the first block goes
+// above MI. With buildMask the (luma only) mask is built band by band as well, otherwise
+// it must be complete. cArray must be cleared; its counts are exact only if false is returned.
+// YUY2 masks (YUY2_LumaOnly, see accumulateCombedBlocks) cannot be built here.
+template<typename pixel_t>
+bool checkCombedBlocksMI(const pixel_t* srcp, int src_pitch, uint8_t* cmkp, int cmk_pitch, int width,
+  int height, int cthresh, int metric, bool mcascade, bool buildMask, int xhalf, int xshift, int yhalf, int yshift,
+  int* cArray, int MI, bool YUY2_LumaOnly, int cpuFlags);
 
 // fixme: put non-asm utility functions into different file
 void copyFrame(PVideoFrame& dst, PVideoFrame& src, const VideoInfo& vi, IScriptEnvironment* env);
@@ -114,9 +138,71 @@ void copyFrame(PVideoFrame& dst, PVideoFrame& src, const VideoInfo& vi, IScriptE
 template<typename pixel_t>
 void blend_5050_SSE2(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, int width, int height, int dst_pitch, int src1_pitch, int src2_pitch);
 template<typename pixel_t>
+void blend_5050_AVX2(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, int width, int height, int dst_pitch, int src1_pitch, int src2_pitch);
+template<typename pixel_t>
 void blend_5050_c(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, int width, int height, int dst_pitch, int src1_pitch, int src2_pitch);
 
 template<int planarType>
 void do_FillCombedPlanarUpdateCmaskByUV(uint8_t* cmkp, uint8_t* cmkpU, uint8_t* cmkpV, int Width, int Height, ptrdiff_t cmk_pitch, ptrdiff_t cmk_pitchUV);
 
+// Line pointers for one output line of TFM::compareFields / compareFieldsSlow and
+// TDeinterlace::subtractFields.
+// Pixel pointers are pixel_t typed data passed as bytes, map lines are always 8 bits.
+struct CompareFieldsLines {
+  const uint8_t* mapp, * mapn;
+  const uint8_t* prvpf, * prvnf;
+  const uint8_t* curpf, * curf, * curnf;
+  const uint8_t* nxtpf, * nxtnf;
+  // slow=2 only: the additional comparison on the opposite field parity
+  const uint8_t* prv2a, * prv2b, * prv2c;
+  const uint8_t* cur2a, * cur2b;
+  const uint8_t* nxt2a, * nxt2b, * nxt2c;
+  int map2shift; // map bits for the second comparison: 3 for field=0, 0 for field=1
+  // variant 3 only: thresholds of buildABSDiffMask2, scaled to the bit depth (0 for the map variants)
+  int mapConst3, mapConst19;
+};
+
+// compareFields row kernels. variant: 0: compareFields, 1: slow=1, 2: slow=2
+// 3: same as 0 but the map is not read, its flags are computed from
+// prvpf/nxtpf and prvnf/nxtnf like buildABSDiffMask2 would do.
+// accum: Pc, Nc, Pm, Nm, Pml, Nml (Pml/Nml only for variant 1 and 2)
+// They process [startx, stopx) in whole vector steps and return the x
+// where the C loop has to continue.
+// lumaOnly: YUY2 without chroma, only even x positions are counted
+using compareFieldsRow_fn_t = int(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+
+template<int variant>
+int compareFieldsRow_SSE2(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template<int variant>
+#if defined(GCC) || defined(CLANG)
+__attribute__((__target__("sse4.1")))
+#endif
+int compareFieldsRow_uint16_SSE4(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template<int variant>
+int compareFieldsRow_AVX2(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template<int variant>
+int compareFieldsRow_uint16_AVX2(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+
+// TDeint mode 2 (TDHelper)
+template<typename pixel_t>
+void subtractFrames_AVX2(const uint8_t* srcp1, int src1_pitch,
+  const uint8_t* srcp2, int src2_pitch, int height, int rowsize, int inc,
+  uint64_t& diff);
+
+// TDeint AP post check of one interpolated row, see apPostCheckRow_c
+template<typename pixel_t>
+int apPostCheckRow_AVX2(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6);
+template<typename pixel_t>
+int dispatch_apPostCheckRow(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6, int cpuFlags);
+
+template<int variant>
+compareFieldsRow_fn_t* get_compareFieldsRow_fn(int pixelsize, int cpuFlags);
+
 #endif // __TCOMMONASM_H__
@@ -0,0 +1,482 @@
+/*
+**   Helper methods for TIVTC and TDeint
+**
+**
+**   Copyright (C) 2004-2007 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+// AVX2 kernels: this file is compiled with AVX2 enabled (*_avx2.cpp pattern)
+
+#include "TCommonASM.h"
+#include <immintrin.h>
+#include <cstring>
+
+#if !defined(__AVX2__) && (defined(GCC) || defined(CLANG))
+#error This source file will only work properly when compiled with AVX2 option. Set __AVX2__ or use -mavx2
+#endif
+
+// lane is set where (eax & m) != 0
+static AVS_FORCEINLINE __m256i cf_test_epi16(__m256i eax, int m, __m256i lanes)
+{
+  return _mm256_andnot_si256(_mm256_cmpeq_epi16(_mm256_and_si256(eax, _mm256_set1_epi16(m)), _mm256_setzero_si256()), lanes);
+}
+
+static AVS_FORCEINLINE __m256i cf_test_epi32(__m256i eax, int m)
+{
+  return _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(eax, _mm256_set1_epi32(m)), _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+}
+
+static AVS_FORCEINLINE void cf_accum_epi16(__m256i& acc, __m256i diff, __m256i cond)
+{
+  acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_and_si256(diff, cond), _mm256_set1_epi16(1)));
+}
+
+static AVS_FORCEINLINE void cf_accum_epi32(__m256i& acc, __m256i diff, __m256i cond)
+{
+  acc = _mm256_add_epi32(acc, _mm256_and_si256(diff, cond));
+}
+
+static AVS_FORCEINLINE __m256i cf_load16_epi16(const uint8_t* p, int x)
+{
+  return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + x)));
+}
+
+static AVS_FORCEINLINE __m256i cf_load8_epi32(const uint8_t* p, int x)
+{
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(reinterpret_cast<const uint16_t*>(p) + x)));
+}
+
+static AVS_FORCEINLINE __m256i cf_loadmap8_epi32(const uint8_t* p, int x)
+{
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + x)));
+}
+
+// sum of the eight unsigned 32 bit lanes
+static AVS_FORCEINLINE uint64_t cf_hsum_epu32(__m256i v)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sum = _mm256_add_epi64(_mm256_unpacklo_epi32(v, zero), _mm256_unpackhi_epi32(v, zero));
+  __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_add_epi64(sum128, _mm_srli_si128(sum128, 8));
+  uint64_t result;
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&result), sum128);
+  return result;
+}
+
+// see compareFieldsRow_SSE2
+template<int variant>
+int compareFieldsRow_AVX2(const CompareFieldsLines& l, int startx, int stopx,
+  bool lumaOnly, int Const23, int Const42, uint64_t* accum)
+{
+  constexpr int mapshift = variant == 0 ? 2 : 3;
+  constexpr int maskC = variant == 0 ? 0xFF : 9;
+  constexpr int maskM = variant == 0 ? 10 : 18;
+  constexpr int maskML = 36;
+
+  const __m256i lanes = lumaOnly ? _mm256_set1_epi32(0x0000FFFF) : _mm256_set1_epi16(-1);
+  const __m256i c23 = _mm256_set1_epi16(Const23);
+  const __m256i c42 = _mm256_set1_epi16(Const42);
+  const __m256i mc3 = _mm256_set1_epi16(l.mapConst3);
+  const __m256i mc19 = _mm256_set1_epi16(l.mapConst19);
+  const __m128i map2shift = _mm_cvtsi32_si128(l.map2shift);
+
+  __m256i sumPc = _mm256_setzero_si256();
+  __m256i sumNc = _mm256_setzero_si256();
+  __m256i sumPm = _mm256_setzero_si256();
+  __m256i sumNm = _mm256_setzero_si256();
+  __m256i sumPml = _mm256_setzero_si256();
+  __m256i sumNml = _mm256_setzero_si256();
+
+  int x = startx;
+  for (; x + 16 <= stopx; x += 16)
+  {
+    const __m256i prvpf = cf_load16_epi16(l.prvpf, x);
+    const __m256i prvnf = cf_load16_epi16(l.prvnf, x);
+    const __m256i nxtpf = cf_load16_epi16(l.nxtpf, x);
+    const __m256i nxtnf = cf_load16_epi16(l.nxtnf, x);
+
+    __m256i eax, condC, condM;
+    if constexpr (variant == 3) {
+      const __m256i dp = _mm256_abs_epi16(_mm256_sub_epi16(prvpf, nxtpf));
+      const __m256i dn = _mm256_abs_epi16(_mm256_sub_epi16(prvnf, nxtnf));
+      condC = _mm256_and_si256(_mm256_or_si256(_mm256_cmpgt_epi16(dp, mc3), _mm256_cmpgt_epi16(dn, mc3)), lanes);
+      condM = _mm256_and_si256(_mm256_or_si256(_mm256_cmpgt_epi16(dp, mc19), _mm256_cmpgt_epi16(dn, mc19)), lanes);
+    }
+    else {
+      eax = _mm256_add_epi16(_mm256_slli_epi16(cf_load16_epi16(l.mapp, x), mapshift), cf_load16_epi16(l.mapn, x));
+      condC = cf_test_epi16(eax, maskC, lanes);
+      condM = cf_test_epi16(eax, maskM, lanes);
+    }
+
+    const __m256i a_curr = _mm256_add_epi16(_mm256_add_epi16(cf_load16_epi16(l.curpf, x), cf_load16_epi16(l.curnf, x)), _mm256_slli_epi16(cf_load16_epi16(l.curf, x), 2));
+    const __m256i prv = _mm256_add_epi16(prvpf, prvnf);
+    const __m256i nxt = _mm256_add_epi16(nxtpf, nxtnf);
+    const __m256i a_prev = _mm256_add_epi16(prv, _mm256_add_epi16(prv, prv));
+    const __m256i a_next = _mm256_add_epi16(nxt, _mm256_add_epi16(nxt, nxt));
+
+    const __m256i diff_p_c = _mm256_abs_epi16(_mm256_sub_epi16(a_prev, a_curr));
+    const __m256i diff_n_c = _mm256_abs_epi16(_mm256_sub_epi16(a_next, a_curr));
+    const __m256i p42 = _mm256_cmpgt_epi16(diff_p_c, c42);
+    const __m256i n42 = _mm256_cmpgt_epi16(diff_n_c, c42);
+
+    cf_accum_epi16(sumPc, diff_p_c, _mm256_and_si256(_mm256_cmpgt_epi16(diff_p_c, c23), condC));
+    cf_accum_epi16(sumNc, diff_n_c, _mm256_and_si256(_mm256_cmpgt_epi16(diff_n_c, c23), condC));
+    cf_accum_epi16(sumPm, diff_p_c, _mm256_and_si256(p42, condM));
+    cf_accum_epi16(sumNm, diff_n_c, _mm256_and_si256(n42, condM));
+    if constexpr (variant == 1 || variant == 2) {
+      const __m256i condML = cf_test_epi16(eax, maskML, lanes);
+      cf_accum_epi16(sumPml, diff_p_c, _mm256_and_si256(p42, condML));
+      cf_accum_epi16(sumNml, diff_n_c, _mm256_and_si256(n42, condML));
+    }
+    if constexpr (variant == 2) {
+      const __m256i eax2 = _mm256_srl_epi16(eax, map2shift);
+      const __m256i cond1 = cf_test_epi16(eax2, 1, lanes);
+      const __m256i cond2 = cf_test_epi16(eax2, 2, lanes);
+      const __m256i cond4 = cf_test_epi16(eax2, 4, lanes);
+
+      const __m256i cur2 = _mm256_add_epi16(cf_load16_epi16(l.cur2a, x), cf_load16_epi16(l.cur2b, x));
+      const __m256i a_curr2 = _mm256_add_epi16(cur2, _mm256_add_epi16(cur2, cur2));
+      const __m256i a_prev2 = _mm256_add_epi16(_mm256_add_epi16(cf_load16_epi16(l.prv2a, x), cf_load16_epi16(l.prv2c, x)), _mm256_slli_epi16(cf_load16_epi16(l.prv2b, x), 2));
+      const __m256i a_next2 = _mm256_add_epi16(_mm256_add_epi16(cf_load16_epi16(l.nxt2a, x), cf_load16_epi16(l.nxt2c, x)), _mm256_slli_epi16(cf_load16_epi16(l.nxt2b, x), 2));
+
+      const __m256i diff_p_c2 = _mm256_abs_epi16(_mm256_sub_epi16(a_prev2, a_curr2));
+      const __m256i diff_n_c2 = _mm256_abs_epi16(_mm256_sub_epi16(a_next2, a_curr2));
+      const __m256i p42_2 = _mm256_cmpgt_epi16(diff_p_c2, c42);
+      const __m256i n42_2 = _mm256_cmpgt_epi16(diff_n_c2, c42);
+
+      cf_accum_epi16(sumPc, diff_p_c2, _mm256_and_si256(_mm256_cmpgt_epi16(diff_p_c2, c23), cond1));
+      cf_accum_epi16(sumNc, diff_n_c2, _mm256_and_si256(_mm256_cmpgt_epi16(diff_n_c2, c23), cond1));
+      cf_accum_epi16(sumPm, diff_p_c2, _mm256_and_si256(p42_2, cond2));
+      cf_accum_epi16(sumNm, diff_n_c2, _mm256_and_si256(n42_2, cond2));
+      cf_accum_epi16(sumPml, diff_p_c2, _mm256_and_si256(p42_2, cond4));
+      cf_accum_epi16(sumNml, diff_n_c2, _mm256_and_si256(n42_2, cond4));
+    }
+  }
+
+  accum[0] += cf_hsum_epu32(sumPc);
+  accum[1] += cf_hsum_epu32(sumNc);
+  accum[2] += cf_hsum_epu32(sumPm);
+  accum[3] += cf_hsum_epu32(sumNm);
+  if constexpr (variant == 1 || variant == 2) {
+    accum[4] += cf_hsum_epu32(sumPml);
+    accum[5] += cf_hsum_epu32(sumNml);
+  }
+  _mm256_zeroupper();
+  return x;
+}
+
+template<int variant>
+int compareFieldsRow_uint16_AVX2(const CompareFieldsLines& l, int startx, int stopx,
+  bool /*lumaOnly*/, int Const23, int Const42, uint64_t* accum)
+{
+  constexpr int mapshift = variant == 0 ? 2 : 3;
+  constexpr int maskC = variant == 0 ? 0xFF : 9;
+  constexpr int maskM = variant == 0 ? 10 : 18;
+  constexpr int maskML = 36;
+
+  const __m256i c23 = _mm256_set1_epi32(Const23);
+  const __m256i c42 = _mm256_set1_epi32(Const42);
+  const __m256i mc3 = _mm256_set1_epi32(l.mapConst3);
+  const __m256i mc19 = _mm256_set1_epi32(l.mapConst19);
+  const __m128i map2shift = _mm_cvtsi32_si128(l.map2shift);
+
+  __m256i sumPc = _mm256_setzero_si256();
+  __m256i sumNc = _mm256_setzero_si256();
+  __m256i sumPm = _mm256_setzero_si256();
+  __m256i sumNm = _mm256_setzero_si256();
+  __m256i sumPml = _mm256_setzero_si256();
+  __m256i sumNml = _mm256_setzero_si256();
+
+  int x = startx;
+  for (; x + 8 <= stopx; x += 8)
+  {
+    const __m256i prvpf = cf_load8_epi32(l.prvpf, x);
+    const __m256i prvnf = cf_load8_epi32(l.prvnf, x);
+    const __m256i nxtpf = cf_load8_epi32(l.nxtpf, x);
+    const __m256i nxtnf = cf_load8_epi32(l.nxtnf, x);
+
+    __m256i eax, condC, condM;
+    if constexpr (variant == 3) {
+      const __m256i dp = _mm256_abs_epi32(_mm256_sub_epi32(prvpf, nxtpf));
+      const __m256i dn = _mm256_abs_epi32(_mm256_sub_epi32(prvnf, nxtnf));
+      condC = _mm256_or_si256(_mm256_cmpgt_epi32(dp, mc3), _mm256_cmpgt_epi32(dn, mc3));
+      condM = _mm256_or_si256(_mm256_cmpgt_epi32(dp, mc19), _mm256_cmpgt_epi32(dn, mc19));
+    }
+    else {
+      eax = _mm256_add_epi32(_mm256_slli_epi32(cf_loadmap8_epi32(l.mapp, x), mapshift), cf_loadmap8_epi32(l.mapn, x));
+      condC = cf_test_epi32(eax, maskC);
+      condM = cf_test_epi32(eax, maskM);
+    }
+
+    const __m256i a_curr = _mm256_add_epi32(_mm256_add_epi32(cf_load8_epi32(l.curpf, x), cf_load8_epi32(l.curnf, x)), _mm256_slli_epi32(cf_load8_epi32(l.curf, x), 2));
+    const __m256i prv = _mm256_add_epi32(prvpf, prvnf);
+    const __m256i nxt = _mm256_add_epi32(nxtpf, nxtnf);
+    const __m256i a_prev = _mm256_add_epi32(prv, _mm256_add_epi32(prv, prv));
+    const __m256i a_next = _mm256_add_epi32(nxt, _mm256_add_epi32(nxt, nxt));
+
+    const __m256i diff_p_c = _mm256_abs_epi32(_mm256_sub_epi32(a_prev, a_curr));
+    const __m256i diff_n_c = _mm256_abs_epi32(_mm256_sub_epi32(a_next, a_curr));
+    const __m256i p42 = _mm256_cmpgt_epi32(diff_p_c, c42);
+    const __m256i n42 = _mm256_cmpgt_epi32(diff_n_c, c42);
+
+    cf_accum_epi32(sumPc, diff_p_c, _mm256_and_si256(_mm256_cmpgt_epi32(diff_p_c, c23), condC));
+    cf_accum_epi32(sumNc, diff_n_c, _mm256_and_si256(_mm256_cmpgt_epi32(diff_n_c, c23), condC));
+    cf_accum_epi32(sumPm, diff_p_c, _mm256_and_si256(p42, condM));
+    cf_accum_epi32(sumNm, diff_n_c, _mm256_and_si256(n42, condM));
+    if constexpr (variant == 1 || variant == 2) {
+      const __m256i condML = cf_test_epi32(eax, maskML);
+      cf_accum_epi32(sumPml, diff_p_c, _mm256_and_si256(p42, condML));
+      cf_accum_epi32(sumNml, diff_n_c, _mm256_and_si256(n42, condML));
+    }
+    if constexpr (variant == 2) {
+      const __m256i eax2 = _mm256_srl_epi32(eax, map2shift);
+      const __m256i cond1 = cf_test_epi32(eax2, 1);
+      const __m256i cond2 = cf_test_epi32(eax2, 2);
+      const __m256i cond4 = cf_test_epi32(eax2, 4);
+
+      const __m256i cur2 = _mm256_add_epi32(cf_load8_epi32(l.cur2a, x), cf_load8_epi32(l.cur2b, x));
+      const __m256i a_curr2 = _mm256_add_epi32(cur2, _mm256_add_epi32(cur2, cur2));
+      const __m256i a_prev2 = _mm256_add_epi32(_mm256_add_epi32(cf_load8_epi32(l.prv2a, x), cf_load8_epi32(l.prv2c, x)), _mm256_slli_epi32(cf_load8_epi32(l.prv2b, x), 2));
+      const __m256i a_next2 = _mm256_add_epi32(_mm256_add_epi32(cf_load8_epi32(l.nxt2a, x), cf_load8_epi32(l.nxt2c, x)), _mm256_slli_epi32(cf_load8_epi32(l.nxt2b, x), 2));
+
+      const __m256i diff_p_c2 = _mm256_abs_epi32(_mm256_sub_epi32(a_prev2, a_curr2));
+      const __m256i diff_n_c2 = _mm256_abs_epi32(_mm256_sub_epi32(a_next2, a_curr2));
+      const __m256i p42_2 = _mm256_cmpgt_epi32(diff_p_c2, c42);
+      const __m256i n42_2 = _mm256_cmpgt_epi32(diff_n_c2, c42);
+
+      cf_accum_epi32(sumPc, diff_p_c2, _mm256_and_si256(_mm256_cmpgt_epi32(diff_p_c2, c23), cond1));
+      cf_accum_epi32(sumNc, diff_n_c2, _mm256_and_si256(_mm256_cmpgt_epi32(diff_n_c2, c23), cond1));
+      cf_accum_epi32(sumPm, diff_p_c2, _mm256_and_si256(p42_2, cond2));
+      cf_accum_epi32(sumNm, diff_n_c2, _mm256_and_si256(n42_2, cond2));
+      cf_accum_epi32(sumPml, diff_p_c2, _mm256_and_si256(p42_2, cond4));
+      cf_accum_epi32(sumNml, diff_n_c2, _mm256_and_si256(n42_2, cond4));
+    }
+  }
+
+  accum[0] += cf_hsum_epu32(sumPc);
+  accum[1] += cf_hsum_epu32(sumNc);
+  accum[2] += cf_hsum_epu32(sumPm);
+  accum[3] += cf_hsum_epu32(sumNm);
+  if constexpr (variant == 1 || variant == 2) {
+    accum[4] += cf_hsum_epu32(sumPml);
+    accum[5] += cf_hsum_epu32(sumNml);
+  }
+  _mm256_zeroupper();
+  return x;
+}
+
+template int compareFieldsRow_AVX2<0>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_AVX2<1>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_AVX2<2>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_AVX2<3>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_uint16_AVX2<0>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_uint16_AVX2<1>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_uint16_AVX2<2>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+template int compareFieldsRow_uint16_AVX2<3>(const CompareFieldsLines& l, int startx, int stopx, bool lumaOnly, int Const23, int Const42, uint64_t* accum);
+
+// fast blend routine for 50:50 case, see blend_5050_SSE2
+template<typename pixel_t>
+void blend_5050_AVX2(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, int width, int height, int dst_pitch, int src1_pitch, int src2_pitch)
+{
+  const int rowsize = width * sizeof(pixel_t);
+  const int rowsize_avx2 = rowsize & ~31;
+  while (height--) {
+    int x = 0;
+    for (; x < rowsize_avx2; x += 32) {
+      auto src1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcp1 + x));
+      auto src2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcp2 + x));
+      if constexpr (sizeof(pixel_t) == 1)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstp + x), _mm256_avg_epu8(src1, src2));
+      else
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstp + x), _mm256_avg_epu16(src1, src2));
+    }
+    // rest like the SSE2 version, overworking to 16 bytes
+    for (; x < rowsize; x += 16) {
+      auto src1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcp1 + x));
+      auto src2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcp2 + x));
+      if constexpr (sizeof(pixel_t) == 1)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x), _mm_avg_epu8(src1, src2));
+      else
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x), _mm_avg_epu16(src1, src2));
+    }
+    dstp += dst_pitch;
+    srcp1 += src1_pitch;
+    srcp2 += src2_pitch;
+  }
+  _mm256_zeroupper();
+}
+// instantiate
+template void blend_5050_AVX2<uint8_t>(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, int width, int height, int dst_pitch, int src1_pitch, int src2_pitch);
+template void blend_5050_AVX2<uint16_t>(uint8_t* dstp, const uint8_t* srcp1, const uint8_t* srcp2, int width, int height, int dst_pitch, int src1_pitch, int src2_pitch);
+
+// Sum of absolute differences of two frames (TDeint mode 2), see subtractFrames_SSE2.
+// inc: 2 (YUY2 lumaonly chroma skip) or 1 (planar)
+template<typename pixel_t>
+void subtractFrames_AVX2(const uint8_t* srcp1, int src1_pitch,
+  const uint8_t* srcp2, int src2_pitch, int height, int rowsize, int inc,
+  uint64_t& diff)
+{
+  const int rowsize_avx2 = rowsize & ~31;
+  const auto zero = _mm256_setzero_si256();
+  const __m256i lumaMask = _mm256_set1_epi16(0x00FF);
+  auto sum = _mm256_setzero_si256(); // 4x64 bits
+  for (int y = 0; y < height; ++y)
+  {
+    if constexpr (sizeof(pixel_t) == 1) {
+      for (int x = 0; x < rowsize_avx2; x += 32)
+      {
+        auto src1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcp1 + x));
+        auto src2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcp2 + x));
+        if (inc == 2) {
+          src1 = _mm256_and_si256(src1, lumaMask);
+          src2 = _mm256_and_si256(src2, lumaMask);
+        }
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(src1, src2));
+      }
+    }
+    else {
+      // 32 bit lanes are enough for a row, moved to 64 bits after each row
+      auto rowsum = _mm256_setzero_si256();
+      for (int x = 0; x < rowsize_avx2; x += 32)
+      {
+        auto src1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcp1 + x));
+        auto src2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcp2 + x));
+        auto absdiff = _mm256_or_si256(_mm256_subs_epu16(src1, src2), _mm256_subs_epu16(src2, src1));
+        rowsum = _mm256_add_epi32(rowsum, _mm256_unpacklo_epi16(absdiff, zero));
+        rowsum = _mm256_add_epi32(rowsum, _mm256_unpackhi_epi16(absdiff, zero));
+      }
+      sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(rowsum, zero));
+      sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(rowsum, zero));
+    }
+    for (int x = rowsize_avx2 / sizeof(pixel_t); x < rowsize / (int)sizeof(pixel_t); x += inc)
+      diff += abs(reinterpret_cast<const pixel_t*>(srcp1)[x] - reinterpret_cast<const pixel_t*>(srcp2)[x]);
+    srcp1 += src1_pitch;
+    srcp2 += src2_pitch;
+  }
+  __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_add_epi64(sum128, _mm_srli_si128(sum128, 8));
+  uint64_t total;
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&total), sum128);
+  diff += total;
+  _mm256_zeroupper();
+}
+// instantiate
+template void subtractFrames_AVX2<uint8_t>(const uint8_t* srcp1, int src1_pitch, const uint8_t* srcp2, int src2_pitch, int height, int rowsize, int inc, uint64_t& diff);
+template void subtractFrames_AVX2<uint16_t>(const uint8_t* srcp1, int src1_pitch, const uint8_t* srcp2, int src2_pitch, int height, int rowsize, int inc, uint64_t& diff);
+
+// TDeint AP post check, see apPostCheckRow_SSE2
+static AVS_FORCEINLINE __m256i ap_spike_epi16(__m256i p, __m256i pp, __m256i pn, __m256i pa, __m256i pb,
+  __m256i AP, __m256i minusAP, __m256i AP6)
+{
+  auto sFirst = _mm256_sub_epi16(p, pp);
+  auto sSecond = _mm256_sub_epi16(p, pn);
+  auto above = _mm256_and_si256(_mm256_cmpgt_epi16(sFirst, AP), _mm256_cmpgt_epi16(sSecond, AP));
+  auto below = _mm256_and_si256(_mm256_cmpgt_epi16(minusAP, sFirst), _mm256_cmpgt_epi16(minusAP, sSecond));
+  auto pp_pn = _mm256_add_epi16(pp, pn);
+  auto e = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(pa, pb), _mm256_slli_epi16(p, 2)),
+    _mm256_add_epi16(pp_pn, _mm256_add_epi16(pp_pn, pp_pn)));
+  return _mm256_and_si256(_mm256_or_si256(above, below), _mm256_cmpgt_epi16(_mm256_abs_epi16(e), AP6));
+}
+
+static AVS_FORCEINLINE __m256i ap_spike_epi32(__m256i p, __m256i pp, __m256i pn, __m256i pa, __m256i pb,
+  __m256i AP, __m256i minusAP, __m256i AP6)
+{
+  auto sFirst = _mm256_sub_epi32(p, pp);
+  auto sSecond = _mm256_sub_epi32(p, pn);
+  auto above = _mm256_and_si256(_mm256_cmpgt_epi32(sFirst, AP), _mm256_cmpgt_epi32(sSecond, AP));
+  auto below = _mm256_and_si256(_mm256_cmpgt_epi32(minusAP, sFirst), _mm256_cmpgt_epi32(minusAP, sSecond));
+  auto pp_pn = _mm256_add_epi32(pp, pn);
+  auto e = _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(pa, pb), _mm256_slli_epi32(p, 2)),
+    _mm256_add_epi32(pp_pn, _mm256_add_epi32(pp_pn, pp_pn)));
+  return _mm256_and_si256(_mm256_or_si256(above, below), _mm256_cmpgt_epi32(_mm256_abs_epi32(e), AP6));
+}
+
+static AVS_FORCEINLINE int ap_bitcount(unsigned int m)
+{
+  int c = 0;
+  for (; m; m &= m - 1) ++c;
+  return c;
+}
+
+// width: 32 (8 bit) or 16 (16 bit) pixels granularity
+template<typename pixel_t>
+int apPostCheckRow_AVX2(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6)
+{
+  int count = 0;
+  const auto Const60 = _mm256_set1_epi8(60);
+  const auto Const10 = _mm256_set1_epi8(10);
+  const auto Const50 = _mm256_set1_epi8(50);
+  if constexpr (sizeof(pixel_t) == 1) {
+    const auto vAP = _mm256_set1_epi16(AP);
+    const auto vminusAP = _mm256_set1_epi16(-AP);
+    const auto vAP6 = _mm256_set1_epi16(AP6);
+    for (int x = 0; x < width; x += 32)
+    {
+      __m256i spike[2];
+      for (int h = 0; h < 2; ++h) {
+        const int xx = x + h * 16;
+        spike[h] = ap_spike_epi16(
+          _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstp + xx))),
+          _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpp + xx))),
+          _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpn + xx))),
+          _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpa + xx))),
+          _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpb + xx))),
+          vAP, vminusAP, vAP6);
+      }
+      // packs works per 128 bit lane, restore pixel order
+      auto spikes = _mm256_permute4x64_epi64(_mm256_packs_epi16(spike[0], spike[1]), 0xD8);
+      auto mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(maskw + x));
+      auto hit = _mm256_andnot_si256(_mm256_cmpeq_epi8(mask, Const60), spikes);
+      count += ap_bitcount((unsigned int)_mm256_movemask_epi8(hit));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(maskw + x), _mm256_add_epi8(Const10, _mm256_and_si256(hit, Const50)));
+    }
+  }
+  else {
+    const auto vAP = _mm256_set1_epi32(AP);
+    const auto vminusAP = _mm256_set1_epi32(-AP);
+    const auto vAP6 = _mm256_set1_epi32(AP6);
+    for (int x = 0; x < width; x += 16)
+    {
+      __m256i spike[2];
+      for (int h = 0; h < 2; ++h) {
+        const int xx = (x + h * 8) * 2;
+        spike[h] = ap_spike_epi32(
+          _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstp + xx))),
+          _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpp + xx))),
+          _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpn + xx))),
+          _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpa + xx))),
+          _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dstpb + xx))),
+          vAP, vminusAP, vAP6);
+      }
+      auto spikes16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(spike[0], spike[1]), 0xD8);
+      auto spikes = _mm_packs_epi16(_mm256_castsi256_si128(spikes16), _mm256_extracti128_si256(spikes16, 1));
+      auto mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(maskw + x));
+      auto hit = _mm_andnot_si128(_mm_cmpeq_epi8(mask, _mm256_castsi256_si128(Const60)), spikes);
+      count += ap_bitcount((unsigned int)_mm_movemask_epi8(hit));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(maskw + x),
+        _mm_add_epi8(_mm256_castsi256_si128(Const10), _mm_and_si128(hit, _mm256_castsi256_si128(Const50))));
+    }
+  }
+  _mm256_zeroupper();
+  return count;
+}
+
+template int apPostCheckRow_AVX2<uint8_t>(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6);
+template int apPostCheckRow_AVX2<uint16_t>(const uint8_t* dstp, const uint8_t* dstpp, const uint8_t* dstpn, const uint8_t* dstpa,
+  const uint8_t* dstpb, uint8_t* maskw, int width, int AP, int AP6);
@@ -0,0 +1,138 @@
+/*
+**   Helper methods for TIVTC and TDeint
+**
+**
+**   Copyright (C) 2004-2007 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __ANALYSISOUT_H__
+#define __ANALYSISOUT_H__
+
+// Binary per-frame analysis output of TFM and TDeint (analysis parameter).
+// The file is an AnalysisFileHeader followed by one AnalysisRecord per
+// GetFrame call, in request order, native byte order (little endian on x86).
+// No avisynth dependency: "Analysis Reader" includes this file as well.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+constexpr char ANALYSIS_MAGIC[8] = { 'T', 'I', 'V', 'T', 'C', 'A', 'N', 'L' };
+constexpr uint32_t ANALYSIS_VERSION = 1;
+
+enum { ANALYSIS_TFM = 0, ANALYSIS_TDEINT = 1 };
+
+struct AnalysisFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;
+};
+
+// -1 in any field: not computed for this frame
+struct AnalysisRecord
+{
+  int32_t frame;
+  uint8_t filter;  // ANALYSIS_TFM or ANALYSIS_TDEINT
+  int8_t field;    // field in effect, same meaning as the field parameter of the filter
+  int8_t match;    // TFM: 0-4 = p,c,n,b,u. TDeint: getMatch() result (tryWeave/type 2/mtnmode > 1)
+  int8_t combed;   // TFM: 0 clean, 1 forced clean, 2 combed, 5 forced combed. TDeint: 1 deinterlaced, 0 not
+  int32_t mics[5]; // TFM: MIC of the p,c,n,b,u matches. TDeint: [0] source frame (full=false), [1] tryWeave frame
+  int32_t counts[4]; // motion pixel counts. TFM: norm c, norm p/n, mtn c, mtn p/n of the field compare.
+                     // TDeint: accumPn, accumNn, accumPm, accumNm
+};
+static_assert(sizeof(AnalysisRecord) == 44, "AnalysisRecord layout");
+
+static inline AnalysisRecord emptyAnalysisRecord(int filter, int frame)
+{
+  AnalysisRecord rec;
+  memset(&rec, 0xFF, sizeof(rec));
+  rec.filter = (uint8_t)filter;
+  rec.frame = frame;
+  return rec;
+}
+
+// Collects the records and writes them in blocks. Filters using it are
+// MT_SERIALIZED, there is no locking. After a failed write no more records are
+// written; close() reports it, once.
+class AnalysisWriter
+{
+  FILE* f = nullptr;
+  bool failed = false;
+  std::vector<AnalysisRecord> buffer;
+  static constexpr size_t BUFFER_RECORDS = 4096;
+
+public:
+  AnalysisWriter() = default;
+  AnalysisWriter(const AnalysisWriter&) = delete;
+  AnalysisWriter& operator=(const AnalysisWriter&) = delete;
+  ~AnalysisWriter() { close(); }
+
+  // false if the file cannot be created or its header cannot be written
+  bool open(const char* filename)
+  {
+    if ((f = fopen(filename, "wb")) == nullptr)
+      return false;
+    AnalysisFileHeader header;
+    memcpy(header.magic, ANALYSIS_MAGIC, sizeof(header.magic));
+    header.version = ANALYSIS_VERSION;
+    header.record_size = sizeof(AnalysisRecord);
+    if (fwrite(&header, sizeof(header), 1, f) != 1)
+    {
+      fclose(f);
+      f = nullptr;
+      return false;
+    }
+    buffer.reserve(BUFFER_RECORDS);
+    return true;
+  }
+
+  bool enabled() const { return f != nullptr; }
+
+  void write(const AnalysisRecord& rec)
+  {
+    if (failed)
+      return;
+    buffer.push_back(rec);
+    if (buffer.size() >= BUFFER_RECORDS)
+      flush();
+  }
+
+  void flush()
+  {
+    if (!failed && !buffer.empty() &&
+      fwrite(buffer.data(), sizeof(AnalysisRecord), buffer.size(), f) != buffer.size())
+      failed = true;
+    buffer.clear();
+  }
+
+  // Writes the buffered records and closes the file. Returns false, only on the
+  // call that closes the file, if any record could not be written.
+  bool close()
+  {
+    if (!f)
+      return true;
+    flush();
+    if (fclose(f) != 0)
+      failed = true;
+    f = nullptr;
+    return !failed;
+  }
+};
+
+#endif // __ANALYSISOUT_H__
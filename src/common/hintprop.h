@@ -0,0 +1,73 @@
+/*
+**   Helper methods for TIVTC and TDeint
+**
+**
+**   Copyright (C) 2004-2007 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __HINTPROP_H__
+#define __HINTPROP_H__
+
+#include "internal.h"
+
+// TIVTC hints are stored in the LSBs of the first 64 luma pixels (32 bit magic
+// number 0xdeadfeed, then the 32 bit hint). A frame that is passed through by
+// reference cannot be written, so it carries the same hint word in this frame
+// property instead. Readers check the property first, writers of pixel hints
+// clear it. Needs the v8 interface, callers check has_at_least_v8.
+constexpr const char* HINT_PROP = "TIVTC_Hint";
+
+static inline bool getPropHint(const PVideoFrame& frame, unsigned int& hint, IScriptEnvironment* env)
+{
+  int error;
+  const int64_t h = env->propGetInt(env->getFramePropsRO(frame), HINT_PROP, 0, &error);
+  if (error)
+    return false;
+  hint = (unsigned int)h;
+  return true;
+}
+
+// frame must own its properties (fresh frame or from shareFrame)
+static inline void setPropHint(PVideoFrame& frame, unsigned int hint, IScriptEnvironment* env)
+{
+  env->propSetInt(env->getFramePropsRW(frame), HINT_PROP, hint, AVSPropAppendMode::PROPAPPENDMODE_REPLACE);
+}
+
+static inline void clearPropHint(PVideoFrame& frame, IScriptEnvironment* env)
+{
+  env->propDeleteKey(env->getFramePropsRW(frame), HINT_PROP);
+}
+
+// New frame object over the buffer of src with its own copy of src's
+// properties: the properties can be changed without touching src and
+// without copying any pixels. The result is not writable.
+static inline PVideoFrame shareFrame(const PVideoFrame& src, const VideoInfo& vi, IScriptEnvironment* env)
+{
+  PVideoFrame dst;
+  if (!vi.IsPlanar() || vi.IsY())
+    dst = env->Subframe(src, 0, src->GetPitch(), src->GetRowSize(), src->GetHeight());
+  else if (vi.IsYUVA() || vi.IsPlanarRGBA())
+    dst = env->SubframePlanarA(src, 0, src->GetPitch(), src->GetRowSize(), src->GetHeight(),
+      0, 0, src->GetPitch(PLANAR_U), 0);
+  else
+    dst = env->SubframePlanar(src, 0, src->GetPitch(), src->GetRowSize(), src->GetHeight(),
+      0, 0, src->GetPitch(PLANAR_U));
+  env->copyFrameProps(src, dst);
+  return dst;
+}
+
+#endif // __HINTPROP_H__
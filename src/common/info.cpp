@@ -157,7 +157,7 @@ void BitmapFont::generateOutline(uint16_t* outlined, int fontindex) const
 }
 
 // helper function for remapping a wchar_t string to font index entry list
-std::vector<int> BitmapFont::remap(const std::wstring& ws)
+std::vector<int> BitmapFont::remap(const std::wstring& ws) const
 {
   // new vector with characters remapped to table indexes
   std::vector<int> s_remapped;
@@ -172,6 +172,20 @@ std::vector<int> BitmapFont::remap(const std::wstring& ws)
   return s_remapped;
 }
 
+// ASCII fast path, skips the wide string conversion and the hash lookups.
+// Returns false if s has non-ASCII characters.
+bool BitmapFont::remapAscii(const char* s, std::vector<int>& s_remapped) const
+{
+  s_remapped.clear();
+  for (; *s; ++s) {
+    const unsigned char c = (unsigned char)*s;
+    if (c >= 128)
+      return false;
+    s_remapped.push_back(asciiReMap[c]);
+  }
+  return true;
+}
+
 typedef struct CharInfo { // STARTCHAR charname
   std::string friendly_name;
   uint16_t encoding;
@@ -437,7 +451,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
   // define pixel_t as uint8_t, uint16_t or float, based on bits_per_pixel
   typedef typename std::conditional<bits_per_pixel == 8, uint8_t, typename std::conditional < bits_per_pixel <= 16, uint16_t, float > ::type >::type pixel_t;
 
-  std::vector<uint16_t> current_outlined_char(bmfont->height);
+  const uint16_t* current_outlined_char = nullptr; // precomputed halo rows of the current glyph
   const uint16_t* fonts = bmfont->font_bitmaps.data();
   const int FONT_WIDTH = bmfont->width;
   const int FONT_HEIGHT = bmfont->height;
@@ -529,7 +543,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
       fontline = fonts[num * FONT_HEIGHT + ty] << xstart; // shift some pixels if leftmost is chopped
 
       if (useHalocolor) {
-        bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+        current_outlined_char = bmfont->outline(num);
         fontoutline = current_outlined_char[ty] << xstart; // shift some pixels if leftmost is chopped
       }
 
@@ -556,7 +570,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
         {
           num = s[i + 1];
           if (useHalocolor) {
-            bmfont->generateOutline(current_outlined_char.data(), num);
+            current_outlined_char = bmfont->outline(num);
             fontoutline = current_outlined_char[ty]; // shift some pixels if leftmost is chopped
           }
           fontline = fonts[num * FONT_HEIGHT + ty];
@@ -614,7 +628,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
     // Or in vertical subsampling of glyph
     for (int m = 0; m < ySubS; m++) fontline |= fonts[num * FONT_HEIGHT + ty + m];
     if (useHalocolor) {
-      bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+      current_outlined_char = bmfont->outline(num);
       for (int m = 0; m < ySubS; m++) fontoutline |= current_outlined_char[ty + m];
     }
     //             AAAAAAAAAA000000
@@ -630,7 +644,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
       // Or in vertical subsampling of 2nd glyph
       for (int m = 0; m < ySubS; m++) fontline |= fonts[num * FONT_HEIGHT + ty + m];
       if (useHalocolor) {
-        bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+        current_outlined_char = bmfont->outline(num);
         for (int m = 0; m < ySubS; m++) fontoutline |= current_outlined_char[ty + m];
       }
     }
@@ -679,7 +693,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
         fontline <<= FONT_WIDTH;
 
         if (useHalocolor) {
-          bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+          current_outlined_char = bmfont->outline(num);
           for (int m = 0; m < ySubS; m++) fontoutline |= current_outlined_char[ty + m];
           fontoutline <<= FONT_WIDTH;
         }
@@ -689,7 +703,7 @@ void do_DrawStringPlanar(const int width, const int height, BYTE **dstps, int *p
           for (int m = 0; m < ySubS; m++) fontline |= fonts[num * FONT_HEIGHT + ty + m];
 
           if (useHalocolor) {
-            bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+            current_outlined_char = bmfont->outline(num);
             for (int m = 0; m < ySubS; m++) fontoutline |= current_outlined_char[ty + m];
           }
         }
@@ -721,7 +735,7 @@ static void do_DrawStringYUY2(const int width, const int height, BYTE* _dstp, in
 {
   // fixedFontRec_t current_outlined_char;
 
-  std::vector<uint16_t> current_outlined_char(bmfont->height);
+  const uint16_t* current_outlined_char = nullptr; // precomputed halo rows of the current glyph
   const uint16_t *fonts = bmfont->font_bitmaps.data();
   const int FONT_WIDTH = bmfont->width;
   const int FONT_HEIGHT = bmfont->height;
@@ -761,7 +775,7 @@ static void do_DrawStringYUY2(const int width, const int height, BYTE* _dstp, in
     fontline = fonts[num * FONT_HEIGHT + ty] << xstart; // shift some pixels if leftmost is chopped
 
     if (useHalocolor) {
-      bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+      current_outlined_char = bmfont->outline(num);
       fontoutline = current_outlined_char[ty] << xstart; // shift some pixels if leftmost is chopped
     }
 
@@ -787,7 +801,7 @@ static void do_DrawStringYUY2(const int width, const int height, BYTE* _dstp, in
       {
         num = s[i + 1];
         if (useHalocolor) {
-          bmfont->generateOutline(current_outlined_char.data(), num);
+          current_outlined_char = bmfont->outline(num);
           fontoutline = current_outlined_char[ty]; // shift some pixels if leftmost is chopped
         }
         fontline = fonts[num * FONT_HEIGHT + ty];
@@ -811,7 +825,7 @@ static void do_DrawStringPackedRGB(const int width, const int height, BYTE* _dst
   };
 
 
-  std::vector<uint16_t> current_outlined_char(bmfont->height);
+  const uint16_t* current_outlined_char = nullptr; // precomputed halo rows of the current glyph
   const uint16_t* fonts = bmfont->font_bitmaps.data();
   const int FONT_WIDTH = bmfont->width;
   const int FONT_HEIGHT = bmfont->height;
@@ -853,7 +867,7 @@ static void do_DrawStringPackedRGB(const int width, const int height, BYTE* _dst
     fontline = fonts[num * FONT_HEIGHT + ty] << xstart; // shift some pixels if leftmost is chopped
 
     if (useHalocolor) {
-      bmfont->generateOutline(current_outlined_char.data(), num); // on the fly, can be
+      current_outlined_char = bmfont->outline(num);
       fontoutline = current_outlined_char[ty] << xstart; // shift some pixels if leftmost is chopped
     }
 
@@ -879,7 +893,7 @@ static void do_DrawStringPackedRGB(const int width, const int height, BYTE* _dst
       {
         num = s[i + 1];
         if (useHalocolor) {
-          bmfont->generateOutline(current_outlined_char.data(), num);
+          current_outlined_char = bmfont->outline(num);
           fontoutline = current_outlined_char[ty]; // shift some pixels if leftmost is chopped
         }
         fontline = fonts[num * FONT_HEIGHT + ty];
@@ -970,11 +984,9 @@ std::unique_ptr<BitmapFont> GetBitmapFont(int size, const char *name, bool bold,
   return std::unique_ptr<BitmapFont>(current_font);
 }
 
-static void DrawString_internal(BitmapFont *current_font, const VideoInfo& vi, PVideoFrame& dst, int x, int y, std::wstring &s16, int color, int halocolor, bool useHalocolor, int align, bool fadeBackground)
+// s_remapped: array of font table indexes
+static void DrawString_internal(const BitmapFont *current_font, const VideoInfo& vi, PVideoFrame& dst, int x, int y, std::vector<int>& s_remapped, int color, int halocolor, bool useHalocolor, int align, bool fadeBackground)
 {
-  // map unicode to character map index
-  auto s_remapped = current_font->remap(s16); // array of font table indexes
-
   const bool isRGB = vi.IsRGB();
   const int planes_y[4] = { PLANAR_Y, PLANAR_U, PLANAR_V, PLANAR_A };
   const int planes_r[4] = { PLANAR_G, PLANAR_B, PLANAR_R, PLANAR_A };
@@ -1089,6 +1101,13 @@ static void DrawString_internal(BitmapFont *current_font, const VideoInfo& vi, P
   }
 }
 
+static void DrawString_internal(const BitmapFont *current_font, const VideoInfo& vi, PVideoFrame& dst, int x, int y, std::wstring &s16, int color, int halocolor, bool useHalocolor, int align, bool fadeBackground)
+{
+  // map unicode to character map index
+  auto s_remapped = current_font->remap(s16);
+  DrawString_internal(current_font, vi, dst, x, y, s_remapped, color, halocolor, useHalocolor, align, fadeBackground);
+}
+
 void SimpleTextOutW(BitmapFont *current_font, const VideoInfo& vi, PVideoFrame& frame, int real_x, int real_y, std::wstring& text, bool fadeBackground, int textcolor, int halocolor, bool useHaloColor, int align)
 {
   DrawString_internal(current_font, vi, frame, real_x, real_y, text, textcolor, halocolor, useHaloColor, align, fadeBackground); // fully transparent background
@@ -1134,16 +1153,22 @@ void DrawStringPlanar(VideoInfo& vi, PVideoFrame& dst, int x, int y, const char*
 
   // fadeBackground = true: background letter area is faded instead not being untouched.
 
-  std::wstring ws = charToWstring(s, false);
-
   int halocolor = 0;
 
-  std::unique_ptr<BitmapFont> current_font = GetBitmapFont(20, "info_h", false, false); // 10x20
+  // built once, display=true draws dozens of lines per frame
+  static const std::unique_ptr<BitmapFont> current_font = GetBitmapFont(20, "info_h", false, false); // 10x20
 
   if (current_font == nullptr)
     return;
 
-  DrawString_internal(current_font.get(), vi, dst, x, y, ws,
+  // the display texts are plain ASCII, the conversion is only needed otherwise
+  thread_local std::vector<int> s_remapped;
+  if (!current_font->remapAscii(s, s_remapped)) {
+    std::wstring ws = charToWstring(s, false);
+    s_remapped = current_font->remap(ws);
+  }
+
+  DrawString_internal(current_font.get(), vi, dst, x, y, s_remapped,
     color,
     halocolor,
     false, // don't use halocolor
@@ -26,6 +26,7 @@
 #include <uchar.h>
 #endif
 #include <sstream>
+#include <memory>
 #include "internal.h"
 #include <unordered_map>
 #include <array>
@@ -44,7 +45,10 @@ public:
   const bool bold;
   std::vector<uint16_t> font_bitmaps;
 
+  std::vector<uint16_t> font_outlines; // halo rows of every glyph, same layout as font_bitmaps
+
   std::unordered_map<uint16_t, int> charReMap; // unicode code point vs. font image index
+  int asciiReMap[128]; // same for 0..127, without hashing
 
   BitmapFont(int _number_of_chars, const uint16_t* _src_font_bitmaps, const uint16_t* _codepoints, int _w, int _h, std::string _font_name, std::string _font_filename, bool _bold, bool debugSave) :
     number_of_chars(_number_of_chars),
@@ -61,10 +65,22 @@ public:
     for (int i = 0; i < _number_of_chars; i++) {
       charReMap[_codepoints[i]] = i;
     }
+
+    for (int c = 0; c < 128; c++) {
+      auto it = charReMap.find((uint16_t)c);
+      asciiReMap[c] = it != charReMap.end() ? it->second : 0; // empty neutral character (space)
+    }
+
+    font_outlines.resize(font_bitmaps.size());
+    for (int i = 0; i < number_of_chars; i++)
+      generateOutline(&font_outlines[height * i], i);
   }
 
   // helper function for remapping a wchar_t string to font index entry list
-  std::vector<int> remap(const std::wstring& s16);
+  std::vector<int> remap(const std::wstring& s16) const;
+  bool remapAscii(const char* s, std::vector<int>& s_remapped) const;
+
+  const uint16_t* outline(int fontindex) const { return &font_outlines[height * fontindex]; }
 
   // generate outline on-the-fly
   void generateOutline(uint16_t* outlined, int fontindex) const;
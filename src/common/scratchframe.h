@@ -0,0 +1,68 @@
+/*
+**   Helper methods for TIVTC and TDeint
+**
+**
+**   Copyright (C) 2004-2007 Kevin Stone, additional work (C) 2020 pinterf
+**
+**   This program is free software; you can redistribute it and/or modify
+**   it under the terms of the GNU General Public License as published by
+**   the Free Software Foundation; either version 2 of the License, or
+**   (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**   but WITHOUT ANY WARRANTY; without even the implied warranty of
+**   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**   GNU General Public License for more details.
+**
+**   You should have received a copy of the GNU General Public License
+**   along with this program; if not, write to the Free Software
+**   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __SCRATCHFRAME_H__
+#define __SCRATCHFRAME_H__
+
+#include "internal.h"
+
+// Internal work frame kept by a filter instance. It comes from the frame pool
+// once and is reused on every GetFrame instead of a NewVideoFrame per call.
+// The filters are MT_SERIALIZED or run one instance per thread, so an
+// instance never uses it from two threads at a time.
+//
+// get(): the frame stays with the instance, bind it by reference. A copy
+// that is alive while writing makes it non-writable, copies must not
+// outlive the call.
+// take()/give(): the caller owns it in between, like a fresh frame. If it
+// is not given back (or is still referenced elsewhere) a new one is made.
+class ScratchFrame {
+  PVideoFrame frame;
+  int width = 0, height = 0, pixel_type = 0;
+
+public:
+  PVideoFrame& get(const VideoInfo& vi, IScriptEnvironment* env)
+  {
+    if (!frame || !frame->IsWritable() ||
+      width != vi.width || height != vi.height || pixel_type != vi.pixel_type)
+    {
+      frame = env->NewVideoFrame(vi);
+      width = vi.width;
+      height = vi.height;
+      pixel_type = vi.pixel_type;
+    }
+    return frame;
+  }
+
+  PVideoFrame take(const VideoInfo& vi, IScriptEnvironment* env)
+  {
+    PVideoFrame f = get(vi, env);
+    frame = nullptr;
+    return f;
+  }
+
+  void give(const PVideoFrame& f)
+  {
+    frame = f;
+  }
+};
+
+#endif // __SCRATCHFRAME_H__